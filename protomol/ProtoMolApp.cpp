@@ -32,6 +32,7 @@
 #include <protomol/analysis/AnalysisCollection.h>
 
 #include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/DomainDecomposition.h>
 
 #include <iomanip>
 #ifdef HAVE_PACKAGE_H
@@ -458,6 +459,12 @@ bool ProtoMolApp::step(long inc) {
 
   TimerStatistic::timer[TimerStatistic::RUN].start();
 
+  // Outputs need all atoms, which are spread over the nodes with
+  // domain decomposition
+  if (Parallel::isDomain())
+    DomainDecomposition::gather(&positions, &velocities,
+                                integrator->getForces());
+
   if (outputs->run(currentStep)) {
 #ifdef HAVE_LIBFAH
     // Make sure we save the latest checksum information after writing data.
@@ -475,6 +482,13 @@ bool ProtoMolApp::step(long inc) {
     inc = std::min(lastStep, currentStep + inc) - currentStep;
   }
 
+  // Only the master has outputs, all nodes must stop for the gathering
+  if (Parallel::isDomain()) {
+    int n = inc;
+    Parallel::bcast(n);
+    inc = n;
+  }
+
   TimerStatistic::timer[TimerStatistic::INTEGRATOR].start();
 
   const long completed = integrator->run(inc);
@@ -503,6 +517,10 @@ void ProtoMolApp::finalize() {
   report.setf( std::ios::fixed );
   report << plain << "Performance: " << nanoSeconds << "ns in " << TimerStatistic::timer[TimerStatistic::RUN].getTime().getRealTime() << "s = " << nanoSecondsPerDay << "ns/day" << std::endl;
 
+  if (Parallel::isDomain())
+    DomainDecomposition::gather(&positions, &velocities,
+                                integrator->getForces());
+
   outputs->finalize(currentStep);
   analysis->finalize(currentStep);
 
@@ -6,6 +6,7 @@
 #include <protomol/type/ScalarStructure.h>
 #include <protomol/topology/ExclusionTable.h>
 #include <protomol/config/Parameter.h>
+#include <protomol/force/ThreadSafeForce.h>
 #include <string>
 
 namespace ProtoMol {
@@ -77,5 +78,10 @@ namespace ProtoMol {
     static const std::string keyword;
   private:
   };
+
+  template<>
+  struct ThreadSafeForce<CoulombForce> {
+    enum {VALUE = 1};
+  };
 }
 #endif /* COULOMBFORCE_H */
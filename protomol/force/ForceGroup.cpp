@@ -10,6 +10,7 @@
 #include <protomol/base/TimerStatistic.h>
 #include <protomol/ProtoMolApp.h>
 #include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/DomainDecomposition.h>
 
 //____#define DEBUG_OUTSTANDING_MSG
 
@@ -55,6 +56,8 @@ void ForceGroup::evaluateSystemForces(ProtoMolApp *app,
                                       Vector3DBlock *forces) const {
 	if (mySystemForcesList.empty()) return;
 	app->topology->uncacheCellList();
+	// Convert once here, the forces read the copy from parallel regions.
+	app->topology->updatePositionsSoA(&app->positions);
 
   //not parallel forces?~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   if( !Parallel::isParallel() ){
@@ -74,6 +77,21 @@ void ForceGroup::evaluateSystemForces(ProtoMolApp *app,
   }else{
     //parallel code here~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   
+    if (Parallel::isDomain()) {
+      // Halo large enough for all forces of the group
+      Real halo = 0.0;
+      list<SystemForce *>::const_iterator currentForce;
+      for (currentForce = mySystemForcesList.begin(); currentForce != mySystemForcesList.end(); ++currentForce) {
+        const Real h = (*currentForce)->getDomainHalo(app->topology, &app->positions);
+        if (h < 0.0)
+          report << error << "Force " << (*currentForce)->getId()
+                 << " does not support domain decomposition." << endr;
+        halo = max(halo, h);
+      }
+      DomainDecomposition::exchange(app, halo);
+      app->topology->updatePositionsSoA(&app->positions);
+    }
+
     Parallel::distribute(&app->energies, forces);
     
     //find forces that require post-parallel processing
@@ -164,7 +182,12 @@ void ForceGroup::evaluateSystemForces(ProtoMolApp *app,
 void ForceGroup::evaluateExtendedForces(ProtoMolApp *app, Vector3DBlock *forces) const {
   if (myExtendedForcesList.empty()) return;
 
+  if (Parallel::isDomain())
+    report << error << "Extended forces do not support domain "
+           << "decomposition." << endr;
+
   app->topology->uncacheCellList();
+  app->topology->updatePositionsSoA(&app->positions);
 
   Parallel::distribute(&app->energies, forces);
 
@@ -222,6 +245,7 @@ const {
     return;
 
   topo->uncacheCellList();
+  topo->updatePositionsSoA(positions);
 
   TimerStatistic::timer[TimerStatistic::FORCES].start();
 
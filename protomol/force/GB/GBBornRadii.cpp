@@ -1,6 +1,7 @@
 #include <protomol/force/GB/GBBornRadii.h>
 
 #include <protomol/base/Report.h>
+#include <protomol/base/Exception.h>
 #include <protomol/parallel/Parallel.h>
 
 using namespace ProtoMol;
@@ -8,7 +9,16 @@ using namespace ProtoMol::Report;
 
 const string GBBornRadii::keyword("GBBornRadii");
 
-GBBornRadii::GBBornRadii(){
+GBBornRadii::GBBornRadii() :
+  myRefresh(1), myMaxDisplacement(0.0), myCount(0), myRefreshRadii(true),
+  myDisplacement(0.0), myRefreshDisplacement(0.0), mySensitivity(0.0) {
+
+}
+
+GBBornRadii::GBBornRadii(unsigned int refresh, Real maxDisplacement) :
+  myRefresh(refresh), myMaxDisplacement(maxDisplacement), myCount(0),
+  myRefreshRadii(true), myDisplacement(0.0), myRefreshDisplacement(0.0),
+  mySensitivity(0.0) {
 
 }
 
@@ -29,6 +39,10 @@ void GBBornRadii::operator()(Real &energy, Real &force,
   
   force = 0;
   
+  // The burial terms of the last refresh are kept
+  if (!myRefreshRadii)
+    return;
+  
   // If either molecule belongs to a water, do nothing.
   // Won't happen in most simulations, but could in the 
   // case of comparing forces.
@@ -39,10 +53,6 @@ void GBBornRadii::operator()(Real &energy, Real &force,
   //r_ij
   Real dist = sqrt(distSquared);
   
-  //store pairwise distances in some data structure for future use
-  topo->atoms[atom1].myGBSA_T->distij[atom2] = dist;
-  topo->atoms[atom2].myGBSA_T->distij[atom1] = dist;
-  
   Real radius_i = topo->atoms[atom1].myGBSA_T->vanDerWaalRadius;
   Real radius_j = topo->atoms[atom2].myGBSA_T->vanDerWaalRadius;
   
@@ -73,11 +83,6 @@ void GBBornRadii::operator()(Real &energy, Real &force,
     Cij = 0;
   }
   
-  //store Lvalues Uvalues in an array so that we can use later
-  topo->atoms[atom1].myGBSA_T->Lvalues[atom2] = Lij;
-  topo->atoms[atom1].myGBSA_T->Uvalues[atom2] = Uij;
-  
-  
   Real invLij = one/Lij;
   Real invUij = one/Uij;
   
@@ -103,10 +108,6 @@ void GBBornRadii::operator()(Real &energy, Real &force,
     Uji = dist + S_i*offsetRadius_i;
   }
   
-  //Store calculated L and U values
-  topo->atoms[atom2].myGBSA_T->Lvalues[atom1] = Lji;
-  topo->atoms[atom2].myGBSA_T->Uvalues[atom1] = Uji;
-  
   if (offsetRadius_j < offsetRadius_i*S_i - dist) {
     Cji = two*(one/offsetRadius_j - one/Lji);
     
@@ -138,13 +139,53 @@ Real GBBornRadii::getEnergy(const ScalarStructure *energies) {
 //now initialize GB structs here
 void GBBornRadii::preProcess(const GenericTopology *apptopo, const Vector3DBlock *positions) {
   const unsigned int atoms = apptopo->atoms.size();
+  
+  //~~~~refresh on the interval, when an atom moved too far or the system changed~~~~
+  const bool cached = (myRefresh > 1 || myMaxDisplacement > 0.0);
+  bool refresh = (!cached || myRefPositions.size() != atoms);
+  myDisplacement = 0.0;
+  
+  if (!refresh) {
+    Real maxDistSquared = 0.0;
+    for(unsigned int i=0;i<atoms;i++){
+      Real distSquared = apptopo->minimalDifference(myRefPositions[i], (*positions)[i]).normSquared();
+      if (distSquared > maxDistSquared)
+        maxDistSquared = distSquared;
+    }
+    myDisplacement = sqrt(maxDistSquared);
+    
+    refresh = (++myCount >= myRefresh ||
+               (myMaxDisplacement > 0.0 && myDisplacement > myMaxDisplacement));
+  }
+  
+  // Keep the displacement of this refresh, to relate it to the change of
+  // the radii in postProcess()
+  if (refresh && cached) {
+    myRefreshDisplacement = myDisplacement;
+    myRefPositions = *positions;
+    myCount = 0;
+  }
+  myRefreshRadii = refresh;
+  
   for(unsigned int i=0;i<atoms;i++)
-    apptopo->atoms[i].myGBSA_T->preForce();
+    if (refresh)
+      apptopo->atoms[i].myGBSA_T->preForce();
+    else
+      apptopo->atoms[i].myGBSA_T->preForceKeepRadius();
 }
 
 void GBBornRadii::postProcess(const GenericTopology *topo, ScalarStructure *energies, Vector3DBlock *forces) {
   const unsigned int atomnumber = topo->atoms.size();
   
+  //~~~~cached radii, estimate the error from the displacement since the refresh~~~~
+  if (!myRefreshRadii) {
+    if (energies)
+      (*energies)[ScalarStructure::BORNRADIUS_ERROR] = mySensitivity*myDisplacement;
+    return;
+  }
+  
+  Real maxChange = 0.0;
+  
   //~~~~calculate born radius from burial term~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   for(unsigned int i=0; i<atomnumber; i++){
     Real radius_i = topo->atoms[i].myGBSA_T->vanDerWaalRadius;
@@ -167,12 +208,32 @@ void GBBornRadii::postProcess(const GenericTopology *topo, ScalarStructure *ener
     tanhparam_i = topo->alphaObc*psi_i - topo->betaObc*psi_i*psi_i + topo->gammaObc*psi_i*psi_i*psi_i;
     //Second part of Equation (1)
     Real invBornRad_i = (1/offsetRadius_i) - (1/radius_i)*tanh(tanhparam_i);
+    
+    // Relative change of the radius since the last refresh
+    if (myRefreshDisplacement > 0.0) {
+      Real change = fabs(1 - topo->atoms[i].myGBSA_T->bornRad*invBornRad_i);
+      if (change > maxChange)
+        maxChange = change;
+    }
+    
     topo->atoms[i].myGBSA_T->bornRad = 1/invBornRad_i;
     topo->atoms[i].myGBSA_T->doneCalculateBornRadius = true;
   }
+  
+  // Largest relative change of a radius per displacement, to scale the error
+  // of the cached radii until the next refresh
+  if (myRefreshDisplacement > 0.0)
+    mySensitivity = maxChange/myRefreshDisplacement;
+  
+  if (energies)
+    (*energies)[ScalarStructure::BORNRADIUS_ERROR] = 0.0;
 }
 
 void GBBornRadii::parallelPostProcess(const GenericTopology *topo, ScalarStructure *energies) {
+  // The cached burial terms are already summed
+  if (!myRefreshRadii)
+    return;
+  
   const unsigned int atomnumber = topo->atoms.size();
   
   // Copy Radii
@@ -204,13 +265,23 @@ std::string GBBornRadii::getId() {
 }
 
 unsigned int GBBornRadii::getParameterSize() {
-  return 0;
+  return 2;
 }
 
-void GBBornRadii::getParameters(std::vector<Parameter> &) const {
-
+void GBBornRadii::getParameters(std::vector<Parameter> &parameters) const {
+  parameters.push_back
+    (Parameter("-refresh", Value(myRefresh, ConstraintValueType::Positive()), 1,
+               Text("evaluations between Born radii refreshes")));
+  parameters.push_back
+    (Parameter("-maxDisplacement", Value(myMaxDisplacement, ConstraintValueType::NotNegative()), 0.0,
+               Text("refresh the Born radii when an atom moved further [AA], 0 off")));
 }
 
-GBBornRadii GBBornRadii::make(const std::vector<Value> &) {
-  return GBBornRadii();
+GBBornRadii GBBornRadii::make(const std::vector<Value> &values) {
+  unsigned int refresh;
+  values[0].get(refresh);
+  if (!(values[0].valid()) || refresh == 0)
+    THROW(keyword + " : 0 < refresh (=" + values[0].getString() + ").");
+  
+  return GBBornRadii(refresh, values[1]);
 }
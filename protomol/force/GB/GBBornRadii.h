@@ -5,6 +5,7 @@
 #include <string>
 
 #include <protomol/type/ScalarStructure.h>
+#include <protomol/type/Vector3DBlock.h>
 #include <protomol/topology/ExclusionTable.h>
 #include <protomol/topology/GenericTopology.h>
 
@@ -15,6 +16,7 @@ namespace ProtoMol {
       enum {CUTOFF = 0};
     public:
       GBBornRadii();
+      GBBornRadii(unsigned int refresh, Real maxDisplacement);
       void operator()(Real &energy, Real &force, Real distSquared, Real rDistSquared, 
                       const Vector3D &diff, const GenericTopology *topo, int atom1, 
                       int atom2, ExclusionClass excl) const;
@@ -22,9 +24,11 @@ namespace ProtoMol {
       static void accumulateEnergy(ScalarStructure *energies, Real energy);
       static Real getEnergy(const ScalarStructure *energies);
       
-      static void preProcess(const GenericTopology *apptopo, const Vector3DBlock *positions);
-      static void postProcess(const GenericTopology *topo, ScalarStructure *energies, Vector3DBlock *forces);
-      static void parallelPostProcess(const GenericTopology *topo, ScalarStructure *energies);
+      // Decide if the Born radii are refreshed in this evaluation, else the
+      // radii and PsiValue of the last refresh are kept
+      void preProcess(const GenericTopology *apptopo, const Vector3DBlock *positions);
+      void postProcess(const GenericTopology *topo, ScalarStructure *energies, Vector3DBlock *forces);
+      void parallelPostProcess(const GenericTopology *topo, ScalarStructure *energies);
       static bool doParallelPostProcess();
       
       // Parsing
@@ -35,6 +39,15 @@ namespace ProtoMol {
       static GBBornRadii make(const std::vector<Value> &);
     public:
       static const std::string keyword;
+    private:
+      unsigned int myRefresh;      // Evaluations between refreshes
+      Real myMaxDisplacement;      // Refresh when an atom moved further, 0 off
+      unsigned int myCount;        // Evaluations since the last refresh
+      bool myRefreshRadii;         // Refresh in this evaluation
+      Real myDisplacement;         // Largest displacement since the last refresh
+      Real myRefreshDisplacement;  // Largest displacement at the last refresh
+      Real mySensitivity;          // Largest change of a radius by displacement
+      Vector3DBlock myRefPositions;  // Positions of the last refresh
   };
 }
 
@@ -8,8 +8,8 @@ using namespace ProtoMol::Report;
 
 const string GBForce::keyword("GBForce");
 
-GBForce::GBForce() : soluteDielec(1.0), solventDielec(80.0) {}
-GBForce::GBForce(Real solute_d, Real solvent_d) : soluteDielec(solute_d), solventDielec(solvent_d) {}
+GBForce::GBForce() : soluteDielec(1.0), solventDielec(80.0), myPositions(0) {}
+GBForce::GBForce(Real solute_d, Real solvent_d) : soluteDielec(solute_d), solventDielec(solvent_d), myPositions(0) {}
 
 void GBForce::operator()(Real &energy, Real &force, Real distSquared,
                 Real rDistSquared, const Vector3D &,
@@ -42,9 +42,9 @@ void GBForce::operator()(Real &energy, Real &force, Real distSquared,
   bornRad_i = topo->atoms[atom1].myGBSA_T->bornRad;
   bornRad_j = topo->atoms[atom2].myGBSA_T->bornRad;
   
-  //Equation (17)
-  Real expterm = topo->atoms[atom1].myGBSA_T->expTerm[atom2]; //std::exp( -(dist*dist)/(4*bornRad_i*bornRad_j) );
-  Real fGB = topo->atoms[atom1].myGBSA_T->filTerm[atom2];//sqrt(dist*dist + bornRad_i*bornRad_j*expterm);
+  //Equation (17), recomputed as in GBPartialSum rather than stored per pair
+  Real expterm = std::exp( -(dist*dist)/(4.0*bornRad_i*bornRad_j) );
+  Real fGB = sqrt(dist*dist + bornRad_i*bornRad_j*expterm);
   
   Real scaledCharge_i = topo->atoms[atom1].scaledCharge;
   Real scaledCharge_j = topo->atoms[atom2].scaledCharge;
@@ -158,7 +158,7 @@ void GBForce::operator()(Real &energy, Real &force, Real distSquared,
     topo->atoms[atom1].myGBSA_T->havePartialGBForceTerms = true;
   }
   
-  force -= (topo->atoms[atom1].myGBSA_T->partialGBForceTerms - topo->atoms[atom1].myGBSA_T->partialTerm[atom2]) *(dRidrij/dist);
+  force -= (topo->atoms[atom1].myGBSA_T->partialGBForceTerms - Force_i_j_term(topo, atom1, atom2, dist)) *(dRidrij/dist);
   
   if (!topo->atoms[atom2].myGBSA_T->havePartialGBForceTerms) {
     //if here we should not be //lel
@@ -168,7 +168,7 @@ void GBForce::operator()(Real &energy, Real &force, Real distSquared,
     topo->atoms[atom2].myGBSA_T->havePartialGBForceTerms = true;
   }
   
-  force -= (topo->atoms[atom2].myGBSA_T->partialGBForceTerms - topo->atoms[atom2].myGBSA_T->partialTerm[atom1])*(dRjdrji/dist);
+  force -= (topo->atoms[atom2].myGBSA_T->partialGBForceTerms - Force_i_j_term(topo, atom2, atom1, dist))*(dRjdrji/dist);
   //end
   
   force *= ((1/soluteDielec) - (1/solventDielec));
@@ -178,21 +178,15 @@ void GBForce::operator()(Real &energy, Real &force, Real distSquared,
 //estimate the force term for the sum over k,l where k=i,j and l {\neq} j if 
 //k=i and l {\neq}i if k=j
 Real GBForce::Force_i_term(const GenericTopology *topo, int atom1) const{
-  Real bornRad_i = topo->atoms[atom1].myGBSA_T->bornRad;
-  Real scaledCharge_i = topo->atoms[atom1].scaledCharge;
+  const Vector3D &position_i = (*myPositions)[atom1];
   
   Real force = 0;
   for (unsigned int l = 0; l < topo->atoms.size(); l++) {
     if( l != (unsigned int) atom1 ){
-      Real ril = topo->atoms[atom1].myGBSA_T->distij[l];
-    
-      Real bornRad_l = topo->atoms[l].myGBSA_T->bornRad;
-      Real scaledCharge_l = topo->atoms[l].scaledCharge;
-    
-      Real expterm = std::exp( -(ril*ril)/(4.0*bornRad_i*bornRad_l) );
-      Real filGB = sqrt(ril*ril + bornRad_i*bornRad_l*expterm);
+      //r_{il} from the positions of preProcess, distances are not stored
+      Real ril = sqrt(topo->minimalDifference(position_i, (*myPositions)[l]).normSquared());
       
-      force += scaledCharge_i*scaledCharge_l*(1/(filGB*filGB))*0.5*(1/filGB)*expterm*(bornRad_l + (ril*ril)/(4.0*bornRad_i));
+      force += Force_i_j_term(topo, atom1, l, ril);
     }
   }
   
@@ -227,6 +221,10 @@ Real GBForce::getEnergy(const ScalarStructure *energies) {
   return (*energies)[ScalarStructure::COULOMB];
 }
 
+void GBForce::preProcess(const GenericTopology * /*apptopo*/, const Vector3DBlock *positions) {
+  myPositions = positions;
+}
+
 void GBForce::postProcess(const GenericTopology *topo, ScalarStructure *energies, Vector3DBlock *forces) {
   
   const unsigned int atoms = topo->atoms.size();
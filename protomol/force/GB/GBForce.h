@@ -24,7 +24,8 @@ namespace ProtoMol {
       static void accumulateEnergy(ScalarStructure *energies, Real energy);
       static Real getEnergy(const ScalarStructure *energies);
     
-    static void preProcess(const GenericTopology *apptopo, const Vector3DBlock *positions){};
+      // Keeps the positions for Force_i_term() when GBPartialSum is not used
+      void preProcess(const GenericTopology *apptopo, const Vector3DBlock *positions);
       static void postProcess(const GenericTopology *topo, ScalarStructure *energies, Vector3DBlock *forces);
       static void parallelPostProcess(const GenericTopology *topo, ScalarStructure *energies);
 
@@ -44,6 +45,7 @@ namespace ProtoMol {
     private:
       Real soluteDielec;
       Real solventDielec;
+      const Vector3DBlock *myPositions;
    };
 }
 
@@ -0,0 +1,417 @@
+/* -*- c++ -*- */
+#ifndef GBOBCSYSTEMFORCE_H
+#define GBOBCSYSTEMFORCE_H
+
+#include <protomol/force/system/SystemForce.h>
+#include <protomol/force/GB/GBOBCSystemForceBase.h>
+#include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
+#include <protomol/topology/SemiGenericTopology.h>
+#include <protomol/type/ScalarStructure.h>
+#include <protomol/type/SimpleTypes.h>
+#include <protomol/base/Report.h>
+#include <protomol/base/MathUtilities.h>
+
+#include <vector>
+#include <cmath>
+
+namespace ProtoMol {
+  //____ GBOBCSystemForce
+
+  /**
+   * Generalized Born (OBC) solvation in one force, the terms of
+   * GBBornRadii, GBPartialSum, GBForce and, optionally, GBACEForce. The
+   * pairs are traversed in three passes over the same pair list: the
+   * burial terms, which give the Born radii, the sums of the derivatives
+   * of the pair energies by the Born radii and the forces, with the
+   * chain rule through the Born radii folded into one coefficient per
+   * atom. All per atom data are kept in arrays of this force, not in the
+   * GB parameters of the atoms.
+   *
+   * Without a cutoff all pairs are visited, else the pairs within the
+   * cutoff are collected once from the cell lists at each evaluation.
+   * With OpenMP the passes are threaded, each thread adding into its own
+   * buffers, which are reduced at the end of a pass.
+   */
+  template<class TBoundaryConditions>
+  class GBOBCSystemForce : public SystemForce, private GBOBCSystemForceBase {
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Typedef
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    typedef SemiGenericTopology<TBoundaryConditions> RealTopologyType;
+
+    enum Pass {BORN_RADII, PARTIAL_SUM, FORCE};
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    GBOBCSystemForce() :
+      SystemForce(), mySoluteDielec(1.0), mySolventDielec(80.0), myACE(true),
+      mySigma(defaultSigma), myRhoS(1.4), myCutoff(0.0), myTopo(0),
+      myPositions(0) {}
+
+    GBOBCSystemForce(Real soluteDielec, Real solventDielec, bool ace,
+                     Real sigma, Real rhoS, Real cutoff) :
+      SystemForce(), mySoluteDielec(soluteDielec),
+      mySolventDielec(solventDielec), myACE(ace), mySigma(sigma),
+      myRhoS(rhoS), myCutoff(cutoff), myTopo(0), myPositions(0) {}
+
+    virtual ~GBOBCSystemForce() {}
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class SystemForce
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    using SystemForce::evaluate; // Avoid compiler warning/error
+    virtual void evaluate(const GenericTopology *topo,
+                          const Vector3DBlock *positions,
+                          Vector3DBlock *forces, ScalarStructure *energies) {
+      if (!topo->doGBSAOpenMM)
+        report << error << keyword << " requires GB parameters." << endr;
+
+      myTopo = (const RealTopologyType *)topo;
+      myPositions = positions;
+      const unsigned int n = topo->atoms.size();
+      const int threads = ThreadForceBuffers::getNumThreads();
+
+      if (myCutoff > 0.0)
+        topo->getCutoffPairs(*positions, myCutoff, myPairs);
+      initializeAtoms();
+
+      // Born radii
+      mySums.assign(threads * n, 0.0);
+      doPass<BORN_RADII>(threads);
+      reduceSums(threads, myBurial);
+      bornRadii();
+
+      // Derivatives of the pair energies by the Born radii
+      mySums.assign(threads * n, 0.0);
+      doPass<PARTIAL_SUM>(threads);
+      reduceSums(threads, myPartial);
+      chainCoefficients(energies);
+
+      // Forces
+      if (threads > 1) {
+        myBuffers.initialize(threads, n, energies);
+        myThreadForces.resize(threads);
+        myThreadEnergies.resize(threads);
+        for (int t = 0; t < threads; t++) {
+          myThreadForces[t] = myBuffers.forces(t);
+          myThreadEnergies[t] = myBuffers.energies(t);
+        }
+      } else {
+        myThreadForces.assign(1, forces);
+        myThreadEnergies.assign(1, energies);
+      }
+      doPass<FORCE>(threads);
+      if (threads > 1)
+        myBuffers.reduce(forces, energies);
+    }
+
+    /// The passes need the complete sums of the previous pass, so the
+    /// force is evaluated as one block
+    virtual void parallelEvaluate(const GenericTopology *topo,
+                                  const Vector3DBlock *positions,
+                                  Vector3DBlock *forces,
+                                  ScalarStructure *energies) {
+      if (Parallel::next())
+        evaluate(topo, positions, forces, energies);
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class Force
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    virtual std::string getKeyword() const {return keyword;}
+
+  private:
+    virtual Force *doMake(const std::vector<Value> &values) const {
+      Real soluteDielec = values[0];
+      Real solventDielec = values[1];
+      bool ace = values[2];
+      Real sigma = values[3];
+      Real rhoS = values[4];
+      Real cutoff = values[5];
+
+      if (!values[5].valid())
+        report << error << "force " << keyword << " : cutoff \'"
+               << values[5].getString() << "\' not valid." << endr;
+
+      return new GBOBCSystemForce(soluteDielec, solventDielec, ace, sigma,
+                                  rhoS, cutoff);
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class Makeable
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    virtual std::string getIdNoAlias() const {return keyword;}
+
+    virtual void getParameters(std::vector<Parameter> &parameters) const {
+      parameters.push_back
+        (Parameter("-soluteDielec",
+                   Value(mySoluteDielec, ConstraintValueType::NoConstraints()),
+                   1.0, Text("Solute Dielectric")));
+      parameters.push_back
+        (Parameter("-solventDielec",
+                   Value(mySolventDielec,
+                         ConstraintValueType::NoConstraints()),
+                   80.0, Text("Solvent Dielectric")));
+      parameters.push_back
+        (Parameter("-ace", Value(myACE, ConstraintValueType::NoConstraints()),
+                   true, Text("ACE nonpolar term of GBACEForce")));
+      parameters.push_back
+        (Parameter("-solvationparam",
+                   Value(mySigma, ConstraintValueType::NoConstraints()),
+                   defaultSigma, Text("solvation parameter")));
+      parameters.push_back
+        (Parameter("-watersphereradius",
+                   Value(myRhoS, ConstraintValueType::NoConstraints()), 1.4,
+                   Text("solvation parameter")));
+      parameters.push_back
+        (Parameter("-cutoff",
+                   Value(myCutoff, ConstraintValueType::NotNegative()), 0.0,
+                   Text("pair cutoff, 0 for all pairs")));
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class GBOBCSystemForce
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    /// Copies the GB parameters of the atoms into the arrays
+    void initializeAtoms() {
+      const unsigned int n = myTopo->atoms.size();
+      myRadius.resize(n);
+      myOffsetRadius.resize(n);
+      myScaledRadius.resize(n);
+      myCharge.resize(n);
+      myWater.resize(n);
+
+      for (unsigned int i = 0; i < n; i++) {
+        const Atom &atom = myTopo->atoms[i];
+        myRadius[i] = atom.myGBSA_T->vanDerWaalRadius;
+        myOffsetRadius[i] = myRadius[i] - atom.myGBSA_T->offsetRadius;
+        myScaledRadius[i] = atom.myGBSA_T->scalingFactor * myOffsetRadius[i];
+        myCharge[i] = atom.scaledCharge;
+        myWater[i] = myTopo->molecules[atom.molecule].water;
+      }
+    }
+
+    /// Born radii from the burial terms, Equations (1), (3) and (5), and
+    /// their derivatives by the burial terms
+    void bornRadii() {
+      const unsigned int n = myTopo->atoms.size();
+      const Real alpha = myTopo->alphaObc;
+      const Real beta = myTopo->betaObc;
+      const Real gamma = myTopo->gammaObc;
+      myBornRadius.resize(n);
+      myBornDerivative.resize(n);
+
+      for (unsigned int i = 0; i < n; i++) {
+        const Real psi = 0.5 * myBurial[i] * myOffsetRadius[i];
+        const Real th = tanh(alpha * psi - beta * psi * psi +
+                             gamma * psi * psi * psi);
+        const Real bornRad =
+          1.0 / ((1.0 / myOffsetRadius[i]) - (1.0 / myRadius[i]) * th);
+
+        myBornRadius[i] = bornRad;
+        // Equation (9) without the derivative of the burial term
+        myBornDerivative[i] = bornRad * bornRad * myOffsetRadius[i] *
+          (1.0 - th * th) *
+          (alpha - 2.0 * beta * psi + 3.0 * gamma * psi * psi) / myRadius[i];
+      }
+    }
+
+    /**
+     * Self energies, Equation (18), and ACE energies, Equation (14). The
+     * derivative of the energy by the Born radius of each atom, times the
+     * derivative of the Born radius by the burial term, replaces
+     * myBornDerivative.
+     */
+    void chainCoefficients(ScalarStructure *energies) {
+      const unsigned int n = myTopo->atoms.size();
+      const Real tau = (1.0 / mySoluteDielec) - (1.0 / mySolventDielec);
+      Real energy = 0.0;
+
+      for (unsigned int i = 0; i < n; i++) {
+        const Real q = myCharge[i];
+        const Real bornRad = myBornRadius[i];
+        energy -= 0.5 * q * q * (1.0 / bornRad) * tau;
+        Real dEdR = tau * (myPartial[i] + 0.5 * q * q / (bornRad * bornRad));
+
+        if (myACE) {
+          const Real r = myRadius[i] + myRhoS;
+          const Real ratio = power<6>(myRadius[i] / bornRad);
+          energy += 4.0 * acePi * mySigma * r * r * ratio;
+          dEdR -= 24.0 * acePi * mySigma * r * r * ratio / bornRad;
+        }
+
+        myBornDerivative[i] *= dEdR;
+      }
+
+      (*energies)[ScalarStructure::COULOMB] += energy;
+    }
+
+    /// Visits all pairs of the list, or all pairs without cutoff
+    template<int PASS>
+    void doPass(int threads) {
+      const int n = static_cast<int>(myTopo->atoms.size());
+      const int pairs = static_cast<int>(myPairs.size());
+      const bool all = !(myCutoff > 0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+      {
+        const int t = ThreadForceBuffers::getThreadId();
+        Real *sums = &mySums[0] + t * n;
+
+        if (all) {
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 8)
+#endif
+          for (int i = 0; i < n; i++)
+            for (int j = i + 1; j < n; j++)
+              doPair<PASS>(t, i, j, sums);
+        } else {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+          for (int k = 0; k < pairs; k++)
+            doPair<PASS>(t, myPairs[k].first, myPairs[k].second, sums);
+        }
+      }
+    }
+
+    template<int PASS>
+    void doPair(int t, int i, int j, Real *sums) {
+      Real distSquared;
+      const Vector3D diff =
+        myTopo->boundaryConditions.minimalDifference((*myPositions)[i],
+                                                     (*myPositions)[j],
+                                                     distSquared);
+
+      if (PASS == BORN_RADII) {
+        // Waters do not take part in the burial terms
+        if (myWater[i] || myWater[j])
+          return;
+
+        const Real dist = sqrt(distSquared);
+        sums[i] += burialTerm(dist, myOffsetRadius[i], myScaledRadius[j]);
+        sums[j] += burialTerm(dist, myOffsetRadius[j], myScaledRadius[i]);
+
+      } else if (PASS == PARTIAL_SUM) {
+        const Real bornRad_i = myBornRadius[i];
+        const Real bornRad_j = myBornRadius[j];
+        const Real expterm =
+          exp(-distSquared / (4.0 * bornRad_i * bornRad_j));
+        const Real fGB = sqrt(distSquared + bornRad_i * bornRad_j * expterm);
+        const Real part =
+          myCharge[i] * myCharge[j] * 0.5 * expterm / (fGB * fGB * fGB);
+
+        sums[i] += part * (bornRad_j + distSquared / (4.0 * bornRad_i));
+        sums[j] += part * (bornRad_i + distSquared / (4.0 * bornRad_j));
+
+      } else {
+        const Real tau = (1.0 / mySoluteDielec) - (1.0 / mySolventDielec);
+        const Real dist = sqrt(distSquared);
+        const Real bornRad_i = myBornRadius[i];
+        const Real bornRad_j = myBornRadius[j];
+        const Real qq = myCharge[i] * myCharge[j];
+
+        // Equations (16-17)
+        const Real expterm =
+          exp(-distSquared / (4.0 * bornRad_i * bornRad_j));
+        const Real fGB = sqrt(distSquared + bornRad_i * bornRad_j * expterm);
+        const Real energy = -qq * (1.0 / fGB) * tau;
+
+        // Direct term and the terms through the Born radii of i and j,
+        // Equations (19-20)
+        const Real force = -tau * qq * (1.0 - 0.25 * expterm) /
+          (fGB * fGB * fGB) -
+          (myBornDerivative[i] *
+           burialDerivative(dist, myOffsetRadius[i], myScaledRadius[j]) +
+           myBornDerivative[j] *
+           burialDerivative(dist, myOffsetRadius[j], myScaledRadius[i])) /
+          dist;
+
+        const Vector3D fij(diff * force);
+        Vector3DBlock &forces = *myThreadForces[t];
+        ScalarStructure *energies = myThreadEnergies[t];
+        forces[i] -= fij;
+        forces[j] += fij;
+        (*energies)[ScalarStructure::COULOMB] += energy;
+
+        const int mi = myTopo->atoms[i].molecule;
+        const int mj = myTopo->atoms[j].molecule;
+        if (mi != mj && energies->molecularVirial())
+          energies->addVirial(fij, diff,
+                              myTopo->boundaryConditions.
+                              minimalDifference(myTopo->molecules[mi].position,
+                                                myTopo->molecules[mj].position));
+        else if (energies->virial())
+          energies->addVirial(fij, diff);
+      }
+    }
+
+    /// Sums the per thread sums of the atoms into sums
+    void reduceSums(int threads, std::vector<Real> &sums) {
+      const int n = static_cast<int>(myTopo->atoms.size());
+      sums.resize(n);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
+      for (int i = 0; i < n; i++) {
+        Real sum = 0.0;
+        for (int t = 0; t < threads; t++)
+          sum += mySums[t * n + i];
+        sums[i] = sum;
+      }
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    Real mySoluteDielec;
+    Real mySolventDielec;
+    bool myACE;
+    Real mySigma;             // ACE solvation parameter
+    Real myRhoS;              // ACE water sphere radius
+    Real myCutoff;
+
+    const RealTopologyType *myTopo;  // Of the evaluation in progress
+    const Vector3DBlock *myPositions;
+    std::vector<PairInt> myPairs;    // Pairs within the cutoff
+
+    std::vector<Real> myRadius;       // van der Waals radius
+    std::vector<Real> myOffsetRadius;
+    std::vector<Real> myScaledRadius; // Scaling factor times offset radius
+    std::vector<Real> myCharge;
+    std::vector<char> myWater;
+    std::vector<Real> myBurial;
+    std::vector<Real> myBornRadius;
+    std::vector<Real> myBornDerivative; // dR/dBT, then dE/dR dR/dBT
+    std::vector<Real> myPartial;        // GBPartialSum
+    std::vector<Real> mySums;           // Per thread sums of a pass
+
+    ThreadForceBuffers myBuffers;
+    std::vector<Vector3DBlock *> myThreadForces;
+    std::vector<ScalarStructure *> myThreadEnergies;
+
+    static const Real defaultSigma;
+    static const Real acePi;
+  };
+
+  template<class TBoundaryConditions>
+  const Real GBOBCSystemForce<TBoundaryConditions>::defaultSigma =
+    2.26 / 418.4; // kJ nm^{-2} -> kcal AA^{-2}
+
+  // The value of PI in GBACEForce, for the same ACE energies
+  template<class TBoundaryConditions>
+  const Real GBOBCSystemForce<TBoundaryConditions>::acePi = 3.14169;
+}
+#endif /* GBOBCSYSTEMFORCE_H */
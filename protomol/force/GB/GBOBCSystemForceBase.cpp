@@ -0,0 +1,57 @@
+#include <protomol/force/GB/GBOBCSystemForceBase.h>
+
+#include <cmath>
+
+using namespace std;
+
+namespace ProtoMol {
+  //____ GBOBCSystemForceBase
+
+  const string GBOBCSystemForceBase::keyword("GBOBC");
+
+  Real GBOBCSystemForceBase::burialTerm(Real dist, Real o_i, Real sj) {
+    // Atom j inside of atom i, L = U = 1 and the term vanishes
+    if (o_i >= dist + sj)
+      return 0.0;
+
+    const Real L = (o_i > fabs(dist - sj)) ? o_i : fabs(dist - sj);
+    const Real U = dist + sj;
+    const Real C = (o_i < sj - dist) ? 2.0 * (1.0 / o_i - 1.0 / L) : 0.0;
+
+    const Real invL = 1.0 / L;
+    const Real invU = 1.0 / U;
+    const Real invL2 = invL * invL;
+    const Real invU2 = invU * invU;
+
+    return (invL - invU) + (dist / 4.0) * (invU2 - invL2) +
+      (1.0 / (2.0 * dist)) * log(L / U) +
+      ((sj * sj) / (4.0 * dist)) * (invL2 - invU2) + C;
+  }
+
+  Real GBOBCSystemForceBase::burialDerivative(Real dist, Real o_i, Real sj) {
+    if (o_i >= dist + sj)
+      return 0.0;
+
+    const Real L = (o_i > fabs(dist - sj)) ? o_i : fabs(dist - sj);
+    const Real U = dist + sj;
+
+    // Equations (11-13)
+    const Real dL = (o_i <= dist - sj) ? 1.0 : 0.0;
+    const Real dU = (o_i < dist + sj) ? 1.0 : 0.0;
+
+    const Real invL = 1.0 / L;
+    const Real invU = 1.0 / U;
+    const Real invL2 = invL * invL;
+    const Real invU2 = invU * invU;
+    const Real dC = (o_i <= sj - dist) ? 2.0 * invL2 * dL : 0.0;
+    const Real sjr = sj / dist;
+
+    return -0.5 * dL * invL2 + 0.5 * dU * invU2 + 0.125 * (invU2 - invL2) +
+      0.125 * dist * (2.0 * invL2 * invL * dL - 2.0 * invU2 * invU * dU) -
+      0.25 * (1.0 / (dist * dist)) * log(L / U) +
+      (U / (4.0 * dist * L)) * (invU * dL - L * invU2 * dU) -
+      0.125 * sjr * sjr * (invL2 - invU2) +
+      0.25 * ((sj * sj) / dist) * invU2 * invU * dU -
+      0.25 * ((sj * sj) / dist) * invL2 * invL * dL + dC;
+  }
+}
@@ -0,0 +1,28 @@
+/*  -*- c++ -*-  */
+#ifndef GBOBCSYSTEMFORCEBASE_H
+#define GBOBCSYSTEMFORCEBASE_H
+
+#include <protomol/type/Real.h>
+
+#include <string>
+
+namespace ProtoMol {
+  //____ GBOBCSystemForceBase
+
+  /**
+   * Keyword and pair terms of GBOBCSystemForce, the same expressions as
+   * GBBornRadii and GBForce. The offset radii o_i, o_j and the scaled
+   * offset radius sj = S_j o_j of the partner are given by the caller.
+   */
+  class GBOBCSystemForceBase {
+  public:
+    /// Contribution of atom j to the burial term of atom i, Equation (5)
+    static Real burialTerm(Real dist, Real o_i, Real sj);
+    /// Derivative of burialTerm() by r_ij, Equation (10)
+    static Real burialDerivative(Real dist, Real o_i, Real sj);
+
+  public:
+    static const std::string keyword;
+  };
+}
+#endif /* GBOBCSYSTEMFORCEBASE_H */
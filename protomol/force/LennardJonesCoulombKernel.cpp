@@ -0,0 +1,690 @@
+#include <protomol/force/LennardJonesCoulombKernel.h>
+
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+  defined(USE_REAL_IS_DOUBLE)
+#ifdef USE_MIXED_PRECISION
+#define HAVE_X86_MIXED_KERNELS
+#else
+#define HAVE_X86_KERNELS
+#endif
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace ProtoMol;
+
+typedef LennardJonesCoulombKernel::Coefficients Coefficients;
+
+//____ Scalar
+
+// One pair, with the operations in the same order as LennardJonesForce,
+// CoulombForce and the switching functions, computed in T
+template<typename T>
+static inline void kernelPair(const Coefficients &c, T distSquared,
+                              T A, T B, T qq, T scale,
+                              Real &energyLJ, Real &energyCoulomb,
+                              Real &force) {
+  T rDistSquared = T(1.0) / distSquared;
+
+  // Lennard-Jones
+  T r6 = rDistSquared * rDistSquared * rDistSquared;
+  T r12 = r6 * r6;
+  T r6B = B * r6;
+  T r12A = A * r12;
+  T energy1 = r12A - r6B;
+  T force1 = T(12.0) * r12A * rDistSquared - T(6.0) * r6B * rDistSquared;
+
+  // Coulomb
+  T energy2 = qq * sqrt(rDistSquared) * scale;
+  T force2 = energy2 * rDistSquared;
+
+  // C2 switch
+  T value = 0.0, deriv = 0.0;
+  if (distSquared <= T(c.cutoff2)) {
+    if (distSquared >= T(c.switchon2)) {
+      T c2 = T(c.cutoff2) - distSquared;
+      T c4 = c2 * (T(c.switch2) + T(2.0) * distSquared);
+      value = T(c.switch1) * (c2 * c4);
+      deriv = T(c.switch3) * (c2 * c2 - c4);
+    } else
+      value = 1.0;
+  }
+  force1 = force1 * value - energy1 * deriv;
+  energy1 = energy1 * value;
+
+  // C1 switch
+  value = 0.0;
+  deriv = 0.0;
+  if (distSquared <= T(c.cCutoff2)) {
+    T dist = sqrt(distSquared);
+    value = T(1.0) - dist * (T(c.c15Cutoff_1) - distSquared * T(c.c05Cutoff_3));
+    deriv = dist * T(c.c15Cutoff_3) - T(c.c15Cutoff_1) / dist;
+  }
+  force2 = force2 * value - energy2 * deriv;
+  energy2 = energy2 * value;
+
+  energyLJ = energy1;
+  energyCoulomb = energy2;
+  force = force1 + force2;
+}
+
+static void kernelScalar(const Coefficients &c, unsigned int n,
+                         const Real *distSquared, const Real *A,
+                         const Real *B, const Real *qq, const Real *scale,
+                         Real *energyLJ, Real *energyCoulomb, Real *force) {
+  for (unsigned int k = 0; k < n; k++)
+    kernelPair<KernelReal>(c, distSquared[k], A[k], B[k], qq[k], scale[k],
+                     energyLJ[k], energyCoulomb[k], force[k]);
+}
+
+#ifdef HAVE_X86_KERNELS
+//____ SSE2
+
+__attribute__((target("sse2")))
+static void kernelSSE2(const Coefficients &c, unsigned int n,
+                       const Real *distSquared, const Real *A,
+                       const Real *B, const Real *qq, const Real *scale,
+                       Real *energyLJ, Real *energyCoulomb, Real *force) {
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d two = _mm_set1_pd(2.0);
+  const __m128d six = _mm_set1_pd(6.0);
+  const __m128d twelve = _mm_set1_pd(12.0);
+  const __m128d switchon2 = _mm_set1_pd(c.switchon2);
+  const __m128d cutoff2 = _mm_set1_pd(c.cutoff2);
+  const __m128d switch1 = _mm_set1_pd(c.switch1);
+  const __m128d switch2 = _mm_set1_pd(c.switch2);
+  const __m128d switch3 = _mm_set1_pd(c.switch3);
+  const __m128d cCutoff2 = _mm_set1_pd(c.cCutoff2);
+  const __m128d c15Cutoff_1 = _mm_set1_pd(c.c15Cutoff_1);
+  const __m128d c05Cutoff_3 = _mm_set1_pd(c.c05Cutoff_3);
+  const __m128d c15Cutoff_3 = _mm_set1_pd(c.c15Cutoff_3);
+
+  unsigned int k = 0;
+  for (; k + 2 <= n; k += 2) {
+    __m128d d2 = _mm_loadu_pd(distSquared + k);
+    __m128d r2 = _mm_div_pd(one, d2);
+
+    // Lennard-Jones
+    __m128d r6 = _mm_mul_pd(_mm_mul_pd(r2, r2), r2);
+    __m128d r12 = _mm_mul_pd(r6, r6);
+    __m128d r6B = _mm_mul_pd(_mm_loadu_pd(B + k), r6);
+    __m128d r12A = _mm_mul_pd(_mm_loadu_pd(A + k), r12);
+    __m128d energy1 = _mm_sub_pd(r12A, r6B);
+    __m128d force1 = _mm_sub_pd(_mm_mul_pd(_mm_mul_pd(twelve, r12A), r2),
+                                _mm_mul_pd(_mm_mul_pd(six, r6B), r2));
+
+    // Coulomb
+    __m128d energy2 = _mm_mul_pd(_mm_mul_pd(_mm_loadu_pd(qq + k),
+                                            _mm_sqrt_pd(r2)),
+                                 _mm_loadu_pd(scale + k));
+    __m128d force2 = _mm_mul_pd(energy2, r2);
+
+    // C2 switch
+    __m128d inCutoff = _mm_cmple_pd(d2, cutoff2);
+    __m128d inSwitch = _mm_and_pd(inCutoff, _mm_cmpge_pd(d2, switchon2));
+    __m128d c2 = _mm_sub_pd(cutoff2, d2);
+    __m128d c4 = _mm_mul_pd(c2, _mm_add_pd(switch2, _mm_mul_pd(two, d2)));
+    __m128d value =
+      _mm_or_pd(_mm_and_pd(inSwitch, _mm_mul_pd(switch1, _mm_mul_pd(c2, c4))),
+                _mm_andnot_pd(inSwitch, one));
+    value = _mm_and_pd(inCutoff, value);
+    __m128d deriv =
+      _mm_and_pd(inSwitch,
+                 _mm_mul_pd(switch3, _mm_sub_pd(_mm_mul_pd(c2, c2), c4)));
+    force1 = _mm_sub_pd(_mm_mul_pd(force1, value), _mm_mul_pd(energy1, deriv));
+    energy1 = _mm_mul_pd(energy1, value);
+
+    // C1 switch
+    inCutoff = _mm_cmple_pd(d2, cCutoff2);
+    __m128d dist = _mm_sqrt_pd(d2);
+    value = _mm_and_pd(inCutoff,
+                       _mm_sub_pd(one, _mm_mul_pd(dist,
+                                                  _mm_sub_pd(c15Cutoff_1,
+                                                             _mm_mul_pd(d2, c05Cutoff_3)))));
+    deriv = _mm_and_pd(inCutoff,
+                       _mm_sub_pd(_mm_mul_pd(dist, c15Cutoff_3),
+                                  _mm_div_pd(c15Cutoff_1, dist)));
+    force2 = _mm_sub_pd(_mm_mul_pd(force2, value), _mm_mul_pd(energy2, deriv));
+    energy2 = _mm_mul_pd(energy2, value);
+
+    _mm_storeu_pd(energyLJ + k, energy1);
+    _mm_storeu_pd(energyCoulomb + k, energy2);
+    _mm_storeu_pd(force + k, _mm_add_pd(force1, force2));
+  }
+
+  for (; k < n; k++)
+    kernelPair<Real>(c, distSquared[k], A[k], B[k], qq[k], scale[k],
+                     energyLJ[k], energyCoulomb[k], force[k]);
+}
+
+//____ AVX2
+
+__attribute__((target("avx2")))
+static void kernelAVX2(const Coefficients &c, unsigned int n,
+                       const Real *distSquared, const Real *A,
+                       const Real *B, const Real *qq, const Real *scale,
+                       Real *energyLJ, Real *energyCoulomb, Real *force) {
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d two = _mm256_set1_pd(2.0);
+  const __m256d six = _mm256_set1_pd(6.0);
+  const __m256d twelve = _mm256_set1_pd(12.0);
+  const __m256d switchon2 = _mm256_set1_pd(c.switchon2);
+  const __m256d cutoff2 = _mm256_set1_pd(c.cutoff2);
+  const __m256d switch1 = _mm256_set1_pd(c.switch1);
+  const __m256d switch2 = _mm256_set1_pd(c.switch2);
+  const __m256d switch3 = _mm256_set1_pd(c.switch3);
+  const __m256d cCutoff2 = _mm256_set1_pd(c.cCutoff2);
+  const __m256d c15Cutoff_1 = _mm256_set1_pd(c.c15Cutoff_1);
+  const __m256d c05Cutoff_3 = _mm256_set1_pd(c.c05Cutoff_3);
+  const __m256d c15Cutoff_3 = _mm256_set1_pd(c.c15Cutoff_3);
+
+  unsigned int k = 0;
+  for (; k + 4 <= n; k += 4) {
+    __m256d d2 = _mm256_loadu_pd(distSquared + k);
+    __m256d r2 = _mm256_div_pd(one, d2);
+
+    // Lennard-Jones
+    __m256d r6 = _mm256_mul_pd(_mm256_mul_pd(r2, r2), r2);
+    __m256d r12 = _mm256_mul_pd(r6, r6);
+    __m256d r6B = _mm256_mul_pd(_mm256_loadu_pd(B + k), r6);
+    __m256d r12A = _mm256_mul_pd(_mm256_loadu_pd(A + k), r12);
+    __m256d energy1 = _mm256_sub_pd(r12A, r6B);
+    __m256d force1 =
+      _mm256_sub_pd(_mm256_mul_pd(_mm256_mul_pd(twelve, r12A), r2),
+                    _mm256_mul_pd(_mm256_mul_pd(six, r6B), r2));
+
+    // Coulomb
+    __m256d energy2 =
+      _mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(qq + k), _mm256_sqrt_pd(r2)),
+                    _mm256_loadu_pd(scale + k));
+    __m256d force2 = _mm256_mul_pd(energy2, r2);
+
+    // C2 switch
+    __m256d inCutoff = _mm256_cmp_pd(d2, cutoff2, _CMP_LE_OQ);
+    __m256d inSwitch =
+      _mm256_and_pd(inCutoff, _mm256_cmp_pd(d2, switchon2, _CMP_GE_OQ));
+    __m256d c2 = _mm256_sub_pd(cutoff2, d2);
+    __m256d c4 =
+      _mm256_mul_pd(c2, _mm256_add_pd(switch2, _mm256_mul_pd(two, d2)));
+    __m256d value =
+      _mm256_blendv_pd(one, _mm256_mul_pd(switch1, _mm256_mul_pd(c2, c4)),
+                       inSwitch);
+    value = _mm256_and_pd(inCutoff, value);
+    __m256d deriv =
+      _mm256_and_pd(inSwitch,
+                    _mm256_mul_pd(switch3,
+                                  _mm256_sub_pd(_mm256_mul_pd(c2, c2), c4)));
+    force1 = _mm256_sub_pd(_mm256_mul_pd(force1, value),
+                           _mm256_mul_pd(energy1, deriv));
+    energy1 = _mm256_mul_pd(energy1, value);
+
+    // C1 switch
+    inCutoff = _mm256_cmp_pd(d2, cCutoff2, _CMP_LE_OQ);
+    __m256d dist = _mm256_sqrt_pd(d2);
+    value =
+      _mm256_and_pd(inCutoff,
+                    _mm256_sub_pd(one,
+                                  _mm256_mul_pd(dist,
+                                                _mm256_sub_pd(c15Cutoff_1,
+                                                              _mm256_mul_pd(d2, c05Cutoff_3)))));
+    deriv = _mm256_and_pd(inCutoff,
+                          _mm256_sub_pd(_mm256_mul_pd(dist, c15Cutoff_3),
+                                        _mm256_div_pd(c15Cutoff_1, dist)));
+    force2 = _mm256_sub_pd(_mm256_mul_pd(force2, value),
+                           _mm256_mul_pd(energy2, deriv));
+    energy2 = _mm256_mul_pd(energy2, value);
+
+    _mm256_storeu_pd(energyLJ + k, energy1);
+    _mm256_storeu_pd(energyCoulomb + k, energy2);
+    _mm256_storeu_pd(force + k, _mm256_add_pd(force1, force2));
+  }
+
+  for (; k < n; k++)
+    kernelPair<Real>(c, distSquared[k], A[k], B[k], qq[k], scale[k],
+                     energyLJ[k], energyCoulomb[k], force[k]);
+}
+
+//____ AVX-512
+
+__attribute__((target("avx512f")))
+static void kernelAVX512(const Coefficients &c, unsigned int n,
+                         const Real *distSquared, const Real *A,
+                         const Real *B, const Real *qq, const Real *scale,
+                         Real *energyLJ, Real *energyCoulomb, Real *force) {
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d two = _mm512_set1_pd(2.0);
+  const __m512d six = _mm512_set1_pd(6.0);
+  const __m512d twelve = _mm512_set1_pd(12.0);
+  const __m512d switchon2 = _mm512_set1_pd(c.switchon2);
+  const __m512d cutoff2 = _mm512_set1_pd(c.cutoff2);
+  const __m512d switch1 = _mm512_set1_pd(c.switch1);
+  const __m512d switch2 = _mm512_set1_pd(c.switch2);
+  const __m512d switch3 = _mm512_set1_pd(c.switch3);
+  const __m512d cCutoff2 = _mm512_set1_pd(c.cCutoff2);
+  const __m512d c15Cutoff_1 = _mm512_set1_pd(c.c15Cutoff_1);
+  const __m512d c05Cutoff_3 = _mm512_set1_pd(c.c05Cutoff_3);
+  const __m512d c15Cutoff_3 = _mm512_set1_pd(c.c15Cutoff_3);
+
+  unsigned int k = 0;
+  for (; k + 8 <= n; k += 8) {
+    __m512d d2 = _mm512_loadu_pd(distSquared + k);
+    __m512d r2 = _mm512_div_pd(one, d2);
+
+    // Lennard-Jones
+    __m512d r6 = _mm512_mul_pd(_mm512_mul_pd(r2, r2), r2);
+    __m512d r12 = _mm512_mul_pd(r6, r6);
+    __m512d r6B = _mm512_mul_pd(_mm512_loadu_pd(B + k), r6);
+    __m512d r12A = _mm512_mul_pd(_mm512_loadu_pd(A + k), r12);
+    __m512d energy1 = _mm512_sub_pd(r12A, r6B);
+    __m512d force1 =
+      _mm512_sub_pd(_mm512_mul_pd(_mm512_mul_pd(twelve, r12A), r2),
+                    _mm512_mul_pd(_mm512_mul_pd(six, r6B), r2));
+
+    // Coulomb
+    __m512d energy2 =
+      _mm512_mul_pd(_mm512_mul_pd(_mm512_loadu_pd(qq + k), _mm512_sqrt_pd(r2)),
+                    _mm512_loadu_pd(scale + k));
+    __m512d force2 = _mm512_mul_pd(energy2, r2);
+
+    // C2 switch
+    __mmask8 inCutoff = _mm512_cmp_pd_mask(d2, cutoff2, _CMP_LE_OQ);
+    __mmask8 inSwitch =
+      _mm512_mask_cmp_pd_mask(inCutoff, d2, switchon2, _CMP_GE_OQ);
+    __m512d c2 = _mm512_sub_pd(cutoff2, d2);
+    __m512d c4 =
+      _mm512_mul_pd(c2, _mm512_add_pd(switch2, _mm512_mul_pd(two, d2)));
+    __m512d value =
+      _mm512_mask_blend_pd(inSwitch, one,
+                           _mm512_mul_pd(switch1, _mm512_mul_pd(c2, c4)));
+    value = _mm512_mask_blend_pd(inCutoff, zero, value);
+    __m512d deriv =
+      _mm512_mask_blend_pd(inSwitch, zero,
+                           _mm512_mul_pd(switch3,
+                                         _mm512_sub_pd(_mm512_mul_pd(c2, c2),
+                                                       c4)));
+    force1 = _mm512_sub_pd(_mm512_mul_pd(force1, value),
+                           _mm512_mul_pd(energy1, deriv));
+    energy1 = _mm512_mul_pd(energy1, value);
+
+    // C1 switch
+    inCutoff = _mm512_cmp_pd_mask(d2, cCutoff2, _CMP_LE_OQ);
+    __m512d dist = _mm512_sqrt_pd(d2);
+    value =
+      _mm512_mask_blend_pd(inCutoff, zero,
+                           _mm512_sub_pd(one,
+                                         _mm512_mul_pd(dist,
+                                                       _mm512_sub_pd(c15Cutoff_1,
+                                                                     _mm512_mul_pd(d2, c05Cutoff_3)))));
+    deriv = _mm512_mask_blend_pd(inCutoff, zero,
+                                 _mm512_sub_pd(_mm512_mul_pd(dist, c15Cutoff_3),
+                                               _mm512_div_pd(c15Cutoff_1, dist)));
+    force2 = _mm512_sub_pd(_mm512_mul_pd(force2, value),
+                           _mm512_mul_pd(energy2, deriv));
+    energy2 = _mm512_mul_pd(energy2, value);
+
+    _mm512_storeu_pd(energyLJ + k, energy1);
+    _mm512_storeu_pd(energyCoulomb + k, energy2);
+    _mm512_storeu_pd(force + k, _mm512_add_pd(force1, force2));
+  }
+
+  for (; k < n; k++)
+    kernelPair<Real>(c, distSquared[k], A[k], B[k], qq[k], scale[k],
+                     energyLJ[k], energyCoulomb[k], force[k]);
+}
+#endif
+
+#ifdef HAVE_X86_MIXED_KERNELS
+// Single precision kernels of the mixed precision build, twice the pairs
+// per vector. The pairs are converted from and the results back to Real.
+
+//____ SSE2 (mixed)
+
+// Four doubles converted to one vector of floats and back
+__attribute__((target("sse2")))
+static inline __m128 loadSSE2(const Real *p) {
+  return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)),
+                       _mm_cvtpd_ps(_mm_loadu_pd(p + 2)));
+}
+
+__attribute__((target("sse2")))
+static inline void storeSSE2(Real *p, __m128 v) {
+  _mm_storeu_pd(p, _mm_cvtps_pd(v));
+  _mm_storeu_pd(p + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+}
+
+__attribute__((target("sse2")))
+static void kernelMixedSSE2(const Coefficients &c, unsigned int n,
+                            const Real *distSquared, const Real *A,
+                            const Real *B, const Real *qq, const Real *scale,
+                            Real *energyLJ, Real *energyCoulomb, Real *force) {
+  const __m128 one = _mm_set1_ps(1.0);
+  const __m128 two = _mm_set1_ps(2.0);
+  const __m128 six = _mm_set1_ps(6.0);
+  const __m128 twelve = _mm_set1_ps(12.0);
+  const __m128 switchon2 = _mm_set1_ps(c.switchon2);
+  const __m128 cutoff2 = _mm_set1_ps(c.cutoff2);
+  const __m128 switch1 = _mm_set1_ps(c.switch1);
+  const __m128 switch2 = _mm_set1_ps(c.switch2);
+  const __m128 switch3 = _mm_set1_ps(c.switch3);
+  const __m128 cCutoff2 = _mm_set1_ps(c.cCutoff2);
+  const __m128 c15Cutoff_1 = _mm_set1_ps(c.c15Cutoff_1);
+  const __m128 c05Cutoff_3 = _mm_set1_ps(c.c05Cutoff_3);
+  const __m128 c15Cutoff_3 = _mm_set1_ps(c.c15Cutoff_3);
+
+  unsigned int k = 0;
+  for (; k + 4 <= n; k += 4) {
+    __m128 d2 = loadSSE2(distSquared + k);
+    __m128 r2 = _mm_div_ps(one, d2);
+
+    // Lennard-Jones
+    __m128 r6 = _mm_mul_ps(_mm_mul_ps(r2, r2), r2);
+    __m128 r12 = _mm_mul_ps(r6, r6);
+    __m128 r6B = _mm_mul_ps(loadSSE2(B + k), r6);
+    __m128 r12A = _mm_mul_ps(loadSSE2(A + k), r12);
+    __m128 energy1 = _mm_sub_ps(r12A, r6B);
+    __m128 force1 = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(twelve, r12A), r2),
+                               _mm_mul_ps(_mm_mul_ps(six, r6B), r2));
+
+    // Coulomb
+    __m128 energy2 = _mm_mul_ps(_mm_mul_ps(loadSSE2(qq + k),
+                                           _mm_sqrt_ps(r2)),
+                                loadSSE2(scale + k));
+    __m128 force2 = _mm_mul_ps(energy2, r2);
+
+    // C2 switch
+    __m128 inCutoff = _mm_cmple_ps(d2, cutoff2);
+    __m128 inSwitch = _mm_and_ps(inCutoff, _mm_cmpge_ps(d2, switchon2));
+    __m128 c2 = _mm_sub_ps(cutoff2, d2);
+    __m128 c4 = _mm_mul_ps(c2, _mm_add_ps(switch2, _mm_mul_ps(two, d2)));
+    __m128 value =
+      _mm_or_ps(_mm_and_ps(inSwitch, _mm_mul_ps(switch1, _mm_mul_ps(c2, c4))),
+                _mm_andnot_ps(inSwitch, one));
+    value = _mm_and_ps(inCutoff, value);
+    __m128 deriv =
+      _mm_and_ps(inSwitch,
+                 _mm_mul_ps(switch3, _mm_sub_ps(_mm_mul_ps(c2, c2), c4)));
+    force1 = _mm_sub_ps(_mm_mul_ps(force1, value), _mm_mul_ps(energy1, deriv));
+    energy1 = _mm_mul_ps(energy1, value);
+
+    // C1 switch
+    inCutoff = _mm_cmple_ps(d2, cCutoff2);
+    __m128 dist = _mm_sqrt_ps(d2);
+    value = _mm_and_ps(inCutoff,
+                       _mm_sub_ps(one, _mm_mul_ps(dist,
+                                                  _mm_sub_ps(c15Cutoff_1,
+                                                             _mm_mul_ps(d2, c05Cutoff_3)))));
+    deriv = _mm_and_ps(inCutoff,
+                       _mm_sub_ps(_mm_mul_ps(dist, c15Cutoff_3),
+                                  _mm_div_ps(c15Cutoff_1, dist)));
+    force2 = _mm_sub_ps(_mm_mul_ps(force2, value), _mm_mul_ps(energy2, deriv));
+    energy2 = _mm_mul_ps(energy2, value);
+
+    storeSSE2(energyLJ + k, energy1);
+    storeSSE2(energyCoulomb + k, energy2);
+    storeSSE2(force + k, _mm_add_ps(force1, force2));
+  }
+
+  for (; k < n; k++)
+    kernelPair<float>(c, distSquared[k], A[k], B[k], qq[k], scale[k],
+                      energyLJ[k], energyCoulomb[k], force[k]);
+}
+
+//____ AVX2 (mixed)
+
+// Eight doubles converted to one vector of floats and back
+__attribute__((target("avx2")))
+static inline __m256 loadAVX2(const Real *p) {
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(
+                                _mm256_cvtpd_ps(_mm256_loadu_pd(p))),
+                              _mm256_cvtpd_ps(_mm256_loadu_pd(p + 4)), 1);
+}
+
+__attribute__((target("avx2")))
+static inline void storeAVX2(Real *p, __m256 v) {
+  _mm256_storeu_pd(p, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+  _mm256_storeu_pd(p + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+}
+
+__attribute__((target("avx2")))
+static void kernelMixedAVX2(const Coefficients &c, unsigned int n,
+                            const Real *distSquared, const Real *A,
+                            const Real *B, const Real *qq, const Real *scale,
+                            Real *energyLJ, Real *energyCoulomb, Real *force) {
+  const __m256 one = _mm256_set1_ps(1.0);
+  const __m256 two = _mm256_set1_ps(2.0);
+  const __m256 six = _mm256_set1_ps(6.0);
+  const __m256 twelve = _mm256_set1_ps(12.0);
+  const __m256 switchon2 = _mm256_set1_ps(c.switchon2);
+  const __m256 cutoff2 = _mm256_set1_ps(c.cutoff2);
+  const __m256 switch1 = _mm256_set1_ps(c.switch1);
+  const __m256 switch2 = _mm256_set1_ps(c.switch2);
+  const __m256 switch3 = _mm256_set1_ps(c.switch3);
+  const __m256 cCutoff2 = _mm256_set1_ps(c.cCutoff2);
+  const __m256 c15Cutoff_1 = _mm256_set1_ps(c.c15Cutoff_1);
+  const __m256 c05Cutoff_3 = _mm256_set1_ps(c.c05Cutoff_3);
+  const __m256 c15Cutoff_3 = _mm256_set1_ps(c.c15Cutoff_3);
+
+  unsigned int k = 0;
+  for (; k + 8 <= n; k += 8) {
+    __m256 d2 = loadAVX2(distSquared + k);
+    __m256 r2 = _mm256_div_ps(one, d2);
+
+    // Lennard-Jones
+    __m256 r6 = _mm256_mul_ps(_mm256_mul_ps(r2, r2), r2);
+    __m256 r12 = _mm256_mul_ps(r6, r6);
+    __m256 r6B = _mm256_mul_ps(loadAVX2(B + k), r6);
+    __m256 r12A = _mm256_mul_ps(loadAVX2(A + k), r12);
+    __m256 energy1 = _mm256_sub_ps(r12A, r6B);
+    __m256 force1 =
+      _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(twelve, r12A), r2),
+                    _mm256_mul_ps(_mm256_mul_ps(six, r6B), r2));
+
+    // Coulomb
+    __m256 energy2 =
+      _mm256_mul_ps(_mm256_mul_ps(loadAVX2(qq + k), _mm256_sqrt_ps(r2)),
+                    loadAVX2(scale + k));
+    __m256 force2 = _mm256_mul_ps(energy2, r2);
+
+    // C2 switch
+    __m256 inCutoff = _mm256_cmp_ps(d2, cutoff2, _CMP_LE_OQ);
+    __m256 inSwitch =
+      _mm256_and_ps(inCutoff, _mm256_cmp_ps(d2, switchon2, _CMP_GE_OQ));
+    __m256 c2 = _mm256_sub_ps(cutoff2, d2);
+    __m256 c4 =
+      _mm256_mul_ps(c2, _mm256_add_ps(switch2, _mm256_mul_ps(two, d2)));
+    __m256 value =
+      _mm256_blendv_ps(one, _mm256_mul_ps(switch1, _mm256_mul_ps(c2, c4)),
+                       inSwitch);
+    value = _mm256_and_ps(inCutoff, value);
+    __m256 deriv =
+      _mm256_and_ps(inSwitch,
+                    _mm256_mul_ps(switch3,
+                                  _mm256_sub_ps(_mm256_mul_ps(c2, c2), c4)));
+    force1 = _mm256_sub_ps(_mm256_mul_ps(force1, value),
+                           _mm256_mul_ps(energy1, deriv));
+    energy1 = _mm256_mul_ps(energy1, value);
+
+    // C1 switch
+    inCutoff = _mm256_cmp_ps(d2, cCutoff2, _CMP_LE_OQ);
+    __m256 dist = _mm256_sqrt_ps(d2);
+    value =
+      _mm256_and_ps(inCutoff,
+                    _mm256_sub_ps(one,
+                                  _mm256_mul_ps(dist,
+                                                _mm256_sub_ps(c15Cutoff_1,
+                                                              _mm256_mul_ps(d2, c05Cutoff_3)))));
+    deriv = _mm256_and_ps(inCutoff,
+                          _mm256_sub_ps(_mm256_mul_ps(dist, c15Cutoff_3),
+                                        _mm256_div_ps(c15Cutoff_1, dist)));
+    force2 = _mm256_sub_ps(_mm256_mul_ps(force2, value),
+                           _mm256_mul_ps(energy2, deriv));
+    energy2 = _mm256_mul_ps(energy2, value);
+
+    storeAVX2(energyLJ + k, energy1);
+    storeAVX2(energyCoulomb + k, energy2);
+    storeAVX2(force + k, _mm256_add_ps(force1, force2));
+  }
+
+  for (; k < n; k++)
+    kernelPair<float>(c, distSquared[k], A[k], B[k], qq[k], scale[k],
+                      energyLJ[k], energyCoulomb[k], force[k]);
+}
+
+//____ AVX-512 (mixed)
+
+// Sixteen doubles converted to one vector of floats and back
+__attribute__((target("avx512f")))
+static inline __m512 loadAVX512(const Real *p) {
+  __m512d low =
+    _mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(_mm512_loadu_pd(p))));
+  return _mm512_castpd_ps(
+    _mm512_insertf64x4(low, _mm256_castps_pd(_mm512_cvtpd_ps(_mm512_loadu_pd(p + 8))),
+                       1));
+}
+
+__attribute__((target("avx512f")))
+static inline void storeAVX512(Real *p, __m512 v) {
+  _mm512_storeu_pd(p, _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+  _mm512_storeu_pd(p + 8,
+                   _mm512_cvtps_pd(_mm256_castpd_ps(
+                     _mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))));
+}
+
+__attribute__((target("avx512f")))
+static void kernelMixedAVX512(const Coefficients &c, unsigned int n,
+                              const Real *distSquared, const Real *A,
+                              const Real *B, const Real *qq, const Real *scale,
+                              Real *energyLJ, Real *energyCoulomb, Real *force) {
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 one = _mm512_set1_ps(1.0);
+  const __m512 two = _mm512_set1_ps(2.0);
+  const __m512 six = _mm512_set1_ps(6.0);
+  const __m512 twelve = _mm512_set1_ps(12.0);
+  const __m512 switchon2 = _mm512_set1_ps(c.switchon2);
+  const __m512 cutoff2 = _mm512_set1_ps(c.cutoff2);
+  const __m512 switch1 = _mm512_set1_ps(c.switch1);
+  const __m512 switch2 = _mm512_set1_ps(c.switch2);
+  const __m512 switch3 = _mm512_set1_ps(c.switch3);
+  const __m512 cCutoff2 = _mm512_set1_ps(c.cCutoff2);
+  const __m512 c15Cutoff_1 = _mm512_set1_ps(c.c15Cutoff_1);
+  const __m512 c05Cutoff_3 = _mm512_set1_ps(c.c05Cutoff_3);
+  const __m512 c15Cutoff_3 = _mm512_set1_ps(c.c15Cutoff_3);
+
+  unsigned int k = 0;
+  for (; k + 16 <= n; k += 16) {
+    __m512 d2 = loadAVX512(distSquared + k);
+    __m512 r2 = _mm512_div_ps(one, d2);
+
+    // Lennard-Jones
+    __m512 r6 = _mm512_mul_ps(_mm512_mul_ps(r2, r2), r2);
+    __m512 r12 = _mm512_mul_ps(r6, r6);
+    __m512 r6B = _mm512_mul_ps(loadAVX512(B + k), r6);
+    __m512 r12A = _mm512_mul_ps(loadAVX512(A + k), r12);
+    __m512 energy1 = _mm512_sub_ps(r12A, r6B);
+    __m512 force1 =
+      _mm512_sub_ps(_mm512_mul_ps(_mm512_mul_ps(twelve, r12A), r2),
+                    _mm512_mul_ps(_mm512_mul_ps(six, r6B), r2));
+
+    // Coulomb
+    __m512 energy2 =
+      _mm512_mul_ps(_mm512_mul_ps(loadAVX512(qq + k), _mm512_sqrt_ps(r2)),
+                    loadAVX512(scale + k));
+    __m512 force2 = _mm512_mul_ps(energy2, r2);
+
+    // C2 switch
+    __mmask16 inCutoff = _mm512_cmp_ps_mask(d2, cutoff2, _CMP_LE_OQ);
+    __mmask16 inSwitch =
+      _mm512_mask_cmp_ps_mask(inCutoff, d2, switchon2, _CMP_GE_OQ);
+    __m512 c2 = _mm512_sub_ps(cutoff2, d2);
+    __m512 c4 =
+      _mm512_mul_ps(c2, _mm512_add_ps(switch2, _mm512_mul_ps(two, d2)));
+    __m512 value =
+      _mm512_mask_blend_ps(inSwitch, one,
+                           _mm512_mul_ps(switch1, _mm512_mul_ps(c2, c4)));
+    value = _mm512_mask_blend_ps(inCutoff, zero, value);
+    __m512 deriv =
+      _mm512_mask_blend_ps(inSwitch, zero,
+                           _mm512_mul_ps(switch3,
+                                         _mm512_sub_ps(_mm512_mul_ps(c2, c2),
+                                                       c4)));
+    force1 = _mm512_sub_ps(_mm512_mul_ps(force1, value),
+                           _mm512_mul_ps(energy1, deriv));
+    energy1 = _mm512_mul_ps(energy1, value);
+
+    // C1 switch
+    inCutoff = _mm512_cmp_ps_mask(d2, cCutoff2, _CMP_LE_OQ);
+    __m512 dist = _mm512_sqrt_ps(d2);
+    value =
+      _mm512_mask_blend_ps(inCutoff, zero,
+                           _mm512_sub_ps(one,
+                                         _mm512_mul_ps(dist,
+                                                       _mm512_sub_ps(c15Cutoff_1,
+                                                                     _mm512_mul_ps(d2, c05Cutoff_3)))));
+    deriv = _mm512_mask_blend_ps(inCutoff, zero,
+                                 _mm512_sub_ps(_mm512_mul_ps(dist, c15Cutoff_3),
+                                               _mm512_div_ps(c15Cutoff_1, dist)));
+    force2 = _mm512_sub_ps(_mm512_mul_ps(force2, value),
+                           _mm512_mul_ps(energy2, deriv));
+    energy2 = _mm512_mul_ps(energy2, value);
+
+    storeAVX512(energyLJ + k, energy1);
+    storeAVX512(energyCoulomb + k, energy2);
+    storeAVX512(force + k, _mm512_add_ps(force1, force2));
+  }
+
+  for (; k < n; k++)
+    kernelPair<float>(c, distSquared[k], A[k], B[k], qq[k], scale[k],
+                      energyLJ[k], energyCoulomb[k], force[k]);
+}
+#endif
+
+//____ LennardJonesCoulombKernel
+
+LennardJonesCoulombKernel::LennardJonesCoulombKernel() :
+  myKernel(selectKernel()) {
+  myCoefficients.switchon2 = myCoefficients.cutoff2 = 0.0;
+  myCoefficients.switch1 = myCoefficients.switch2 = 0.0;
+  myCoefficients.switch3 = myCoefficients.cCutoff2 = 0.0;
+  myCoefficients.c15Cutoff_1 = myCoefficients.c05Cutoff_3 = 0.0;
+  myCoefficients.c15Cutoff_3 = 0.0;
+}
+
+LennardJonesCoulombKernel::LennardJonesCoulombKernel
+(const C2SwitchingFunction &switchLJ,
+ const C1SwitchingFunction &switchCoulomb) : myKernel(selectKernel()) {
+  myCoefficients.switchon2 = switchLJ.switchonSquared();
+  myCoefficients.cutoff2 = switchLJ.cutoffSquared();
+  myCoefficients.switch1 = switchLJ.switch1();
+  myCoefficients.switch2 = switchLJ.switch2();
+  myCoefficients.switch3 = switchLJ.switch3();
+
+  myCoefficients.cCutoff2 = switchCoulomb.cutoffSquared();
+  myCoefficients.c15Cutoff_1 = switchCoulomb.c15Cutoff_1();
+  myCoefficients.c05Cutoff_3 = switchCoulomb.c05Cutoff_3();
+  myCoefficients.c15Cutoff_3 = switchCoulomb.c15Cutoff_3();
+}
+
+LennardJonesCoulombKernel::Kernel LennardJonesCoulombKernel::selectKernel() {
+#ifdef HAVE_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return kernelAVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return kernelAVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return kernelSSE2;
+#endif
+#ifdef HAVE_X86_MIXED_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return kernelMixedAVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return kernelMixedAVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return kernelMixedSSE2;
+#endif
+  return kernelScalar;
+}
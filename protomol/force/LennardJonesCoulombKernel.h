@@ -0,0 +1,90 @@
+/* -*- c++ -*- */
+#ifndef LENNARDJONESCOULOMBKERNEL_H
+#define LENNARDJONESCOULOMBKERNEL_H
+
+#include <protomol/type/Real.h>
+#include <protomol/switch/C1SwitchingFunction.h>
+#include <protomol/switch/C2SwitchingFunction.h>
+
+namespace ProtoMol {
+  //____ LennardJonesCoulombKernel
+
+  /**
+   * Fused Lennard-Jones (C2 switch) and Coulomb (C1 switch) kernel over
+   * blocks of pairs in structure-of-arrays layout. The arithmetic is the
+   * same as LennardJonesForce, CoulombForce, C2SwitchingFunction and
+   * C1SwitchingFunction evaluated one pair at a time, operation by
+   * operation, such that the results do not depend on the vector width.
+   *
+   * The vector implementation (SSE2, AVX2 or AVX-512) is selected once at
+   * run time from the CPU features, with a scalar fallback on other
+   * architectures.
+   *
+   * The mixed precision build (USE_MIXED_PRECISION) computes the pairs in
+   * KernelReal, i.e., float, with twice the pairs per vector. The arrays
+   * stay Real, the energies and forces are accumulated by the caller in
+   * Real.
+   *
+   * Neither the vector code nor the mixed precision build is measurably
+   * faster than the scalar pair loop on the water benchmarks: the gather
+   * of the pairs, the exclusion checks, the parameter lookup and the
+   * scatter of the forces stay scalar and dominate the cost per pair.
+   * The kernel is kept as the starting point for vectorizing those, not
+   * as a performance option.
+   */
+  class LennardJonesCoulombKernel {
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Types and Enums
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    /// Switching function coefficients of both forces
+    struct Coefficients {
+      // C2 of Lennard-Jones
+      Real switchon2, cutoff2, switch1, switch2, switch3;
+      // C1 of Coulomb
+      Real cCutoff2, c15Cutoff_1, c05Cutoff_3, c15Cutoff_3;
+    };
+
+    typedef void (*Kernel)(const Coefficients &, unsigned int n,
+                           const Real *distSquared, const Real *A,
+                           const Real *B, const Real *qq,
+                           const Real *scale, Real *energyLJ,
+                           Real *energyCoulomb, Real *force);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    LennardJonesCoulombKernel();
+    LennardJonesCoulombKernel(const C2SwitchingFunction &switchLJ,
+                              const C1SwitchingFunction &switchCoulomb);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class LennardJonesCoulombKernel
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    /**
+     * Computes the switched energies and the force (divided by the
+     * distance) of n pairs. A and B are the Lennard-Jones parameters of
+     * the pair, qq the product of the scaled charges and scale the Coulomb
+     * scaling factor (1 unless the pair is a modified exclusion).
+     */
+    void operator()(unsigned int n, const Real *distSquared, const Real *A,
+                    const Real *B, const Real *qq, const Real *scale,
+                    Real *energyLJ, Real *energyCoulomb, Real *force) const {
+      myKernel(myCoefficients, n, distSquared, A, B, qq, scale, energyLJ,
+               energyCoulomb, force);
+    }
+
+  private:
+    static Kernel selectKernel();
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    Coefficients myCoefficients;
+    Kernel myKernel;
+  };
+}
+#endif /* LENNARDJONESCOULOMBKERNEL_H */
@@ -7,6 +7,7 @@
 #include <protomol/type/ScalarStructure.h>
 #include <protomol/topology/ExclusionTable.h>
 #include <protomol/config/Parameter.h>
+#include <protomol/force/ThreadSafeForce.h>
 #include <string>
 #include <protomol/base/Report.h>
 using namespace ProtoMol::Report;
@@ -100,6 +101,11 @@ namespace ProtoMol {
     static const std::string keyword;
   private:
   };
+
+  template<>
+  struct ThreadSafeForce<LennardJonesForce> {
+    enum {VALUE = 1};
+  };
   //____ INLINES
 }
 
@@ -6,8 +6,26 @@
 #include <protomol/config/Parameter.h>
 #include <protomol/type/ScalarStructure.h>
 #include <protomol/force/OneAtomContraints.h>
+#include <protomol/force/ThreadSafeForce.h>
 
 namespace ProtoMol {
+  //____ PairBlock
+
+  /**
+   * Scratch space of the batched pair kernels, holding the minimal
+   * differences and squared distances of one chunk of partner atoms in
+   * structure-of-arrays layout.
+   */
+  struct PairBlock {
+    enum {SIZE = 64};
+
+    Real dx[SIZE];
+    Real dy[SIZE];
+    Real dz[SIZE];
+    Real distSquared[SIZE];
+    int j[SIZE];
+  };
+
   //____ OneAtomPair
 
   /**
@@ -21,6 +39,10 @@ namespace ProtoMol {
     public:
       typedef Boundary BoundaryConditions;
       typedef SemiGenericTopology<Boundary> TopologyType;
+
+      /// Copies of this pair may be evaluated concurrently on one topology
+      enum {THREAD_SAFE = ThreadSafeForce<Force>::VALUE &&
+            !Constraint::POST_CHECK};
     
     public:
       OneAtomPair() : SwitchFunction(), ForceFunction() {};
@@ -34,6 +56,7 @@ namespace ProtoMol {
                       Vector3DBlock *f, ScalarStructure *e) {
         realTopo = (TopologyType *)topo;
         positions = pos;
+        positionsSoA = &topo->getPositionsSoA(pos);
         forces = f;
         energies = e;
       }
@@ -43,67 +66,30 @@ namespace ProtoMol {
         initialize(static_cast<const TopologyType *>(topo), pos, f, e);
       }
 
-      // Computes the force and energy for atom i and j.
-      virtual void doOneAtomPair(const int i, const int j) {
-        if (Constraint::PRE_CHECK)
-          if (!Constraint::check(realTopo, i, j))
-            return;
-
-        // Get atom distance.
-        Real distSquared;
-
-        Vector3D diff = realTopo->
-          boundaryConditions.minimalDifference((*positions)[i], (*positions)[j],
-                                               distSquared);
-        //      cout << "DIFF: " << diff << endl;
-        // Do switching function rough test, if necessary.
-        if (Switch::USE || Force::CUTOFF)
-          if (distSquared > mySquaredCutoff)
-            return;
-        // Check for an exclusion.
-        int mi = realTopo->atoms[i].molecule;
-        int mj = realTopo->atoms[j].molecule;
-        bool same = (mi == mj);
-        ExclusionClass excl =
-          (same ? realTopo->exclusions.check(i, j) : EXCLUSION_NONE);
-        if (excl == EXCLUSION_FULL)
-          return;
-
-        // Calculate the force and energy.
-        Real energy = 0, force = 0;
-        Real rDistSquared = (Force::DIST_R2 ? 1.0 / distSquared : 1.0);
-        ForceFunction(energy, force, distSquared, rDistSquared, diff,
-                               realTopo, i, j, excl);
-        //      cout << "EN: " << energy << " FO: " << force << endl;
-        // Calculate the switched force and energy.
-        if (Switch::MODIFY) {
-          Real switchingValue, switchingDeriv;
-          SwitchFunction(switchingValue, switchingDeriv, distSquared);
-          // This has a - sign because the force is the negative of the
-          // derivative of the energy (divided by the distance between the atoms).
-          force = force * switchingValue - energy * switchingDeriv;
-          energy = energy * switchingValue;
-        }
+      /// Computes the force and energy for atom i and j.
+      void doOneAtomPair(const int i, const int j) {
+        doAtomPairBlock(i, &j, &j + 1);
+      }
 
-        // Add this energy into the total system energy.
-        ForceFunction.accumulateEnergy(energies, energy);
-        // Add this force into the atom forces.
-        Vector3D fij(diff * force);
-        (*forces)[i] -= fij;
-        (*forces)[j] += fij;
-
-        // compute the vector between molecular centers of mass
-        if (!same && energies->molecularVirial())
-          // Add to the atomic and molecular virials
-          energies->
-            addVirial(fij, diff, realTopo->boundaryConditions.
-                      minimalDifference(realTopo->molecules[mi].position,
-                                        realTopo->molecules[mj].position));
-        else if (energies->virial())
-          energies->addVirial(fij, diff);
-        // End of force computation.
-        if (Constraint::POST_CHECK)
-          Constraint::check(realTopo, i, j, diff, energy, fij);
+      /**
+       * Computes the force and energy between atom i and each atom of
+       * jBegin..jEnd. The minimal differences and the cutoff test are done
+       * in a first pass over a chunk of the block (see gatherPairBlock()),
+       * the force on atom i and the energy are accumulated locally and
+       * written back once per block.
+       */
+      void doAtomPairBlock(const int i, const int *jBegin, const int *jEnd) {
+        doPairBlock<true>(i, jBegin, jEnd, EXCLUSION_NONE);
+      }
+
+      /**
+       * Same as doAtomPairBlock() for a pair list with the exclusions
+       * compiled in (see VerletList), all pairs are of class excl and the
+       * exclusion table is not looked up.
+       */
+      void doAtomPairBlock(const int i, const int *jBegin, const int *jEnd,
+                           ExclusionClass excl) {
+        doPairBlock<false>(i, jBegin, jEnd, excl);
       }
 
       virtual void getParameters(std::vector<Parameter> &parameters) const {
@@ -141,9 +127,121 @@ namespace ProtoMol {
         return Constraint::getPrefixId() + Force::getId() + Constraint::getPostfixId() +
           std::string((!Switch::USE) ? std::string("") : std::string(" -switchingFunction " + Switch::getId()));
       }
+    protected:
+      /// Pair loop of doAtomPairBlock(), the exclusions are looked up if
+      /// CHECK, else all pairs are of class listExcl
+      template<bool CHECK>
+      void doPairBlock(const int i, const int *jBegin, const int *jEnd,
+                       ExclusionClass listExcl) {
+        const int mi = realTopo->atoms[i].molecule;
+        const bool doMolVirial = energies->molecularVirial();
+        const bool doVirial = energies->virial();
+        Vector3D forceI(0.0, 0.0, 0.0);
+        Real energyI = 0.0;
+        PairBlock block;
+
+        while (jBegin != jEnd) {
+          unsigned int n = static_cast<unsigned int>(jEnd - jBegin);
+          if (n > PairBlock::SIZE) n = PairBlock::SIZE;
+          unsigned int m =
+            gatherPairBlock(i, jBegin, n, Switch::USE || Force::CUTOFF, block);
+          jBegin += n;
+
+          for (unsigned int k = 0; k < m; k++) {
+            const int j = block.j[k];
+            const Real distSquared = block.distSquared[k];
+            const Vector3D diff(block.dx[k], block.dy[k], block.dz[k]);
+
+            // Check for an exclusion.
+            int mj = realTopo->atoms[j].molecule;
+            bool same = (mi == mj);
+            ExclusionClass excl = listExcl;
+            if (CHECK) {
+              excl = (same ? realTopo->exclusions.check(i, j) : EXCLUSION_NONE);
+              if (excl == EXCLUSION_FULL)
+                continue;
+            }
+
+            // Calculate the force and energy.
+            Real energy = 0, force = 0;
+            Real rDistSquared = (Force::DIST_R2 ? 1.0 / distSquared : 1.0);
+            ForceFunction(energy, force, distSquared, rDistSquared, diff,
+                          realTopo, i, j, excl);
+            // Calculate the switched force and energy.
+            if (Switch::MODIFY) {
+              Real switchingValue, switchingDeriv;
+              SwitchFunction(switchingValue, switchingDeriv, distSquared);
+              // This has a - sign because the force is the negative of the
+              // derivative of the energy (divided by the distance between the
+              // atoms).
+              force = force * switchingValue - energy * switchingDeriv;
+              energy = energy * switchingValue;
+            }
+
+            energyI += energy;
+            // Add this force into the atom forces.
+            Vector3D fij(diff * force);
+            forceI -= fij;
+            (*forces)[j] += fij;
+
+            // compute the vector between molecular centers of mass
+            if (!same && doMolVirial)
+              // Add to the atomic and molecular virials
+              energies->
+                addVirial(fij, diff, realTopo->boundaryConditions.
+                          minimalDifference(realTopo->molecules[mi].position,
+                                            realTopo->molecules[mj].position));
+            else if (doVirial)
+              energies->addVirial(fij, diff);
+            // End of force computation.
+            if (Constraint::POST_CHECK)
+              Constraint::check(realTopo, i, j, diff, energy, fij);
+          }
+        }
+
+        // Add this energy into the total system energy.
+        ForceFunction.accumulateEnergy(energies, energyI);
+        (*forces)[i] += forceI;
+      }
+
+      /**
+       * Computes the minimal differences of atom i to the n atoms starting at
+       * jBegin and compacts the block to the pairs passing the constraint and,
+       * if checkCutoff, the cutoff test. Returns the number of pairs kept.
+       */
+      unsigned int gatherPairBlock(const int i, const int *jBegin,
+                                   unsigned int n, bool checkCutoff,
+                                   PairBlock &block) const {
+        const Real *x = positionsSoA->x();
+        const Real *y = positionsSoA->y();
+        const Real *z = positionsSoA->z();
+        realTopo->boundaryConditions.
+          minimalDifferences(Vector3D(x[i], y[i], z[i]), x, y, z, jBegin, n,
+                             block.dx, block.dy, block.dz, block.distSquared);
+
+        unsigned int m = 0;
+        for (unsigned int k = 0; k < n; k++) {
+          const int j = jBegin[k];
+          if (Constraint::PRE_CHECK)
+            if (!Constraint::check(realTopo, i, j))
+              continue;
+          // Do switching function rough test, if necessary.
+          if (checkCutoff && block.distSquared[k] > mySquaredCutoff)
+            continue;
+          block.dx[m] = block.dx[k];
+          block.dy[m] = block.dy[k];
+          block.dz[m] = block.dz[k];
+          block.distSquared[m] = block.distSquared[k];
+          block.j[m] = j;
+          m++;
+        }
+        return m;
+      }
+
     protected:
       mutable TopologyType *realTopo;
       const Vector3DBlock *positions;
+      const Vector3DBlockSoA *positionsSoA;
       Vector3DBlock *forces;
       ScalarStructure *energies;
       Switch SwitchFunction;
@@ -23,68 +23,83 @@ namespace ProtoMol {
       }
     
       void doOneAtomPair(const int i, const int j) {
-        if (Constraint::PRE_CHECK){
-          if (!Constraint::check(Base::realTopo, i, j)) return;
-        }
+        doAtomPairBlock(i, &j, &j + 1);
+      }
 
-        // Get atom distance.
-        Real distSquared;
+      /// Same as OneAtomPair::doAtomPairBlock(), but excluded pairs are
+      /// evaluated as well
+      void doAtomPairBlock(const int i, const int *jBegin, const int *jEnd) {
+        const int mi = Base::realTopo->atoms[i].molecule;
+        const bool doMolVirial = Base::energies->molecularVirial();
+        const bool doVirial = Base::energies->virial();
+        Vector3D forceI(0.0, 0.0, 0.0);
+        Real energyI = 0.0;
+        PairBlock block;
 
-        Vector3D diff = Base::realTopo-> boundaryConditions.minimalDifference(
-          (*Base::positions)[i], (*Base::positions)[j], distSquared
-        );
-        
-        // Do switching function rough test, if necessary.
-        if (Switch::USE || Force::CUTOFF){
-          if (distSquared > Base::mySquaredCutoff) return;
-        }
-        
-        // Don't Check for an exclusion.
-        int mi = Base::realTopo->atoms[i].molecule;
-        int mj = Base::realTopo->atoms[j].molecule;
-        bool same = (mi == mj);
-        ExclusionClass excl =
-          (same ? Base::realTopo->exclusions.check(i, j) : EXCLUSION_NONE);
-
-        // Calculate the force and energy.
-        Real energy = 0, force = 0;
-        Real rDistSquared = (Force::DIST_R2 ? 1.0 / distSquared : 1.0);
-        Base::ForceFunction(energy, force, distSquared, rDistSquared, diff,
-                               Base::realTopo, i, j, excl);
-        
-        // Calculate the switched force and energy.
-        if (Switch::MODIFY) {
-          Real switchingValue, switchingDeriv;
-          Base::SwitchFunction(switchingValue, switchingDeriv, distSquared);
-          // This has a - sign because the force is the negative of the
-          // derivative of the energy (divided by the distance between the atoms).
-          force = force * switchingValue - energy * switchingDeriv;
-          energy = energy * switchingValue;
+        while (jBegin != jEnd) {
+          unsigned int n = static_cast<unsigned int>(jEnd - jBegin);
+          if (n > PairBlock::SIZE) n = PairBlock::SIZE;
+          unsigned int m =
+            Base::gatherPairBlock(i, jBegin, n, Switch::USE || Force::CUTOFF,
+                                  block);
+          jBegin += n;
+
+          for (unsigned int k = 0; k < m; k++) {
+            const int j = block.j[k];
+            const Real distSquared = block.distSquared[k];
+            const Vector3D diff(block.dx[k], block.dy[k], block.dz[k]);
+
+            // Don't Check for an exclusion.
+            int mj = Base::realTopo->atoms[j].molecule;
+            bool same = (mi == mj);
+            ExclusionClass excl =
+              (same ? Base::realTopo->exclusions.check(i, j) : EXCLUSION_NONE);
+
+            // Calculate the force and energy.
+            Real energy = 0, force = 0;
+            Real rDistSquared = (Force::DIST_R2 ? 1.0 / distSquared : 1.0);
+            Base::ForceFunction(energy, force, distSquared, rDistSquared, diff,
+                                Base::realTopo, i, j, excl);
+
+            // Calculate the switched force and energy.
+            if (Switch::MODIFY) {
+              Real switchingValue, switchingDeriv;
+              Base::SwitchFunction(switchingValue, switchingDeriv, distSquared);
+              // This has a - sign because the force is the negative of the
+              // derivative of the energy (divided by the distance between the
+              // atoms).
+              force = force * switchingValue - energy * switchingDeriv;
+              energy = energy * switchingValue;
+            }
+
+            energyI += energy;
+
+            // Add this force into the atom forces.
+            Vector3D fij(diff * force);
+            forceI -= fij;
+            (*Base::forces)[j] += fij;
+
+            // compute the vector between molecular centers of mass
+            if (!same && doMolVirial) {
+              // Add to the atomic and molecular virials
+              Base::energies->
+                addVirial(fij, diff, Base::realTopo->boundaryConditions.
+                          minimalDifference(Base::realTopo->molecules[mi].position,
+                                            Base::realTopo->molecules[mj].position));
+            } else if (doVirial) {
+              Base::energies->addVirial(fij, diff);
+            }
+
+            // End of force computation.
+            if (Constraint::POST_CHECK) {
+              Constraint::check(Base::realTopo, i, j, diff, energy, fij);
+            }
+          }
         }
 
         // Add this energy into the total system energy.
-        Base::ForceFunction.accumulateEnergy(Base::energies, energy);
-        
-        // Add this force into the atom forces.
-        Vector3D fij(diff * force);
-        (*Base::forces)[i] -= fij;
-        (*Base::forces)[j] += fij;
-
-        // compute the vector between molecular centers of mass
-        if (!same && Base::energies->molecularVirial()){
-          // Add to the atomic and molecular virials
-          Base::energies->
-            addVirial(fij, diff, Base::realTopo->boundaryConditions.
-                      minimalDifference(Base::realTopo->molecules[mi].position,
-                                        Base::realTopo->molecules[mj].position));
-        } else if (Base::energies->virial()) {
-          Base::energies->addVirial(fij, diff);
-        }
-        
-        // End of force computation.
-        if (Constraint::POST_CHECK){
-          Constraint::check(Base::realTopo, i, j, diff, energy, fij);
-        }
+        Base::ForceFunction.accumulateEnergy(Base::energies, energyI);
+        (*Base::forces)[i] += forceI;
       }
       
       virtual void preProcess(const GenericTopology *apptopo, const Vector3DBlock *positions){
@@ -14,6 +14,10 @@ namespace ProtoMol {
            typename ForceC, typename Constraint = NoConstraint>
   class OneAtomPairThree : public OneAtomPair<Boundary,SwitchA,ForceA,Constraint> {
     typedef OneAtomPair<Boundary,SwitchA,ForceA,Constraint> Base;
+
+  public:
+    enum {THREAD_SAFE = Base::THREAD_SAFE && ThreadSafeForce<ForceB>::VALUE &&
+          ThreadSafeForce<ForceC>::VALUE};
     
   public:
     OneAtomPairThree() : Base() {
@@ -34,85 +38,103 @@ namespace ProtoMol {
     }
   
     void doOneAtomPair(const int i, const int j) {
-      if (Constraint::PRE_CHECK)
-        if (!Constraint::check(Base::realTopo, i, j))
-          return;
-
-      // Get atom distance.
-      Real distSquared;
-      Vector3D diff(Base::realTopo->boundaryConditions.
-                    minimalDifference((*Base::positions)[i], (*Base::positions)[j],
-                                      distSquared));
-      // Do switching function rough test, if necessary.
-      if ((SwitchA::USE || SwitchB::USE || SwitchC::USE ||
-           ForceA::CUTOFF || ForceB::CUTOFF || ForceC::CUTOFF ) 
-           && distSquared > Base::mySquaredCutoff)
-        return;
-
-      // Check for an exclusion.
-      int mi = Base::realTopo->atoms[i].molecule;
-      int mj = Base::realTopo->atoms[j].molecule;
-      bool same = (mi == mj);
-      ExclusionClass excl =
-        (same ? Base::realTopo->exclusions.check(i, j) : EXCLUSION_NONE);
-      if (excl == EXCLUSION_FULL)
-        return;
-
-      // Calculate the force and energy.
-      Real rDistSquared =
-        ((ForceA::DIST_R2 ||
-            ForceB::DIST_R2 ||
-              ForceC::DIST_R2 ) ? 1.0 / distSquared : 1.0);
-      Real energy1, force1, energy2 = 0, force2 = 0, energy3 = 0, force3 = 0;
-      Base::ForceFunction(energy1, force1, distSquared, rDistSquared,
-                                  diff, Base::realTopo, i, j, excl);
-      ForceFunctionB(energy2, force2, distSquared, rDistSquared,
-                                   diff, Base::realTopo, i, j, excl);
-      ForceFunctionC(energy3, force3, distSquared, rDistSquared,
-                                   diff, Base::realTopo, i, j, excl);
-      
-      // Calculate the switched force and energy.
-      if (SwitchA::MODIFY || 
-            SwitchB::MODIFY || 
-              SwitchC::MODIFY) {
-        Real switchingValue, switchingDeriv;
-
-        Base::SwitchFunction(switchingValue, switchingDeriv, distSquared);
-        force1 = force1 * switchingValue - energy1 * switchingDeriv;
-        energy1 = energy1 * switchingValue;
-
-        SwitchFunctionB(switchingValue, switchingDeriv, distSquared);
-        force2 = force2 * switchingValue - energy2 * switchingDeriv;
-        energy2 = energy2 * switchingValue;
-
-        SwitchFunctionC(switchingValue, switchingDeriv, distSquared);
-        force3 = force3 * switchingValue - energy3 * switchingDeriv;
-        energy3 = energy3 * switchingValue;
+      doAtomPairBlock(i, &j, &j + 1);
+    }
+
+    void doAtomPairBlock(const int i, const int *jBegin, const int *jEnd) {
+      const int mi = Base::realTopo->atoms[i].molecule;
+      const bool doMolVirial = Base::energies->molecularVirial();
+      const bool doVirial = Base::energies->virial();
+      Vector3D forceI(0.0, 0.0, 0.0);
+      Real energyI1 = 0.0, energyI2 = 0.0, energyI3 = 0.0;
+      PairBlock block;
+
+      while (jBegin != jEnd) {
+        unsigned int n = static_cast<unsigned int>(jEnd - jBegin);
+        if (n > PairBlock::SIZE) n = PairBlock::SIZE;
+        unsigned int m =
+          Base::gatherPairBlock(i, jBegin, n,
+                                SwitchA::USE || SwitchB::USE || SwitchC::USE ||
+                                ForceA::CUTOFF || ForceB::CUTOFF ||
+                                ForceC::CUTOFF, block);
+        jBegin += n;
+
+        for (unsigned int k = 0; k < m; k++) {
+          const int j = block.j[k];
+          const Real distSquared = block.distSquared[k];
+          const Vector3D diff(block.dx[k], block.dy[k], block.dz[k]);
+
+          // Check for an exclusion.
+          int mj = Base::realTopo->atoms[j].molecule;
+          bool same = (mi == mj);
+          ExclusionClass excl =
+            (same ? Base::realTopo->exclusions.check(i, j) : EXCLUSION_NONE);
+          if (excl == EXCLUSION_FULL)
+            continue;
+
+          // Calculate the force and energy.
+          Real rDistSquared =
+            ((ForceA::DIST_R2 ||
+                ForceB::DIST_R2 ||
+                  ForceC::DIST_R2 ) ? 1.0 / distSquared : 1.0);
+          Real energy1, force1, energy2 = 0, force2 = 0, energy3 = 0, force3 = 0;
+          Base::ForceFunction(energy1, force1, distSquared, rDistSquared,
+                              diff, Base::realTopo, i, j, excl);
+          ForceFunctionB(energy2, force2, distSquared, rDistSquared,
+                         diff, Base::realTopo, i, j, excl);
+          ForceFunctionC(energy3, force3, distSquared, rDistSquared,
+                         diff, Base::realTopo, i, j, excl);
+
+          // Calculate the switched force and energy.
+          if (SwitchA::MODIFY ||
+                SwitchB::MODIFY ||
+                  SwitchC::MODIFY) {
+            Real switchingValue, switchingDeriv;
+
+            Base::SwitchFunction(switchingValue, switchingDeriv, distSquared);
+            force1 = force1 * switchingValue - energy1 * switchingDeriv;
+            energy1 = energy1 * switchingValue;
+
+            SwitchFunctionB(switchingValue, switchingDeriv, distSquared);
+            force2 = force2 * switchingValue - energy2 * switchingDeriv;
+            energy2 = energy2 * switchingValue;
+
+            SwitchFunctionC(switchingValue, switchingDeriv, distSquared);
+            force3 = force3 * switchingValue - energy3 * switchingDeriv;
+            energy3 = energy3 * switchingValue;
+          }
+
+          energyI1 += energy1;
+          energyI2 += energy2;
+          energyI3 += energy3;
+
+          // Add this force into the atom forces.
+          Vector3D fij(diff * (force1 + force2 + force3));
+          forceI -= fij;
+          (*Base::forces)[j] += fij;
+
+          // compute the vector between molecular centers of mass
+          if (!same && doMolVirial)
+            // Add to the atomic and molecular virials
+            Base::energies->
+              addVirial(fij, diff, Base::realTopo->boundaryConditions.
+                        minimalDifference(Base::realTopo->molecules[mi].position,
+                                          Base::realTopo->molecules[mj].position));
+          else if (doVirial)
+            Base::energies->addVirial(fij, diff);
+
+          // End of force computation.
+          if (Constraint::POST_CHECK)
+            Constraint::check(Base::realTopo, i, j, diff,
+                              energy1 + energy2 + energy3, fij);
+        }
       }
 
       // Add this energy into the total system energy.
-      Base::ForceFunction.accumulateEnergy(Base::energies, energy1);
-      ForceFunctionB.accumulateEnergy(Base::energies, energy2);
-      ForceFunctionC.accumulateEnergy(Base::energies, energy3);
-      
-      // Add this force into the atom forces.
-      Vector3D fij(diff * (force1 + force2 + force3));
-      (*Base::forces)[i] -= fij;
-      (*Base::forces)[j] += fij;
-
-      // compute the vector between molecular centers of mass
-      if (!same && Base::energies->molecularVirial())
-        // Add to the atomic and molecular virials
-        Base::energies->
-          addVirial(fij, diff, Base::realTopo->boundaryConditions.
-                    minimalDifference(Base::realTopo->molecules[mi].position,
-                                      Base::realTopo->molecules[mj].position));
-      else if (Base::energies->virial())
-        Base::energies->addVirial(fij, diff);
-      
-      // End of force computation.
-      if (Constraint::POST_CHECK)
-        Constraint::check(Base::realTopo, i, j, diff, energy1 + energy2 + energy3, fij);
+      Base::ForceFunction.accumulateEnergy(Base::energies, energyI1);
+      ForceFunctionB.accumulateEnergy(Base::energies, energyI2);
+      ForceFunctionC.accumulateEnergy(Base::energies, energyI3);
+      (*Base::forces)[i] += forceI;
     }
 
     virtual void getParameters(std::vector<Parameter> &parameters) const {
@@ -6,13 +6,51 @@
 #include <protomol/config/Parameter.h>
 #include <protomol/force/OneAtomPair.h>
 #include <protomol/force/OneAtomContraints.h>
+#include <protomol/force/LennardJonesForce.h>
+#include <protomol/force/CoulombForce.h>
+#include <protomol/force/LennardJonesCoulombKernel.h>
+#include <protomol/switch/C1SwitchingFunction.h>
+#include <protomol/switch/C2SwitchingFunction.h>
 
 namespace ProtoMol {
+  //____ OneAtomPairTwoKernel
+
+  /**
+   * Fused block kernel of OneAtomPairTwo for a combination of forces and
+   * switching functions. Not used by default (USE = 0); specializations
+   * provide a Block of per-pair parameters and results, set() to fill in
+   * the parameters of one pair and operator() to evaluate a whole block.
+   */
+  template<typename SwitchA, typename ForceA,
+           typename SwitchB, typename ForceB>
+  struct OneAtomPairTwoKernel {
+    enum {USE = 0};
+
+    struct Block {
+      Real energyA[PairBlock::SIZE];
+      Real energyB[PairBlock::SIZE];
+      Real force[PairBlock::SIZE];
+    };
+
+    OneAtomPairTwoKernel() {}
+    OneAtomPairTwoKernel(const SwitchA &, const SwitchB &) {}
+
+    void set(Block &, unsigned int, const GenericTopology *, int, int,
+             ExclusionClass) const {}
+    void operator()(Block &, unsigned int, const Real *) const {}
+  };
+
+  //____ OneAtomPairTwo
+
   template<typename Boundary, typename SwitchA,
            typename ForceA, typename SwitchB,
            typename ForceB, typename Constraint = NoConstraint>
   class OneAtomPairTwo : public OneAtomPair<Boundary,SwitchA,ForceA,Constraint> {
     typedef OneAtomPair<Boundary,SwitchA,ForceA,Constraint> Base;
+    typedef OneAtomPairTwoKernel<SwitchA, ForceA, SwitchB, ForceB> Kernel;
+
+  public:
+    enum {THREAD_SAFE = Base::THREAD_SAFE && ThreadSafeForce<ForceB>::VALUE};
     
   public:
     OneAtomPairTwo() : Base() {
@@ -20,7 +58,8 @@ namespace ProtoMol {
     }
     
     OneAtomPairTwo(ForceA f1, SwitchA sF1, ForceB f2, SwitchB sF2) 
-      : Base( f1, sF1 ), SwitchFunctionB(sF2), ForceFunctionB(f2) {
+      : Base( f1, sF1 ), SwitchFunctionB(sF2), ForceFunctionB(f2),
+        myKernel(sF1, sF2) {
       
         Base::mySquaredCutoff = std::max
                         (Cutoff<ForceA::CUTOFF>::cutoff(sF1, f1),
@@ -28,75 +67,24 @@ namespace ProtoMol {
     }
     
     void doOneAtomPair(const int i, const int j) {
-      if (Constraint::PRE_CHECK)
-        if (!Constraint::check(Base::realTopo, i, j))
-          return;
-
-      // Get atom distance.
-      Real distSquared;
-      Vector3D diff(Base::realTopo->boundaryConditions.
-                    minimalDifference((*Base::positions)[i], (*Base::positions)[j],
-                                      distSquared));
-      // Do switching function rough test, if necessary.
-      if ((SwitchA::USE || SwitchB::USE ||
-           ForceA::CUTOFF ||
-           ForceB::CUTOFF) && distSquared > Base::mySquaredCutoff)
-        return;
-
-      // Check for an exclusion.
-      int mi = Base::realTopo->atoms[i].molecule;
-      int mj = Base::realTopo->atoms[j].molecule;
-      bool same = (mi == mj);
-      ExclusionClass excl =
-        (same ? Base::realTopo->exclusions.check(i, j) : EXCLUSION_NONE);
-      if (excl == EXCLUSION_FULL)
-        return;
-
-      // Calculate the force and energy.
-      Real rDistSquared =
-        ((ForceA::DIST_R2 ||
-          ForceB::DIST_R2) ? 1.0 / distSquared : 1.0);
-      Real energy1, force1, energy2 = 0, force2 = 0;
-      Base::ForceFunction(energy1, force1, distSquared, rDistSquared,
-                                  diff, Base::realTopo, i, j, excl);
-      ForceFunctionB(energy2, force2, distSquared, rDistSquared,
-                                   diff, Base::realTopo, i, j, excl);
-      
-      // Calculate the switched force and energy.
-      if (SwitchA::MODIFY || SwitchB::MODIFY) {
-        Real switchingValue, switchingDeriv;
-
-        Base::SwitchFunction(switchingValue, switchingDeriv, distSquared);
-        force1 = force1 * switchingValue - energy1 * switchingDeriv;
-        energy1 = energy1 * switchingValue;
+      doAtomPairBlock(i, &j, &j + 1);
+    }
 
-        SwitchFunctionB(switchingValue, switchingDeriv, distSquared);
-        force2 = force2 * switchingValue - energy2 * switchingDeriv;
-        energy2 = energy2 * switchingValue;
-      }
+    void doAtomPairBlock(const int i, const int *jBegin, const int *jEnd) {
+      if (Kernel::USE)
+        doPairBlockFused<true>(i, jBegin, jEnd, EXCLUSION_NONE);
+      else
+        doPairBlock<true>(i, jBegin, jEnd, EXCLUSION_NONE);
+    }
 
-      // Add this energy into the total system energy.
-      Base::ForceFunction.accumulateEnergy(Base::energies, energy1);
-      ForceFunctionB.accumulateEnergy(Base::energies, energy2);
-      
-      // Add this force into the atom forces.
-      Vector3D fij(diff * (force1 + force2));
-      (*Base::forces)[i] -= fij;
-      (*Base::forces)[j] += fij;
-
-      // compute the vector between molecular centers of mass
-      if (!same && Base::energies->molecularVirial())
-        // Add to the atomic and molecular virials
-        Base::energies->
-          addVirial(fij, diff, Base::realTopo->boundaryConditions.
-                    minimalDifference(Base::realTopo->molecules[mi].position,
-                                      Base::realTopo->molecules[mj].position));
-      else if (Base::energies->virial())
-        Base::energies->addVirial(fij, diff);
-      
-      // End of force computation.
-      if (Constraint::POST_CHECK)
-        Constraint::check(Base::realTopo, i, j, diff, energy1 + energy2, fij);
+    /// Pairs of a list with the exclusions compiled in, all of class excl
+    /// (see OneAtomPair::doAtomPairBlock())
+    void doAtomPairBlock(const int i, const int *jBegin, const int *jEnd,
+                         ExclusionClass excl) {
+      if (Kernel::USE)
+        doPairBlockFused<false>(i, jBegin, jEnd, excl);
+      else
+        doPairBlock<false>(i, jBegin, jEnd, excl);
     }
 
     void getParameters(std::vector<Parameter> &parameters) const {
@@ -159,9 +147,233 @@ namespace ProtoMol {
         std::string((!SwitchB::USE) ? std::string("") : std::string(" -switchingFunction " + SwitchB::getId()));
     }
     
+  private:
+    /// Pair loop of doAtomPairBlock(), the exclusions are looked up if
+    /// CHECK, else all pairs are of class listExcl
+    template<bool CHECK>
+    void doPairBlock(const int i, const int *jBegin, const int *jEnd,
+                     ExclusionClass listExcl) {
+      const int mi = Base::realTopo->atoms[i].molecule;
+      const bool doMolVirial = Base::energies->molecularVirial();
+      const bool doVirial = Base::energies->virial();
+      Vector3D forceI(0.0, 0.0, 0.0);
+      Real energyI1 = 0.0, energyI2 = 0.0;
+      PairBlock block;
+
+      while (jBegin != jEnd) {
+        unsigned int n = static_cast<unsigned int>(jEnd - jBegin);
+        if (n > PairBlock::SIZE) n = PairBlock::SIZE;
+        unsigned int m =
+          Base::gatherPairBlock(i, jBegin, n,
+                                SwitchA::USE || SwitchB::USE ||
+                                ForceA::CUTOFF || ForceB::CUTOFF, block);
+        jBegin += n;
+
+        for (unsigned int k = 0; k < m; k++) {
+          const int j = block.j[k];
+          const Real distSquared = block.distSquared[k];
+          const Vector3D diff(block.dx[k], block.dy[k], block.dz[k]);
+
+          // Check for an exclusion.
+          int mj = Base::realTopo->atoms[j].molecule;
+          bool same = (mi == mj);
+          ExclusionClass excl = listExcl;
+          if (CHECK) {
+            excl = (same ? Base::realTopo->exclusions.check(i, j) :
+                    EXCLUSION_NONE);
+            if (excl == EXCLUSION_FULL)
+              continue;
+          }
+
+          // Calculate the force and energy.
+          Real rDistSquared =
+            ((ForceA::DIST_R2 ||
+              ForceB::DIST_R2) ? 1.0 / distSquared : 1.0);
+          Real energy1, force1, energy2 = 0, force2 = 0;
+          Base::ForceFunction(energy1, force1, distSquared, rDistSquared,
+                              diff, Base::realTopo, i, j, excl);
+          ForceFunctionB(energy2, force2, distSquared, rDistSquared,
+                         diff, Base::realTopo, i, j, excl);
+
+          // Calculate the switched force and energy.
+          if (SwitchA::MODIFY || SwitchB::MODIFY) {
+            Real switchingValue, switchingDeriv;
+
+            Base::SwitchFunction(switchingValue, switchingDeriv, distSquared);
+            force1 = force1 * switchingValue - energy1 * switchingDeriv;
+            energy1 = energy1 * switchingValue;
+
+            SwitchFunctionB(switchingValue, switchingDeriv, distSquared);
+            force2 = force2 * switchingValue - energy2 * switchingDeriv;
+            energy2 = energy2 * switchingValue;
+          }
+
+          energyI1 += energy1;
+          energyI2 += energy2;
+
+          // Add this force into the atom forces.
+          Vector3D fij(diff * (force1 + force2));
+          forceI -= fij;
+          (*Base::forces)[j] += fij;
+
+          // compute the vector between molecular centers of mass
+          if (!same && doMolVirial)
+            // Add to the atomic and molecular virials
+            Base::energies->
+              addVirial(fij, diff, Base::realTopo->boundaryConditions.
+                        minimalDifference(Base::realTopo->molecules[mi].position,
+                                          Base::realTopo->molecules[mj].position));
+          else if (doVirial)
+            Base::energies->addVirial(fij, diff);
+
+          // End of force computation.
+          if (Constraint::POST_CHECK)
+            Constraint::check(Base::realTopo, i, j, diff, energy1 + energy2, fij);
+        }
+      }
+
+      // Add this energy into the total system energy.
+      Base::ForceFunction.accumulateEnergy(Base::energies, energyI1);
+      ForceFunctionB.accumulateEnergy(Base::energies, energyI2);
+      (*Base::forces)[i] += forceI;
+    }
+
+    /// doPairBlock() evaluating the forces of each chunk with the fused
+    /// kernel
+    template<bool CHECK>
+    void doPairBlockFused(const int i, const int *jBegin, const int *jEnd,
+                          ExclusionClass listExcl) {
+      const int mi = Base::realTopo->atoms[i].molecule;
+      const bool doMolVirial = Base::energies->molecularVirial();
+      const bool doVirial = Base::energies->virial();
+      Vector3D forceI(0.0, 0.0, 0.0);
+      Real energyI1 = 0.0, energyI2 = 0.0;
+      PairBlock block;
+      typename Kernel::Block kernelBlock;
+
+      while (jBegin != jEnd) {
+        unsigned int n = static_cast<unsigned int>(jEnd - jBegin);
+        if (n > PairBlock::SIZE) n = PairBlock::SIZE;
+        unsigned int m =
+          Base::gatherPairBlock(i, jBegin, n,
+                                SwitchA::USE || SwitchB::USE ||
+                                ForceA::CUTOFF || ForceB::CUTOFF, block);
+        jBegin += n;
+
+        // Drop the excluded pairs and collect the parameters of the others
+        unsigned int l = 0;
+        for (unsigned int k = 0; k < m; k++) {
+          const int j = block.j[k];
+          ExclusionClass excl = listExcl;
+          if (CHECK) {
+            int mj = Base::realTopo->atoms[j].molecule;
+            excl = (mi == mj ? Base::realTopo->exclusions.check(i, j) :
+                    EXCLUSION_NONE);
+            if (excl == EXCLUSION_FULL)
+              continue;
+          }
+
+          block.dx[l] = block.dx[k];
+          block.dy[l] = block.dy[k];
+          block.dz[l] = block.dz[k];
+          block.distSquared[l] = block.distSquared[k];
+          block.j[l] = j;
+          myKernel.set(kernelBlock, l, Base::realTopo, i, j, excl);
+          l++;
+        }
+
+        myKernel(kernelBlock, l, block.distSquared);
+
+        for (unsigned int k = 0; k < l; k++) {
+          const int j = block.j[k];
+          const Vector3D diff(block.dx[k], block.dy[k], block.dz[k]);
+
+          energyI1 += kernelBlock.energyA[k];
+          energyI2 += kernelBlock.energyB[k];
+
+          // Add this force into the atom forces.
+          Vector3D fij(diff * kernelBlock.force[k]);
+          forceI -= fij;
+          (*Base::forces)[j] += fij;
+
+          // compute the vector between molecular centers of mass
+          int mj = Base::realTopo->atoms[j].molecule;
+          if (mi != mj && doMolVirial)
+            // Add to the atomic and molecular virials
+            Base::energies->
+              addVirial(fij, diff, Base::realTopo->boundaryConditions.
+                        minimalDifference(Base::realTopo->molecules[mi].position,
+                                          Base::realTopo->molecules[mj].position));
+          else if (doVirial)
+            Base::energies->addVirial(fij, diff);
+
+          // End of force computation.
+          if (Constraint::POST_CHECK)
+            Constraint::check(Base::realTopo, i, j, diff,
+                              kernelBlock.energyA[k] + kernelBlock.energyB[k],
+                              fij);
+        }
+      }
+
+      // Add this energy into the total system energy.
+      Base::ForceFunction.accumulateEnergy(Base::energies, energyI1);
+      ForceFunctionB.accumulateEnergy(Base::energies, energyI2);
+      (*Base::forces)[i] += forceI;
+    }
+
   protected:
     SwitchB SwitchFunctionB;
     ForceB ForceFunctionB;
+    Kernel myKernel;
+  };
+
+  //____ OneAtomPairTwoKernel<C2, LennardJones, C1, Coulomb>
+
+  /// Lennard-Jones with C2 and Coulomb with C1 switching function
+  template<>
+  struct OneAtomPairTwoKernel<C2SwitchingFunction, LennardJonesForce,
+                              C1SwitchingFunction, CoulombForce> {
+    enum {USE = 1};
+
+    struct Block {
+      Real A[PairBlock::SIZE];
+      Real B[PairBlock::SIZE];
+      Real qq[PairBlock::SIZE];
+      Real scale[PairBlock::SIZE];
+      Real energyA[PairBlock::SIZE];
+      Real energyB[PairBlock::SIZE];
+      Real force[PairBlock::SIZE];
+    };
+
+    OneAtomPairTwoKernel() {}
+    OneAtomPairTwoKernel(const C2SwitchingFunction &switchLJ,
+                         const C1SwitchingFunction &switchCoulomb) :
+      kernel(switchLJ, switchCoulomb) {}
+
+    void set(Block &block, unsigned int k, const GenericTopology *topo,
+             int i, int j, ExclusionClass excl) const {
+      const LennardJonesParameters &
+      params = topo->lennardJonesParameters(topo->atoms[i].type,
+                                            topo->atoms[j].type);
+      if (excl != EXCLUSION_MODIFIED) {
+        block.A[k] = params.A;
+        block.B[k] = params.B;
+        block.scale[k] = 1.0;
+      } else {
+        block.A[k] = params.A14;
+        block.B[k] = params.B14;
+        block.scale[k] = topo->coulombScalingFactor;
+      }
+      block.qq[k] = topo->atoms[i].scaledCharge * topo->atoms[j].scaledCharge;
+    }
+
+    void operator()(Block &block, unsigned int n,
+                    const Real *distSquared) const {
+      kernel(n, distSquared, block.A, block.B, block.qq, block.scale,
+             block.energyA, block.energyB, block.force);
+    }
+
+    LennardJonesCoulombKernel kernel;
   };
 }
 
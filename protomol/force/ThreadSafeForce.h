@@ -0,0 +1,20 @@
+/* -*- c++ -*- */
+#ifndef THREADSAFEFORCE_H
+#define THREADSAFEFORCE_H
+
+namespace ProtoMol {
+  //____ ThreadSafeForce
+
+  /**
+   * Tells whether a pair potential may be evaluated concurrently by several
+   * threads, i.e. it reads the topology and writes nothing but the energy
+   * and force it returns. The threaded evaluations of the nonbonded system
+   * forces are only used for such potentials, a potential opts in by
+   * specializing this template.
+   */
+  template<class TForce>
+  struct ThreadSafeForce {
+    enum {VALUE = 0};
+  };
+}
+#endif /* THREADSAFEFORCE_H */
@@ -5,6 +5,8 @@
 #include <protomol/force/system/SystemForce.h>
 #include <protomol/type/ScalarStructure.h>
 #include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
+#include <protomol/topology/TopologyUtilities.h>
 
 namespace ProtoMol {
   //____ AngleSystemForce
@@ -14,6 +16,7 @@ namespace ProtoMol {
     // Constructors, destructors, assignment
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   public:
+    AngleSystemForce() : myDomainHalo(-1.0) {}
     virtual ~AngleSystemForce() {}
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -42,6 +45,13 @@ namespace ProtoMol {
                                   Vector3DBlock *forces,
                                   ScalarStructure *energies);
 
+    virtual Real getDomainHalo(const GenericTopology *topo,
+                               const Vector3DBlock *positions) {
+      if (myDomainHalo < 0.0)
+        myDomainHalo = bondedSpan(topo, positions, topo->angles);
+      return myDomainHalo;
+    }
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // From class Force
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -67,6 +77,8 @@ namespace ProtoMol {
     // My data members
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   private:
+    ThreadForceBuffers myBuffers;
+    Real myDomainHalo;
   };
 
   //____ INLINES
@@ -79,6 +91,29 @@ namespace ProtoMol {
     const TBoundaryConditions &boundary =
       ((SemiGenericTopology<TBoundaryConditions> &)(*topo)).
         boundaryConditions;
+
+    const int threads = ThreadForceBuffers::getNumThreads();
+    if (threads > 1) {
+      // Each thread adds into its own buffers, reduced at the end
+      const int n = static_cast<int>(topo->angles.size());
+      myBuffers.initialize(threads, positions->size(), energies);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+      {
+        const int t = ThreadForceBuffers::getThreadId();
+        Vector3DBlock *f = myBuffers.forces(t);
+        ScalarStructure *e = myBuffers.energies(t);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < n; i++)
+          calcAngle(boundary, topo->angles[i], positions, f, e);
+      }
+      myBuffers.reduce(forces, energies);
+      return;
+    }
+
     for (unsigned int i = 0; i < topo->angles.size(); i++)
       calcAngle(boundary, topo->angles[i], positions, forces, energies);
   }
@@ -225,8 +260,11 @@ namespace ProtoMol {
         if (to > static_cast<int>(n))
           to = n;
         int from = (n * i) / count;
-        for (int j = from; j < to; j++)
-          calcAngle(boundary, topo->angles[j], positions, forces, energies);
+        for (int j = from; j < to; j++) {
+          const Angle &term = topo->angles[j];
+          if (topo->isOwnedTerm(term.atom1, term.atom2, term.atom3))
+            calcAngle(boundary, term, positions, forces, energies);
+        }
       }
   }
 
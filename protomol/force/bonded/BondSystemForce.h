@@ -5,6 +5,8 @@
 #include <protomol/force/system/SystemForce.h>
 #include <protomol/type/ScalarStructure.h>
 #include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
+#include <protomol/topology/TopologyUtilities.h>
 
 #include <string>
 
@@ -17,6 +19,7 @@ namespace ProtoMol {
     // Constructors, destructors, assignment
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   public:
+    BondSystemForce() : myDomainHalo(-1.0) {}
     virtual ~BondSystemForce() {}
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -45,6 +48,13 @@ namespace ProtoMol {
                                   Vector3DBlock *forces,
                                   ScalarStructure *energies);
 
+    virtual Real getDomainHalo(const GenericTopology *topo,
+                               const Vector3DBlock *positions) {
+      if (myDomainHalo < 0.0)
+        myDomainHalo = bondedSpan(topo, positions, topo->bonds);
+      return myDomainHalo;
+    }
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // From class Force
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -70,6 +80,8 @@ namespace ProtoMol {
     // My data members
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   private:
+    ThreadForceBuffers myBuffers;
+    Real myDomainHalo;
   };
 
   //____ INLINES
@@ -78,10 +90,33 @@ namespace ProtoMol {
   inline void BondSystemForce<TBoundaryConditions>::evaluate(
     const GenericTopology *topo, const Vector3DBlock *positions,
     Vector3DBlock *forces, ScalarStructure *energies) {
+
     const TBoundaryConditions &boundary =
       ((SemiGenericTopology<TBoundaryConditions> &)(*topo)).
         boundaryConditions;
 
+    const int threads = ThreadForceBuffers::getNumThreads();
+    if (threads > 1) {
+      // Each thread adds into its own buffers, reduced at the end
+      const int n = static_cast<int>(topo->bonds.size());
+      myBuffers.initialize(threads, positions->size(), energies);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+      {
+        const int t = ThreadForceBuffers::getThreadId();
+        Vector3DBlock *f = myBuffers.forces(t);
+        ScalarStructure *e = myBuffers.energies(t);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < n; i++)
+          calcBond(boundary, topo->bonds[i], positions, f, e);
+      }
+      myBuffers.reduce(forces, energies);
+      return;
+    }
+
     for (unsigned int i = 0; i < topo->bonds.size(); i++)
       calcBond(boundary, topo->bonds[i], positions, forces, energies);
   }
@@ -159,8 +194,11 @@ namespace ProtoMol {
         if (to > static_cast<int>(n))
           to = n;
         int from = (n * i) / count;
-        for (int j = from; j < to; j++)
-          calcBond(boundary, topo->bonds[j], positions, forces, energies);
+        for (int j = from; j < to; j++) {
+          const Bond &term = topo->bonds[j];
+          if (topo->isOwnedTerm(term.atom1, term.atom2))
+            calcBond(boundary, term, positions, forces, energies);
+        }
       }
   }
 
@@ -0,0 +1,327 @@
+/* -*- c++ -*- */
+#ifndef BONDEDALLSYSTEMFORCE_H
+#define BONDEDALLSYSTEMFORCE_H
+
+#include <protomol/force/system/SystemForce.h>
+#include <protomol/force/bonded/BondedTermPack.h>
+#include <protomol/force/bonded/BondSystemForce.h>
+#include <protomol/force/bonded/AngleSystemForce.h>
+#include <protomol/force/bonded/DihedralSystemForce.h>
+#include <protomol/force/bonded/RBDihedralSystemForce.h>
+#include <protomol/type/ScalarStructure.h>
+#include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
+#include <protomol/topology/SemiGenericTopology.h>
+#include <protomol/topology/TopologyUtilities.h>
+#include <protomol/topology/Bond.h>
+#include <protomol/topology/Angle.h>
+#include <protomol/topology/Torsion.h>
+#include <protomol/topology/RBTorsion.h>
+
+#include <string>
+#include <vector>
+
+namespace ProtoMol {
+  //____ BondedAllSystemForce
+
+  /**
+   * All bonded terms of the topology, bonds, angles, dihedrals, impropers
+   * and Ryckaert-Bellemans dihedrals, in one force. Same as the forces
+   * Bond, Angle, Dihedral, Improper and RBDihedral together.
+   *
+   * The atoms are split into blocks of ATOMS_PER_BLOCK atoms, each term
+   * goes to the block of its lowest atom. One sweep over the blocks
+   * evaluates all terms of a block, of all types, before the next block,
+   * such that the positions and forces of the block stay in cache. With
+   * OpenMP the blocks are split over the threads. The terms are evaluated
+   * by the per-term methods of the separate forces.
+   */
+  template<class TBoundaryConditions>
+  class BondedAllSystemForce : public SystemForce {
+  public:
+    enum {ATOMS_PER_BLOCK = 64};
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    BondedAllSystemForce() :
+      myDomainHalo(-1.0), myNumBlocks(0), myPacked(false) {}
+    virtual ~BondedAllSystemForce() {}
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class BondedAllSystemForce
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    void pack(const GenericTopology *topo, const Vector3DBlock *positions);
+
+    void evaluateBlock(const TBoundaryConditions &boundary, unsigned int b,
+                       const Vector3DBlock *positions, Vector3DBlock *forces,
+                       ScalarStructure *energies);
+
+    void evaluateOwnedBlock(const GenericTopology *topo,
+                            const TBoundaryConditions &boundary,
+                            unsigned int b, const Vector3DBlock *positions,
+                            Vector3DBlock *forces, ScalarStructure *energies);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class SystemForce
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    using SystemForce::evaluate; // Avoid compiler warning/error
+    virtual void evaluate(const GenericTopology *topo,
+                          const Vector3DBlock *positions, Vector3DBlock *forces,
+                          ScalarStructure *energies);
+
+    virtual void parallelEvaluate(const GenericTopology *topo,
+                                  const Vector3DBlock *positions,
+                                  Vector3DBlock *forces,
+                                  ScalarStructure *energies);
+
+    virtual Real getDomainHalo(const GenericTopology *topo,
+                               const Vector3DBlock *positions);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class Force
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    virtual std::string getKeyword() const {return "BondedAll";}
+
+    virtual void uncache() {myPacked = false;}
+
+    virtual unsigned int numberOfBlocks(const GenericTopology *topo,
+                                        const Vector3DBlock *pos);
+
+  private:
+    virtual Force *doMake(const std::vector<Value> &) const {
+      return new BondedAllSystemForce();
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class Makeable
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    virtual std::string getIdNoAlias() const {return getKeyword();}
+    virtual void getParameters(std::vector<Parameter> &) const {}
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    ThreadForceBuffers myBuffers;
+    // Evaluate the terms, calcTorsion() the dihedrals and impropers
+    BondSystemForce<TBoundaryConditions> myBondForce;
+    AngleSystemForce<TBoundaryConditions> myAngleForce;
+    DihedralSystemForce<TBoundaryConditions> myTorsionForce;
+    RBDihedralSystemForce<TBoundaryConditions> myRBDihedralForce;
+
+    std::vector<Bond> myBonds;
+    std::vector<Angle> myAngles;
+    std::vector<Torsion> myDihedrals;
+    std::vector<Torsion> myImpropers;
+    std::vector<RBTorsion> myRBDihedrals;
+
+    // First term of each atom block, per type
+    std::vector<unsigned int> myBondsFirst;
+    std::vector<unsigned int> myAnglesFirst;
+    std::vector<unsigned int> myDihedralsFirst;
+    std::vector<unsigned int> myImpropersFirst;
+    std::vector<unsigned int> myRBDihedralsFirst;
+
+    Real myDomainHalo;
+    unsigned int myNumBlocks;
+    bool myPacked;
+  };
+
+  //____ INLINES
+
+  template<class TBoundaryConditions>
+  inline void BondedAllSystemForce<TBoundaryConditions>::pack(
+    const GenericTopology *topo, const Vector3DBlock *positions) {
+    // Pack the terms once, again if the topology changed
+    const unsigned int numBlocks =
+      (positions->size() + ATOMS_PER_BLOCK - 1) / ATOMS_PER_BLOCK;
+    if (myPacked && myNumBlocks == numBlocks &&
+        myBonds.size() == topo->bonds.size() &&
+        myAngles.size() == topo->angles.size() &&
+        myDihedrals.size() == topo->dihedrals.size() &&
+        myImpropers.size() == topo->impropers.size() &&
+        myRBDihedrals.size() == topo->rb_dihedrals.size())
+      return;
+
+    myNumBlocks = numBlocks;
+    BondedTermPack::pack(topo->bonds, ATOMS_PER_BLOCK, numBlocks, myBonds,
+                         myBondsFirst);
+    BondedTermPack::pack(topo->angles, ATOMS_PER_BLOCK, numBlocks, myAngles,
+                         myAnglesFirst);
+    BondedTermPack::pack(topo->dihedrals, ATOMS_PER_BLOCK, numBlocks,
+                         myDihedrals, myDihedralsFirst);
+    BondedTermPack::pack(topo->impropers, ATOMS_PER_BLOCK, numBlocks,
+                         myImpropers, myImpropersFirst);
+    BondedTermPack::pack(topo->rb_dihedrals, ATOMS_PER_BLOCK, numBlocks,
+                         myRBDihedrals, myRBDihedralsFirst);
+    myPacked = true;
+  }
+
+  template<class TBoundaryConditions>
+  inline void BondedAllSystemForce<TBoundaryConditions>::evaluateBlock(
+    const TBoundaryConditions &boundary, unsigned int b,
+    const Vector3DBlock *positions, Vector3DBlock *forces,
+    ScalarStructure *energies) {
+    for (unsigned int k = myBondsFirst[b]; k < myBondsFirst[b + 1]; k++)
+      myBondForce.calcBond(boundary, myBonds[k], positions, forces, energies);
+
+    for (unsigned int k = myAnglesFirst[b]; k < myAnglesFirst[b + 1]; k++)
+      myAngleForce.calcAngle(boundary, myAngles[k], positions, forces,
+                             energies);
+
+    for (unsigned int k = myDihedralsFirst[b]; k < myDihedralsFirst[b + 1];
+         k++)
+      myTorsionForce.calcTorsion(boundary, myDihedrals[k], positions, forces,
+                                 (*energies)[ScalarStructure::DIHEDRAL],
+                                 energies);
+
+    for (unsigned int k = myImpropersFirst[b]; k < myImpropersFirst[b + 1];
+         k++)
+      myTorsionForce.calcTorsion(boundary, myImpropers[k], positions, forces,
+                                 (*energies)[ScalarStructure::IMPROPER],
+                                 energies);
+
+    for (unsigned int k = myRBDihedralsFirst[b];
+         k < myRBDihedralsFirst[b + 1]; k++)
+      myRBDihedralForce.calcRBTorsion(boundary, myRBDihedrals[k], positions,
+                                      forces,
+                                      (*energies)[ScalarStructure::DIHEDRAL],
+                                      energies);
+  }
+
+  template<class TBoundaryConditions>
+  inline void BondedAllSystemForce<TBoundaryConditions>::evaluateOwnedBlock(
+    const GenericTopology *topo, const TBoundaryConditions &boundary,
+    unsigned int b, const Vector3DBlock *positions, Vector3DBlock *forces,
+    ScalarStructure *energies) {
+    // Only the terms owned by this node
+    for (unsigned int k = myBondsFirst[b]; k < myBondsFirst[b + 1]; k++) {
+      const Bond &term = myBonds[k];
+      if (topo->isOwnedTerm(term.atom1, term.atom2))
+        myBondForce.calcBond(boundary, term, positions, forces, energies);
+    }
+
+    for (unsigned int k = myAnglesFirst[b]; k < myAnglesFirst[b + 1]; k++) {
+      const Angle &term = myAngles[k];
+      if (topo->isOwnedTerm(term.atom1, term.atom2, term.atom3))
+        myAngleForce.calcAngle(boundary, term, positions, forces, energies);
+    }
+
+    for (unsigned int k = myDihedralsFirst[b]; k < myDihedralsFirst[b + 1];
+         k++) {
+      const Torsion &term = myDihedrals[k];
+      if (topo->isOwnedTerm(term.atom1, term.atom2, term.atom3, term.atom4))
+        myTorsionForce.calcTorsion(boundary, term, positions, forces,
+                                   (*energies)[ScalarStructure::DIHEDRAL],
+                                   energies);
+    }
+
+    for (unsigned int k = myImpropersFirst[b]; k < myImpropersFirst[b + 1];
+         k++) {
+      const Torsion &term = myImpropers[k];
+      if (topo->isOwnedTerm(term.atom1, term.atom2, term.atom3, term.atom4))
+        myTorsionForce.calcTorsion(boundary, term, positions, forces,
+                                   (*energies)[ScalarStructure::IMPROPER],
+                                   energies);
+    }
+
+    for (unsigned int k = myRBDihedralsFirst[b];
+         k < myRBDihedralsFirst[b + 1]; k++) {
+      const RBTorsion &term = myRBDihedrals[k];
+      if (topo->isOwnedTerm(term.atom1, term.atom2, term.atom3, term.atom4))
+        myRBDihedralForce.calcRBTorsion(boundary, term, positions, forces,
+                                        (*energies)[ScalarStructure::DIHEDRAL],
+                                        energies);
+    }
+  }
+
+  template<class TBoundaryConditions>
+  inline void BondedAllSystemForce<TBoundaryConditions>::evaluate(
+    const GenericTopology *topo, const Vector3DBlock *positions,
+    Vector3DBlock *forces, ScalarStructure *energies) {
+
+    const TBoundaryConditions &boundary =
+      ((SemiGenericTopology<TBoundaryConditions> &)(*topo)).
+        boundaryConditions;
+
+    pack(topo, positions);
+
+    const int threads = ThreadForceBuffers::getNumThreads();
+    if (threads > 1) {
+      // Each thread adds into its own buffers, reduced at the end
+      const int n = static_cast<int>(myNumBlocks);
+      myBuffers.initialize(threads, positions->size(), energies);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+      {
+        const int t = ThreadForceBuffers::getThreadId();
+        Vector3DBlock *f = myBuffers.forces(t);
+        ScalarStructure *e = myBuffers.energies(t);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int b = 0; b < n; b++)
+          evaluateBlock(boundary, b, positions, f, e);
+      }
+      myBuffers.reduce(forces, energies);
+      return;
+    }
+
+    for (unsigned int b = 0; b < myNumBlocks; b++)
+      evaluateBlock(boundary, b, positions, forces, energies);
+  }
+
+  template<class TBoundaryConditions>
+  inline void BondedAllSystemForce<TBoundaryConditions>::parallelEvaluate(
+    const GenericTopology *topo, const Vector3DBlock *positions,
+    Vector3DBlock *forces, ScalarStructure *energies) {
+    const TBoundaryConditions &boundary =
+      (dynamic_cast<const SemiGenericTopology<TBoundaryConditions> &>(*topo)).
+        boundaryConditions;
+
+    pack(topo, positions);
+
+    unsigned int n = myNumBlocks;
+    unsigned int count = numberOfBlocks(topo, positions);
+
+    for (unsigned int i = 0; i < count; i++)
+      if (Parallel::next()) {
+        int to = (n * (i + 1)) / count;
+        if (to > static_cast<int>(n))
+          to = n;
+        int from = (n * i) / count;
+        for (int b = from; b < to; b++)
+          evaluateOwnedBlock(topo, boundary, b, positions, forces, energies);
+      }
+  }
+
+  template<class TBoundaryConditions>
+  inline Real BondedAllSystemForce<TBoundaryConditions>::getDomainHalo(
+    const GenericTopology *topo, const Vector3DBlock *positions) {
+    if (myDomainHalo < 0.0) {
+      Real halo = bondedSpan(topo, positions, topo->bonds);
+      halo = std::max(halo, bondedSpan(topo, positions, topo->angles));
+      halo = std::max(halo, bondedSpan(topo, positions, topo->dihedrals));
+      halo = std::max(halo, bondedSpan(topo, positions, topo->impropers));
+      halo = std::max(halo, bondedSpan(topo, positions, topo->rb_dihedrals));
+      myDomainHalo = halo;
+    }
+    return myDomainHalo;
+  }
+
+  template<class TBoundaryConditions>
+  inline unsigned int BondedAllSystemForce<TBoundaryConditions>::
+  numberOfBlocks(const GenericTopology *, const Vector3DBlock *pos) {
+    return std::min(Parallel::getAvailableNum(),
+                    static_cast<int>((pos->size() + ATOMS_PER_BLOCK - 1) /
+                                     ATOMS_PER_BLOCK));
+  }
+}
+#endif /* BONDEDALLSYSTEMFORCE_H */
@@ -0,0 +1,72 @@
+#include <protomol/force/bonded/BondedTermPack.h>
+
+#include <protomol/topology/Bond.h>
+#include <protomol/topology/Angle.h>
+#include <protomol/topology/Torsion.h>
+#include <protomol/topology/RBTorsion.h>
+
+#include <algorithm>
+
+using namespace std;
+using namespace ProtoMol;
+
+//____ Order of the terms
+
+namespace {
+  int lowestAtom(const Bond &t) {return min(t.atom1, t.atom2);}
+
+  int lowestAtom(const Angle &t) {return min(t.atom1, min(t.atom2, t.atom3));}
+
+  int lowestAtom(const Torsion &t) {
+    return min(min(t.atom1, t.atom2), min(t.atom3, t.atom4));
+  }
+
+  int lowestAtom(const RBTorsion &t) {
+    return min(min(t.atom1, t.atom2), min(t.atom3, t.atom4));
+  }
+
+  // Counting sort by the block of the lowest atom, keeps the topology
+  // order within a block
+  template<class T>
+  void blockOrder(const vector<T> &terms, unsigned int atomsPerBlock,
+                  unsigned int numBlocks, vector<T> &pack,
+                  vector<unsigned int> &first) {
+    first.assign(numBlocks + 1, 0);
+    for (unsigned int i = 0; i < terms.size(); i++)
+      first[lowestAtom(terms[i]) / atomsPerBlock + 1]++;
+    for (unsigned int b = 0; b < numBlocks; b++)
+      first[b + 1] += first[b];
+
+    vector<unsigned int> next(first.begin(), first.end() - 1);
+    pack.resize(terms.size());
+    for (unsigned int i = 0; i < terms.size(); i++)
+      pack[next[lowestAtom(terms[i]) / atomsPerBlock]++] = terms[i];
+  }
+}
+
+//____ BondedTermPack
+
+void BondedTermPack::pack(const vector<Bond> &bonds, unsigned int atomsPerBlock,
+                          unsigned int numBlocks, vector<Bond> &pack,
+                          vector<unsigned int> &first) {
+  blockOrder(bonds, atomsPerBlock, numBlocks, pack, first);
+}
+
+void BondedTermPack::pack(const vector<Angle> &angles,
+                          unsigned int atomsPerBlock, unsigned int numBlocks,
+                          vector<Angle> &pack, vector<unsigned int> &first) {
+  blockOrder(angles, atomsPerBlock, numBlocks, pack, first);
+}
+
+void BondedTermPack::pack(const vector<Torsion> &torsions,
+                          unsigned int atomsPerBlock, unsigned int numBlocks,
+                          vector<Torsion> &pack, vector<unsigned int> &first) {
+  blockOrder(torsions, atomsPerBlock, numBlocks, pack, first);
+}
+
+void BondedTermPack::pack(const vector<RBTorsion> &torsions,
+                          unsigned int atomsPerBlock, unsigned int numBlocks,
+                          vector<RBTorsion> &pack,
+                          vector<unsigned int> &first) {
+  blockOrder(torsions, atomsPerBlock, numBlocks, pack, first);
+}
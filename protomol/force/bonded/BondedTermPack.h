@@ -0,0 +1,43 @@
+/*  -*- c++ -*-  */
+#ifndef BONDEDTERMPACK_H
+#define BONDEDTERMPACK_H
+
+#include <vector>
+
+namespace ProtoMol {
+  class Bond;
+  class Angle;
+  class Torsion;
+  class RBTorsion;
+
+  //____ BondedTermPack
+
+  /**
+   * Copies of the bonded terms of a topology grouped by the block of their
+   * lowest atom, for BondedAllSystemForce. The terms of atom block b are
+   * first[b] to first[b + 1], in topology order.
+   */
+  class BondedTermPack {
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class BondedTermPack
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    static void pack(const std::vector<Bond> &bonds,
+                     unsigned int atomsPerBlock, unsigned int numBlocks,
+                     std::vector<Bond> &pack,
+                     std::vector<unsigned int> &first);
+    static void pack(const std::vector<Angle> &angles,
+                     unsigned int atomsPerBlock, unsigned int numBlocks,
+                     std::vector<Angle> &pack,
+                     std::vector<unsigned int> &first);
+    static void pack(const std::vector<Torsion> &torsions,
+                     unsigned int atomsPerBlock, unsigned int numBlocks,
+                     std::vector<Torsion> &pack,
+                     std::vector<unsigned int> &first);
+    static void pack(const std::vector<RBTorsion> &torsions,
+                     unsigned int atomsPerBlock, unsigned int numBlocks,
+                     std::vector<RBTorsion> &pack,
+                     std::vector<unsigned int> &first);
+  };
+}
+#endif /* BONDEDTERMPACK_H */
@@ -5,6 +5,8 @@
 #include <protomol/force/bonded/MTorsionSystemForce.h>
 #include <protomol/type/ScalarStructure.h>
 #include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
+#include <protomol/topology/TopologyUtilities.h>
 #include <protomol/topology/SemiGenericTopology.h>
 
 #include <string>
@@ -15,6 +17,7 @@ namespace ProtoMol {
   template<class TBoundaryConditions>
   class ImproperSystemForce : public MTorsionSystemForce<TBoundaryConditions> {
   public:
+    ImproperSystemForce() : myDomainHalo(-1.0) {}
     virtual ~ImproperSystemForce() {}
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -32,6 +35,13 @@ namespace ProtoMol {
                                   Vector3DBlock *forces,
                                   ScalarStructure *energies);
 
+    virtual Real getDomainHalo(const GenericTopology *topo,
+                               const Vector3DBlock *positions) {
+      if (myDomainHalo < 0.0)
+        myDomainHalo = bondedSpan(topo, positions, topo->impropers);
+      return myDomainHalo;
+    }
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // From class Force
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -57,6 +67,8 @@ namespace ProtoMol {
     // My data members
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   private:
+    ThreadForceBuffers myBuffers;
+    Real myDomainHalo;
   };
 
   //____ INLINES
@@ -65,9 +77,34 @@ namespace ProtoMol {
   inline void ImproperSystemForce<TBoundaryConditions>::evaluate(
     const GenericTopology *topo, const Vector3DBlock *positions,
     Vector3DBlock *forces, ScalarStructure *energies) {
+
     const TBoundaryConditions &boundary =
       ((SemiGenericTopology<TBoundaryConditions> &)(*topo)).
         boundaryConditions;
+
+    const int threads = ThreadForceBuffers::getNumThreads();
+    if (threads > 1) {
+      // Each thread adds into its own buffers, reduced at the end
+      const int n = static_cast<int>(topo->impropers.size());
+      myBuffers.initialize(threads, positions->size(), energies);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+      {
+        const int t = ThreadForceBuffers::getThreadId();
+        Vector3DBlock *f = myBuffers.forces(t);
+        ScalarStructure *e = myBuffers.energies(t);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < n; i++)
+          this->calcTorsion(boundary, topo->impropers[i], positions, f,
+                            (*e)[ScalarStructure::IMPROPER], e);
+      }
+      myBuffers.reduce(forces, energies);
+      return;
+    }
+
     for (unsigned int i = 0; i < topo->impropers.size(); i++)
       this->calcTorsion(boundary, topo->impropers[i], positions, forces,
                   (*energies)[ScalarStructure::IMPROPER], energies);
@@ -90,9 +127,12 @@ namespace ProtoMol {
         if (to > static_cast<int>(n))
           to = n;
         int from = (n * i) / count;
-        for (int j = from; j < to; j++)
-          this->calcTorsion(boundary, topo->impropers[j], positions, forces,
-                      (*energies)[ScalarStructure::IMPROPER], energies);
+        for (int j = from; j < to; j++) {
+          const Torsion &term = topo->impropers[j];
+          if (topo->isOwnedTerm(term.atom1, term.atom2, term.atom3, term.atom4))
+            this->calcTorsion(boundary, term, positions, forces,
+                        (*energies)[ScalarStructure::IMPROPER], energies);
+        }
       }
   }
 
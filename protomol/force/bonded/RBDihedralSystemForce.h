@@ -5,6 +5,8 @@
 #include <protomol/force/system/SystemForce.h>
 #include <protomol/type/ScalarStructure.h>
 #include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
+#include <protomol/topology/TopologyUtilities.h>
 #include <protomol/topology/SemiGenericTopology.h>
 #include <protomol/topology/RBTorsion.h>
 
@@ -19,6 +21,7 @@ namespace ProtoMol {
     // Constructors, destructors, assignment
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   public:
+    RBDihedralSystemForce() : myDomainHalo(-1.0) {}
     virtual ~RBDihedralSystemForce() {}
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -35,6 +38,13 @@ namespace ProtoMol {
                                   Vector3DBlock *forces,
                                   ScalarStructure *energies);
 
+    virtual Real getDomainHalo(const GenericTopology *topo,
+                               const Vector3DBlock *positions) {
+      if (myDomainHalo < 0.0)
+        myDomainHalo = bondedSpan(topo, positions, topo->rb_dihedrals);
+      return myDomainHalo;
+    }
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // From class Force
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -223,6 +233,8 @@ namespace ProtoMol {
     // My data members
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   private:
+    ThreadForceBuffers myBuffers;
+    Real myDomainHalo;
   };
 
   //____ INLINES
@@ -236,6 +248,29 @@ namespace ProtoMol {
       ((SemiGenericTopology<TBoundaryConditions> &)(*topo)).
         boundaryConditions;
 
+    const int threads = ThreadForceBuffers::getNumThreads();
+    if (threads > 1) {
+      // Each thread adds into its own buffers, reduced at the end
+      const int count = static_cast<int>(topo->rb_dihedrals.size());
+      myBuffers.initialize(threads, positions->size(), energies);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+      {
+        const int t = ThreadForceBuffers::getThreadId();
+        Vector3DBlock *f = myBuffers.forces(t);
+        ScalarStructure *e = myBuffers.energies(t);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < count; i++)
+          calcRBTorsion(boundary, topo->rb_dihedrals[i], positions, f,
+                        (*e)[ScalarStructure::DIHEDRAL], e);
+      }
+      myBuffers.reduce(forces, energies);
+      return;
+    }
+
     unsigned int n = topo->rb_dihedrals.size();
 
     for (unsigned int i = 0; i < n; i++) {
@@ -261,9 +296,12 @@ namespace ProtoMol {
         if (to > static_cast<int>(n))
           to = n;
         int from = (n * i) / count;
-        for (int j = from; j < to; j++)
-          calcRBTorsion(boundary, topo->rb_dihedrals[j], positions, forces,
-                      (*energies)[ScalarStructure::DIHEDRAL], energies);
+        for (int j = from; j < to; j++) {
+          const RBTorsion &term = topo->rb_dihedrals[j];
+          if (topo->isOwnedTerm(term.atom1, term.atom2, term.atom3, term.atom4))
+            calcRBTorsion(boundary, term, positions, forces,
+                        (*energies)[ScalarStructure::DIHEDRAL], energies);
+        }
       }
   }
 
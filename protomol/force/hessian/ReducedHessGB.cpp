@@ -14,6 +14,7 @@ using namespace std;
 Matrix3By3 ReducedHessGB::operator()( Real a,
                                           const Vector3D &rij,
                                           const GenericTopology *topo,
+                                          const Vector3DBlock *positions,
                                           int atom1, int atom2,
                                           int numatoms,
                                           Real soluteDielec, Real solventDielec,
@@ -50,9 +51,20 @@ Matrix3By3 ReducedHessGB::operator()( Real a,
 
    Real tanhparam_i_derv = topo->alphaObc - 2*topo->betaObc*psi_i + 3*topo->gammaObc*psi_i*psi_i;
 
-   //data required for the second derivative of the burial term
-   Real Lij = topo->atoms[atom1].myGBSA_T->Lvalues[atom2];
-   Real Uij = topo->atoms[atom1].myGBSA_T->Uvalues[atom2];
+     //Scaling factors
+     Real S_i = topo->atoms[atom1].myGBSA_T->scalingFactor;
+     Real S_j = topo->atoms[atom2].myGBSA_T->scalingFactor;
+
+   //data required for the second derivative of the burial term, as in GBBornRadii
+   Real Lij, Uij;
+
+   if (offsetRadius_i >= dist + S_j*offsetRadius_j) {
+     Lij = 1;
+     Uij = 1;
+   }else {
+     Lij = (offsetRadius_i > fabs(dist - S_j*offsetRadius_j)) ? offsetRadius_i : fabs(dist - S_j*offsetRadius_j);
+     Uij = dist + S_j*offsetRadius_j;
+   }
 
    Real invLij = 1/Lij;
    Real invUij = 1/Uij;
@@ -60,10 +72,6 @@ Matrix3By3 ReducedHessGB::operator()( Real a,
    //Derivatives for calculation of the derivative of the born radii
    Real dLijdrij, dUijdrij, dCijdrij;
 
-     //Scaling factors
-     Real S_i = topo->atoms[atom1].myGBSA_T->scalingFactor;
-     Real S_j = topo->atoms[atom2].myGBSA_T->scalingFactor;
-
   //Check Equations (11-13)
    if (offsetRadius_i <= (dist - S_j*offsetRadius_j)) dLijdrij = 1;
    else dLijdrij = 0;
@@ -103,8 +111,15 @@ Matrix3By3 ReducedHessGB::operator()( Real a,
   Real d2Ridrij2 =  2*(1 - tanh_i*tanh_i)*(1-tanh_i*tanh_i)*power(psiderv_i_ij,2)*power(tanhparam_i_derv,2)*(power(bornRad_i,3)/power(radius_i,2)) -2*power(bornRad_i,2)*tanh_i*(1 - tanh_i*tanh_i)*power(psiderv_i_ij,2)*power(tanhparam_i_derv,2)*(1/radius_i) + (power(bornRad_i,2)/radius_i)*(1 - power(tanh_i,2))*(alpha*d2Psi_i_drij2 - 2*beta*power(psiderv_i_ij,2)- 2*beta*psi_i*d2Psi_i_drij2) + (power(bornRad_i,2)/radius_i)*(1 - power(tanh_i,2))*(6*gamma*psi_i*power(psiderv_i_ij,2) + 3*gamma*power(psi_i,2)*d2Psi_i_drij2);
 
    //data required for the second derivative of the burial term
-   Real Lji = topo->atoms[atom2].myGBSA_T->Lvalues[atom1];
-   Real Uji = topo->atoms[atom2].myGBSA_T->Uvalues[atom1];
+   Real Lji, Uji;
+
+   if (offsetRadius_j >= dist + S_i*offsetRadius_i) {
+     Lji = 1;
+     Uji = 1;
+   }else {
+     Lji = (offsetRadius_j > fabs(dist - S_i*offsetRadius_i)) ? offsetRadius_j : fabs(dist - S_i*offsetRadius_i);
+     Uji = dist + S_i*offsetRadius_i;
+   }
 
    Real invLji = 1/Lji;
    Real invUji = 1/Uji;
@@ -194,45 +209,45 @@ Matrix3By3 ReducedHessGB::operator()( Real a,
   //summation of first derivatives
   //new N^2 handeling of interaction with other atoms
   if (!topo->atoms[atom1].myGBSA_T->havePartialGBForceTerms) {
-    topo->atoms[atom1].myGBSA_T->partialGBForceTerms = FirstDerivativeFGB(topo, atom1);
+    topo->atoms[atom1].myGBSA_T->partialGBForceTerms = FirstDerivativeFGB(topo, positions, atom1);
     topo->atoms[atom1].myGBSA_T->havePartialGBForceTerms = true;
   }
 
-  dGikterm += ( topo->atoms[atom1].myGBSA_T->partialGBForceTerms - FirstDerivativeFGBSumError(topo, atom1, atom2) ) * bornRadiusDerivative_ij;
+  dGikterm += ( topo->atoms[atom1].myGBSA_T->partialGBForceTerms - FirstDerivativeFGBSumError(topo, atom1, atom2, dist) ) * bornRadiusDerivative_ij;
   
   if (!topo->atoms[atom2].myGBSA_T->havePartialGBForceTerms) {
-    topo->atoms[atom2].myGBSA_T->partialGBForceTerms = FirstDerivativeFGB(topo, atom2);
+    topo->atoms[atom2].myGBSA_T->partialGBForceTerms = FirstDerivativeFGB(topo, positions, atom2);
     topo->atoms[atom2].myGBSA_T->havePartialGBForceTerms = true;
   }
 
-  dGjkterm += ( topo->atoms[atom2].myGBSA_T->partialGBForceTerms - FirstDerivativeFGBSumError(topo, atom2, atom1) )* bornRadiusDerivative_ji; 
+  dGjkterm += ( topo->atoms[atom2].myGBSA_T->partialGBForceTerms - FirstDerivativeFGBSumError(topo, atom2, atom1, dist) )* bornRadiusDerivative_ji; 
   
   //summation of second derivatives
   //Atom i
   //new N^2 handeling of interaction with other atoms
   if (!topo->atoms[atom1].myGBSA_T->havePartialGBHessianTerms) {
-    const secondDerivativeRawTerms sdrtatom = SecondDerivativeFGB(topo, atom1);
+    const secondDerivativeRawTerms sdrtatom = SecondDerivativeFGB(topo, positions, atom1);
     topo->atoms[atom1].myGBSA_T->partialGBHessianTerms_term1 = sdrtatom.term1;
     topo->atoms[atom1].myGBSA_T->partialGBHessianTerms_term2 = sdrtatom.term2;
     topo->atoms[atom1].myGBSA_T->havePartialGBHessianTerms = true;
   }
 
-  //const secondDerivativeRawTerms sdrtatom1 = SecondDerivativeFGB(topo, atom1);
-  const secondDerivativeRawTerms sdrtatom1Err = SecondDerivativeFGBSumError(topo, atom1, atom2);
+  //const secondDerivativeRawTerms sdrtatom1 = SecondDerivativeFGB(topo, positions, atom1);
+  const secondDerivativeRawTerms sdrtatom1Err = SecondDerivativeFGBSumError(topo, atom1, atom2, dist);
   d2Gikterm += (topo->atoms[atom1].myGBSA_T->partialGBHessianTerms_term1 - sdrtatom1Err.term1) * d2Ridrij2;
   d2Gikterm += (topo->atoms[atom1].myGBSA_T->partialGBHessianTerms_term2 - sdrtatom1Err.term2) * bornRadiusDerivative_ij * bornRadiusDerivative_ij;
   
   //Atom j
   //new N^2 handeling of interaction with other atoms
   if (!topo->atoms[atom2].myGBSA_T->havePartialGBHessianTerms) {
-   const secondDerivativeRawTerms sdrtatom = SecondDerivativeFGB(topo, atom2);
+   const secondDerivativeRawTerms sdrtatom = SecondDerivativeFGB(topo, positions, atom2);
    topo->atoms[atom2].myGBSA_T->partialGBHessianTerms_term1 = sdrtatom.term1;
    topo->atoms[atom2].myGBSA_T->partialGBHessianTerms_term2 = sdrtatom.term2;
    topo->atoms[atom2].myGBSA_T->havePartialGBHessianTerms = true;
   }
   
-  //const secondDerivativeRawTerms sdrtatom2 = SecondDerivativeFGB(topo, atom2);
-  const secondDerivativeRawTerms sdrtatom2Err = SecondDerivativeFGBSumError(topo, atom2, atom1);
+  //const secondDerivativeRawTerms sdrtatom2 = SecondDerivativeFGB(topo, positions, atom2);
+  const secondDerivativeRawTerms sdrtatom2Err = SecondDerivativeFGBSumError(topo, atom2, atom1, dist);
   d2Gjkterm += (topo->atoms[atom2].myGBSA_T->partialGBHessianTerms_term1 - sdrtatom2Err.term1) * d2Rjdrij2;
   d2Gjkterm += (topo->atoms[atom2].myGBSA_T->partialGBHessianTerms_term2 - sdrtatom2Err.term2) * bornRadiusDerivative_ji * bornRadiusDerivative_ji;
 
@@ -256,6 +271,7 @@ Matrix3By3 ReducedHessGB::operator()( Real a,
 
 Real ReducedHessGB::FirstDerivativeFGB(
                           const GenericTopology *topo,
+                          const Vector3DBlock *positions,
                           const int atom1) const {
 
   //sum over derivatives
@@ -271,8 +287,8 @@ Real ReducedHessGB::FirstDerivativeFGB(
     
     if( k == (unsigned)atom1 ) continue;
       
-    //grab r_{ik} / r_{jk}
-    const Real dist = topo->atoms[atom1].myGBSA_T->distij[k];
+    //r_{ik} / r_{jk} from the positions, distances are not stored
+    const Real dist = sqrt(topo->minimalDifference((*positions)[atom1], (*positions)[k]).normSquared());
 
     //born radius of k
     const Real bornRad_k = topo->atoms[k].myGBSA_T->bornRad;
@@ -293,15 +309,13 @@ Real ReducedHessGB::FirstDerivativeFGB(
 
 Real ReducedHessGB::FirstDerivativeFGBSumError(
                                        const GenericTopology *topo,
-                                       const int atom1, const int atom2) const {
+                                       const int atom1, const int atom2,
+                                       const Real dist) const {
   
   //born radius and charge of i
   const Real bornRad_i = topo->atoms[atom1].myGBSA_T->bornRad;
   const Real charge_i = topo->atoms[atom1].scaledCharge;
   
-  //grab r_{ik} / r_{jk}
-  const Real dist = topo->atoms[atom1].myGBSA_T->distij[atom2];
-    
   //born radius of k
   const Real bornRad_k = topo->atoms[atom2].myGBSA_T->bornRad;
     
@@ -320,6 +334,7 @@ Real ReducedHessGB::FirstDerivativeFGBSumError(
 
 ReducedHessGB::secondDerivativeRawTerms ReducedHessGB::SecondDerivativeFGB(
                           const GenericTopology *topo,
+                          const Vector3DBlock *positions,
                           const int atom1) const {
   
   //sum of second derivatives
@@ -337,8 +352,8 @@ ReducedHessGB::secondDerivativeRawTerms ReducedHessGB::SecondDerivativeFGB(
     
     if( k == (unsigned)atom1 ) continue; //|| k == atom2 
 
-    //grab r_{ik} / r_{jk}
-    const Real dist = topo->atoms[atom1].myGBSA_T->distij[k];
+    //r_{ik} / r_{jk} from the positions, distances are not stored
+    const Real dist = sqrt(topo->minimalDifference((*positions)[atom1], (*positions)[k]).normSquared());
   
     //born radius of k
     const Real bornRad_k = topo->atoms[k].myGBSA_T->bornRad;
@@ -374,7 +389,8 @@ ReducedHessGB::secondDerivativeRawTerms ReducedHessGB::SecondDerivativeFGB(
 
 ReducedHessGB::secondDerivativeRawTerms ReducedHessGB::SecondDerivativeFGBSumError(
                                                                            const GenericTopology *topo,
-                                                                           const int atom1, const int atom2) const {
+                                                                           const int atom1, const int atom2,
+                                                                           const Real dist) const {
   
   //second derivatives
   secondDerivativeRawTerms sdrt;
@@ -383,9 +399,6 @@ ReducedHessGB::secondDerivativeRawTerms ReducedHessGB::SecondDerivativeFGBSumErr
   const Real bornRad_i = topo->atoms[atom1].myGBSA_T->bornRad;
   const Real charge_i = topo->atoms[atom1].scaledCharge;
   
-  //grab r_{ik} / r_{jk}
-  const Real dist = topo->atoms[atom1].myGBSA_T->distij[atom2];
-    
   //born radius of k
   const Real bornRad_k = topo->atoms[atom2].myGBSA_T->bornRad;
     
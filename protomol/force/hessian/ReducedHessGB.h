@@ -3,6 +3,7 @@
 #define REDUCEDHESSGB_H
 
 #include <protomol/type/Matrix3By3.h>
+#include <protomol/type/Vector3DBlock.h>
 #include <protomol/topology/ExclusionTable.h>
 
 namespace ProtoMol {
@@ -16,6 +17,7 @@ namespace ProtoMol {
       Matrix3By3 operator()(Real distSquared,
                           const Vector3D &diff,
                           const GenericTopology *topo,
+                          const Vector3DBlock *positions,
                           int atom1, int atom2,
                           int na,
                           Real soluteDielec,Real solventDielec,
@@ -30,19 +32,23 @@ namespace ProtoMol {
     
     Real FirstDerivativeFGB(
                           const GenericTopology *topo,
+                          const Vector3DBlock *positions,
                           const int atom1) const;
 
     Real FirstDerivativeFGBSumError(
                             const GenericTopology *topo,
-                            const int atom1, const int atom2) const;
+                            const int atom1, const int atom2,
+                            const Real dist) const;
 
     secondDerivativeRawTerms SecondDerivativeFGB(
                           const GenericTopology *topo,
+                          const Vector3DBlock *positions,
                           const int atom1) const;
     
     secondDerivativeRawTerms SecondDerivativeFGBSumError(
                                                          const GenericTopology *topo,
-                                                         const int atom1, const int atom2) const;
+                                                         const int atom1, const int atom2,
+                                                         const Real dist) const;
 
   };
 
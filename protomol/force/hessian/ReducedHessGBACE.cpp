@@ -55,9 +55,20 @@ Matrix3By3 ReducedHessGBACE::operator()(Real a,
 
    Real tanhparam_i_derv = topo->alphaObc - 2*topo->betaObc*psi_i + 3*topo->gammaObc*psi_i*psi_i;
 
-   //data required for the second derivative of the burial term
-   Real Lij = topo->atoms[atom1].myGBSA_T->Lvalues[atom2];
-   Real Uij = topo->atoms[atom1].myGBSA_T->Uvalues[atom2];
+     //Scaling factors
+     Real S_i = topo->atoms[atom1].myGBSA_T->scalingFactor;
+     Real S_j = topo->atoms[atom2].myGBSA_T->scalingFactor;
+
+   //data required for the second derivative of the burial term, as in GBBornRadii
+   Real Lij, Uij;
+
+   if (offsetRadius_i >= dist + S_j*offsetRadius_j) {
+     Lij = 1;
+     Uij = 1;
+   }else {
+     Lij = (offsetRadius_i > fabs(dist - S_j*offsetRadius_j)) ? offsetRadius_i : fabs(dist - S_j*offsetRadius_j);
+     Uij = dist + S_j*offsetRadius_j;
+   }
 
    Real invLij = 1/Lij;
    Real invUij = 1/Uij;
@@ -65,11 +76,6 @@ Matrix3By3 ReducedHessGBACE::operator()(Real a,
    //Derivatives for calculation of the derivative of the born radii
    Real dLijdrij, dUijdrij, dCijdrij;
 
-     //Scaling factors
-     Real S_i = topo->atoms[atom1].myGBSA_T->scalingFactor;
-     Real S_j = topo->atoms[atom2].myGBSA_T->scalingFactor;
-
-
    //Check Equations (11-13)
    if (offsetRadius_i <= (dist - S_j*offsetRadius_j)) dLijdrij = 1;
    else dLijdrij = 0;
@@ -109,8 +115,15 @@ Matrix3By3 ReducedHessGBACE::operator()(Real a,
   Real d2Ridrij2 =  2*(1 - tanh_i*tanh_i)*(1-tanh_i*tanh_i)*power(psiderv_i_ij,2)*power(tanhparam_i_derv,2)*(power(bornRad_i,3)/power(radius_i,2)) -2*power(bornRad_i,2)*tanh_i*(1 - tanh_i*tanh_i)*power(psiderv_i_ij,2)*power(tanhparam_i_derv,2)*(1/radius_i) + (power(bornRad_i,2)/radius_i)*(1 - power(tanh_i,2))*(alpha*d2Psi_i_drij2 - 2*beta*power(psiderv_i_ij,2)- 2*beta*psi_i*d2Psi_i_drij2) + (power(bornRad_i,2)/radius_i)*(1 - power(tanh_i,2))*(6*gamma*psi_i*power(psiderv_i_ij,2) + 3*gamma*power(psi_i,2)*d2Psi_i_drij2);
 
    //data required for the second derivative of the burial term
-   Real Lji = topo->atoms[atom2].myGBSA_T->Lvalues[atom1];
-   Real Uji = topo->atoms[atom2].myGBSA_T->Uvalues[atom1];
+   Real Lji, Uji;
+
+   if (offsetRadius_j >= dist + S_i*offsetRadius_i) {
+     Lji = 1;
+     Uji = 1;
+   }else {
+     Lji = (offsetRadius_j > fabs(dist - S_i*offsetRadius_i)) ? offsetRadius_j : fabs(dist - S_i*offsetRadius_i);
+     Uji = dist + S_i*offsetRadius_i;
+   }
 
    Real invLji = 1/Lji;
    Real invUji = 1/Uji;
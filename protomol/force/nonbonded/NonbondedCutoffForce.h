@@ -25,32 +25,72 @@ namespace ProtoMol {
     // Constructors, destructors, assignment
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   public:
-    NonbondedCutoffForce() : myCutoff(0.0) {}
+    NonbondedCutoffForce() : myCutoff(0.0), myReorder(0) {}
 
-    NonbondedCutoffForce(Real cutoff, TOneAtomPair oneAtomPair) :
-      TForce(), myCutoff(cutoff), myOneAtomPair(oneAtomPair) {}
+    NonbondedCutoffForce(Real cutoff, TOneAtomPair oneAtomPair,
+                         int reorder = 0) :
+      TForce(), myCutoff(cutoff), myOneAtomPair(oneAtomPair),
+      myReorder(reorder) {}
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // New methods of class NonbondedCutoffForce
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   protected:
     void doEvaluate(const GenericTopology *topo, unsigned int n) {
+      collectCellGroups(n, myGroupCells, myGroupFirst);
+      for (unsigned int g = 0; g + 1 < myGroupFirst.size(); g++)
+        doCellGroup(topo, &myGroupCells[myGroupFirst[g]],
+                    &myGroupCells[0] + myGroupFirst[g + 1], myOneAtomPair,
+                    myCellAtoms);
+    }
+
+    /**
+     * Collects the cell pairs of the next n first cells of the enumerator.
+     * The enumerator yields the pairs grouped by first cell, the pair of
+     * the cell with itself first, such that group g consists of the first
+     * cell cells[first[g]] followed by its neighbour cells up to
+     * cells[first[g + 1]].
+     */
+    void collectCellGroups(unsigned int n, std::vector<int> &cells,
+                           std::vector<unsigned int> &first) {
+      cells.clear();
+      first.clear();
       CellPairType thisPair;
-      unsigned int count = 0;
       for (; !enumerator.done(); enumerator.next()) {
         enumerator.get(thisPair);
-        bool notSameCell = enumerator.notSameCell();
-        
-        if (!notSameCell) {
-          count++;
-          if (count > n) break;
+        if (!enumerator.notSameCell()) {
+          if (first.size() == n) break;
+          first.push_back(cells.size());
         }
-        for (int i = thisPair.first; i != -1; i = topo->atoms[i].cellListNext)
-          for (int j =
-                 (notSameCell ? thisPair.second : topo->atoms[i].cellListNext);
-               j != -1; j = topo->atoms[j].cellListNext)
-            myOneAtomPair.doOneAtomPair(i, j);
+        cells.push_back(thisPair.second);
       }
+      first.push_back(cells.size());
+    }
+
+    /**
+     * Computes all interactions of one first cell with itself and its
+     * neighbour cells. The atoms of the first cell and of all neighbour
+     * cells are gathered into one list, such that each atom of the first
+     * cell sees all its partners as one contiguous block, long enough to
+     * fill the vector lanes of the pair kernel.
+     */
+    static void doCellGroup(const GenericTopology *topo, const int *cells,
+                            const int *cellsEnd, TOneAtomPair &oneAtomPair,
+                            std::vector<int> &cellAtoms) {
+      cellAtoms.clear();
+      for (int j = *cells; j != -1; j = topo->atoms[j].cellListNext)
+        cellAtoms.push_back(j);
+      const unsigned int numFirst = cellAtoms.size();
+      if (numFirst == 0) return;
+
+      for (const int *c = cells + 1; c != cellsEnd; ++c)
+        for (int j = *c; j != -1; j = topo->atoms[j].cellListNext)
+          cellAtoms.push_back(j);
+
+      const int *atoms = &cellAtoms[0];
+      const int *jEnd = atoms + cellAtoms.size();
+      for (unsigned int p = 0; p < numFirst; p++)
+        oneAtomPair.doAtomPairBlock(atoms[p], atoms + p + 1, jEnd);
     }
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -69,9 +109,10 @@ namespace ProtoMol {
 
   private:
     virtual Force *doMake(const std::vector<Value> &values) const {
-      std::vector<Value> atomPairValues(values.begin(), values.end() - 1);
-      return new TImplForce(values[values.size() - 1], 
-                            TOneAtomPair::make(atomPairValues));
+      std::vector<Value> atomPairValues(values.begin(), values.end() - 2);
+      return new TImplForce(values[values.size() - 2],
+                            TOneAtomPair::make(atomPairValues),
+                            values[values.size() - 1]);
     }
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -88,6 +129,11 @@ namespace ProtoMol {
         (Parameter("-cutoff",
                    Value(myCutoff, ConstraintValueType::Positive()),
                    Text("algorithm cutoff")));
+      parameters.push_back
+        (Parameter("-reorder",
+                   Value(myReorder, ConstraintValueType::NotNegative()), 0,
+                   Text("evaluations between reorderings of the atoms in "
+                        "cell order, 0 for none")));
     }
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -96,7 +142,11 @@ namespace ProtoMol {
     protected:
        Real myCutoff;
        TOneAtomPair myOneAtomPair;
+       int myReorder;
        EnumeratorType enumerator;
+       std::vector<int> myCellAtoms;
+       std::vector<int> myGroupCells;
+       std::vector<unsigned int> myGroupFirst;
   };
 }
 #endif /* NONBONDEDCUTOFFFORCE_H */
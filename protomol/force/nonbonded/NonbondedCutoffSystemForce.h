@@ -4,10 +4,21 @@
 
 #include <protomol/force/system/SystemForce.h>
 #include <protomol/force/nonbonded/NonbondedCutoffForce.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
+#include <protomol/base/Report.h>
 
 namespace ProtoMol {
   //____ NonbondedCutoffSystemForce
 
+  /**
+   * Cutoff force over the cell lists. With -reorder n > 0 the force keeps
+   * its own copy of the atoms permuted in cell order, such that the atoms
+   * of a cell are neighbours in memory, and evaluates the pairs on this
+   * copy. The permutation is renewed every n evaluations, the forces are
+   * mapped back to the original atom order, hence the rest of the system
+   * (integrators, outputs, exclusion table) never sees the permutation.
+   * The parallel (MPI) evaluation always works on the original order.
+   */
   template<class TCellManager, class TOneAtomPair>
   class NonbondedCutoffSystemForce :
     public NonbondedCutoffForce<TCellManager, TOneAtomPair, SystemForce,
@@ -27,11 +38,17 @@ namespace ProtoMol {
   public:
     NonbondedCutoffSystemForce() :
       NonbondedCutoffForce<TCellManager, TOneAtomPair, SystemForce,
-                           NonbondedCutoffSystemForce>() {}
+                           NonbondedCutoffSystemForce>(),
+      myLocalTopo(NULL), myEvaluations(0) {}
 
-    NonbondedCutoffSystemForce(Real cutoff, TOneAtomPair oneAtomPair) :
+    NonbondedCutoffSystemForce(Real cutoff, TOneAtomPair oneAtomPair,
+                               int reorder = 0) :
       NonbondedCutoffForce<TCellManager, TOneAtomPair, SystemForce,
-                           NonbondedCutoffSystemForce>(cutoff, oneAtomPair) {}
+                           NonbondedCutoffSystemForce>(cutoff, oneAtomPair,
+                                                       reorder),
+      myLocalTopo(NULL), myEvaluations(0) {}
+
+    virtual ~NonbondedCutoffSystemForce() {delete myLocalTopo;}
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // From class SystemForce
@@ -48,10 +65,10 @@ namespace ProtoMol {
       const RealTopologyType *realTopo =
           (RealTopologyType*) topo;
       //  dynamic_cast<const RealTopologyType *>(topo);
-      this->myOneAtomPair.initialize(realTopo, positions, forces, energies);
-      realTopo->updateCellLists(positions);
-      this->enumerator.initialize(realTopo, this->myCutoff);
-      this->doEvaluate(topo, realTopo->cellLists.size());
+      if (this->myReorder > 0 && !realTopo->isDecomposed())
+        localEvaluate(realTopo, positions, forces, energies);
+      else
+        doSystemEvaluate(realTopo, positions, forces, energies);
     }
 
     virtual void parallelEvaluate(const GenericTopology *topo,
@@ -65,6 +82,21 @@ namespace ProtoMol {
       realTopo->updateCellLists(positions);
       this->enumerator.initialize(realTopo, this->myCutoff);
       
+      if (realTopo->isDecomposed()) {
+        // Cell groups starting at a cell of the slab of this node
+        this->collectCellGroups(realTopo->cellLists.size(),
+                                this->myGroupCells, this->myGroupFirst);
+        for (unsigned int g = 0; g + 1 < this->myGroupFirst.size(); g++) {
+          const int *cells = &this->myGroupCells[this->myGroupFirst[g]];
+          if (*cells >= 0 && realTopo->isOwnedAtom(*cells))
+            Super_T::doCellGroup(realTopo, cells,
+                                 &this->myGroupCells[0] +
+                                 this->myGroupFirst[g + 1],
+                                 this->myOneAtomPair, this->myCellAtoms);
+        }
+        return;
+      }
+
       unsigned int n = realTopo->cellLists.size();
       unsigned int count = this->numberOfBlocks(realTopo, positions);
       
@@ -91,6 +123,179 @@ namespace ProtoMol {
     virtual bool doParallelPostProcess() {
       return this->myOneAtomPair.doParallelPostProcess();
     }
+
+    virtual Real getDomainHalo(const GenericTopology *,
+                               const Vector3DBlock *) {return this->myCutoff;}
+
+  private:
+    void doSystemEvaluate(const RealTopologyType *realTopo,
+                          const Vector3DBlock *positions,
+                          Vector3DBlock *forces, ScalarStructure *energies) {
+      this->myOneAtomPair.initialize(realTopo, positions, forces, energies);
+      realTopo->updateCellLists(positions);
+      this->enumerator.initialize(realTopo, this->myCutoff);
+
+      const int threads = ThreadForceBuffers::getNumThreads();
+      if (TOneAtomPair::THREAD_SAFE && threads > 1)
+        threadedEvaluate(realTopo, positions, forces, energies, threads);
+      else
+        this->doEvaluate(realTopo, realTopo->cellLists.size());
+    }
+
+    /// Evaluation on the atoms permuted in cell order, see reorder()
+    void localEvaluate(const RealTopologyType *realTopo,
+                       const Vector3DBlock *positions,
+                       Vector3DBlock *forces, ScalarStructure *energies) {
+      if (myLocalTopo == NULL || myOrder.size() != realTopo->atoms.size() ||
+          myEvaluations % this->myReorder == 0)
+        reorder(realTopo, positions);
+      myEvaluations++;
+
+      // The positions, the box and the molecular centers of mass change
+      // from one evaluation to the next
+      const unsigned int n = myOrder.size();
+      myLocalPositions.resize(n);
+      // Through Vector3D, assigning Vector3DB to Vector3DB copies the
+      // pointer into the block, not the coordinates
+      for (unsigned int k = 0; k < n; k++)
+        myLocalPositions[k] = Vector3D((*positions)[myOrder[k]]);
+      myLocalTopo->boundaryConditions = realTopo->boundaryConditions;
+      for (unsigned int m = 0; m < realTopo->molecules.size(); m++)
+        myLocalTopo->molecules[m].position = realTopo->molecules[m].position;
+      myLocalTopo->time = realTopo->time;
+      myLocalTopo->uncacheCellList();
+
+      myLocalForces.zero(n);
+      doSystemEvaluate(myLocalTopo, &myLocalPositions, &myLocalForces,
+                       energies);
+
+      for (unsigned int k = 0; k < n; k++)
+        (*forces)[myOrder[k]] += myLocalForces[k];
+    }
+
+    /**
+     * Permutes the atoms in the order of the cell lists of the current
+     * positions, myOrder maps the local to the original index. The local
+     * topology holds what the pair functions look up by atom index: the
+     * atoms, the molecules and the exclusions, renumbered.
+     */
+    void reorder(const RealTopologyType *realTopo,
+                 const Vector3DBlock *positions) {
+      if (realTopo->implicitSolvent != NONE || realTopo->doSCPISM)
+        report << error << this->getKeyword() << ": -reorder is not "
+               << "supported with implicit solvent." << endr;
+
+      const unsigned int n = realTopo->atoms.size();
+      realTopo->updateCellLists(positions);
+      myOrder.clear();
+      for (typename TCellManager::CellListStructure::const_iterator c =
+             realTopo->cellLists.begin(); c != realTopo->cellLists.end(); ++c)
+        for (int i = c->second; i != -1; i = realTopo->atoms[i].cellListNext)
+          myOrder.push_back(i);
+      if (myOrder.size() != n)
+        report << error << this->getKeyword() << ": " << myOrder.size()
+               << " of " << n << " atoms in the cell lists." << endr;
+
+      std::vector<int> index(n);
+      for (unsigned int k = 0; k < n; k++)
+        index[myOrder[k]] = k;
+
+      delete myLocalTopo;
+      myLocalTopo =
+        new RealTopologyType(realTopo->coulombScalingFactor,
+                             realTopo->exclude, realTopo->boundaryConditions,
+                             realTopo->cellManager,
+                             realTopo->cellLists.MaximumVolume());
+      myLocalTopo->LJScalingFactor = realTopo->LJScalingFactor;
+      myLocalTopo->forceFieldFlag = realTopo->forceFieldFlag;
+      myLocalTopo->atomTypes = realTopo->atomTypes;
+
+      const int types = realTopo->lennardJonesParameters.size();
+      myLocalTopo->lennardJonesParameters.resize(types);
+      for (int a = 0; a < types; a++)
+        for (int b = 0; b < types; b++)
+          myLocalTopo->lennardJonesParameters.
+            set(a, b, realTopo->lennardJonesParameters(a, b));
+
+      // The bonded terms stay with the original topology
+      myLocalTopo->atoms.resize(n);
+      for (unsigned int k = 0; k < n; k++) {
+        Atom &atom = myLocalTopo->atoms[k];
+        atom = realTopo->atoms[myOrder[k]];
+        atom.mybonds.clear();
+      }
+
+      myLocalTopo->molecules = realTopo->molecules;
+      for (unsigned int m = 0; m < myLocalTopo->molecules.size(); m++) {
+        Molecule &molecule = myLocalTopo->molecules[m];
+        for (unsigned int a = 0; a < molecule.atoms.size(); a++)
+          molecule.atoms[a] = index[molecule.atoms[a]];
+        for (unsigned int p = 0; p < molecule.pairs.size(); p++)
+          molecule.pairs[p] = PairInt(index[molecule.pairs[p].first],
+                                      index[molecule.pairs[p].second]);
+      }
+
+      const std::vector<ExclusionPair> &table =
+        realTopo->exclusions.getTable();
+      myLocalTopo->exclusions.resize(n);
+      for (unsigned int e = 0; e < table.size(); e++)
+        myLocalTopo->exclusions.add(index[table[e].a1], index[table[e].a2],
+                                    table[e].excl);
+    }
+
+    /**
+     * Shared memory evaluation. The cell groups are collected once and
+     * handed out to the threads on demand, such that threads finishing
+     * early take over the remaining groups. Each thread works on its own
+     * copy of the pair and adds into its own force and energy buffers,
+     * which are reduced at the end.
+     */
+    void threadedEvaluate(const RealTopologyType *realTopo,
+                          const Vector3DBlock *positions,
+                          Vector3DBlock *forces, ScalarStructure *energies,
+                          int threads) {
+      this->collectCellGroups(realTopo->cellLists.size(), this->myGroupCells,
+                              this->myGroupFirst);
+      const int n = static_cast<int>(this->myGroupFirst.size()) - 1;
+      if (n < 1) return;
+
+      myBuffers.initialize(threads, positions->size(), energies);
+      myThreadPairs.assign(threads, this->myOneAtomPair);
+      for (int t = 0; t < threads; t++)
+        myThreadPairs[t].initialize(realTopo, positions, myBuffers.forces(t),
+                                    myBuffers.energies(t));
+
+      const int *cells = &this->myGroupCells[0];
+      const unsigned int *first = &this->myGroupFirst[0];
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+      {
+        TOneAtomPair &oneAtomPair =
+          myThreadPairs[ThreadForceBuffers::getThreadId()];
+        std::vector<int> cellAtoms;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int g = 0; g < n; g++)
+          Super_T::doCellGroup(realTopo, cells + first[g],
+                               cells + first[g + 1], oneAtomPair, cellAtoms);
+      }
+
+      myBuffers.reduce(forces, energies);
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    std::vector<TOneAtomPair> myThreadPairs;
+    ThreadForceBuffers myBuffers;
+    RealTopologyType *myLocalTopo;
+    std::vector<int> myOrder;
+    Vector3DBlock myLocalPositions;
+    Vector3DBlock myLocalForces;
+    unsigned int myEvaluations;
   };
 }
 #endif /* NONBONDEDCUTOFFSYSTEMFORCE_H */
@@ -5,6 +5,7 @@
 #include <protomol/force/nonbonded/NonbondedFullEwaldSystemForceBase.h>
 #include <protomol/force/system/SystemForce.h>
 #include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
 #include <protomol/type/SimpleTypes.h>
 #include <protomol/type/ScalarStructure.h>
 #include <protomol/force/CoulombForce.h>
@@ -22,13 +23,14 @@
 #include <protomol/topology/CubicCellManager.h>
 
 #include <string>
+#include <vector>
+#include <algorithm>
 
 using namespace ProtoMol::Report;
 
 //#define DEBUG_EWALD_TIMING
 //#define DEBUG_EWALD_ENERGIES
 //#define USE_EWALD_EXACT_ERF
-//#define USE_EWALD_NO_SINCOS_TABLE
 
 namespace ProtoMol {
 
@@ -80,6 +82,13 @@ namespace ProtoMol {
 			Real& reciprocalEnergy,
 			unsigned int from, unsigned int to);
 
+    void phaseTables(const Vector3DBlock* positions,
+		     const RealTopologyType* realTopo, int threads);
+
+    void reciprocalBlock(unsigned int first, unsigned int last,
+			 unsigned int atomCount, Real* scratch,
+			 Real& energy, Real* virial);
+
     void correctionTerm(const RealTopologyType* realTopo,
 			const Vector3DBlock* positions, 
 			Vector3DBlock* forces, 
@@ -158,9 +167,9 @@ namespace ProtoMol {
 
     std::vector<Vector3D> myK;  // Reciprocal lattice vector (h*2PI/Lx,k*2PI/Ly,l*2PI/Lz)
     std::vector<Real> myKSquared;  // Squared norm of the reciprocal lattice vector
-#ifndef USE_EWALD_NO_SINCOS_TABLE
     std::vector<TripleInt> myKInt;      // Reciprocal lattice vector (h,k,l)
-#endif
+    std::vector<Real> myKFactor;   // exp(-k^2/(4 alpha^2))/k^2
+    std::vector<Real> myKVirial;   // 2(1/k^2 + 1/(4 alpha^2))
 
     Real myExpansionFactor;
     Real myTRate;             //
@@ -183,9 +192,11 @@ namespace ProtoMol {
     int myLmax;
     int myHKLmax;
 
-    Real* mySinCosA;          // Look up tables
-    Real* myLastSinCos;
-    Vector3D* mySinCos;
+    // Look up tables sin/cos(n*2PI*r/L), [n*atomCount+i]
+    std::vector<Real> mySinX, myCosX, mySinY, myCosY, mySinZ, myCosZ;
+    std::vector<Real> myCharge;
+    // Per thread phases of two k-vectors and forces, see reciprocalBlock()
+    std::vector<Real> myScratch;
 
     Real myLX, myLY, myLZ;
     Real myLXr,myLYr,myLZr;
@@ -200,8 +211,6 @@ namespace ProtoMol {
     TSwitchingFunction switchingFunction;
     EnumeratorType enumerator;
     std::vector<Vector3D> myLattice;
-    unsigned int myOldAtomCount; // Keep track of old values and hope
-    int myOldHKLmax;             // we do not need to reallocate memory ...
 #if defined(DEBUG_EWALD_TIMING)
     Timer myReal;
     Timer myReciprocal;
@@ -232,12 +241,7 @@ namespace ProtoMol {
 				    myAlphaDefault(true),
 				    myRc(0.0),
 				    myKc(0.0),
-				    mySinCosA(NULL),
-				    myLastSinCos(NULL),
-				    mySinCos(NULL),
-				    myV(-1.0),
-				    myOldAtomCount(0),
-				    myOldHKLmax(0){
+				    myV(-1.0){
 #if defined(DEBUG_EWALD_TIMING)
     myReal.reset();
     myReciprocal.reset();
@@ -265,12 +269,7 @@ namespace ProtoMol {
 				    myAlphaDefault(alpha<= 0.0),
 				    myRc(0.0),
 				    myKc(0.0),
-				    mySinCosA(NULL),
-				    myLastSinCos(NULL),
-				    mySinCos(NULL),
-				    myV(-1.0),
-				    myOldAtomCount(0),
-				    myOldHKLmax(0) {
+				    myV(-1.0) {
 #if defined(DEBUG_EWALD_TIMING)
     myReal.reset();
     myReciprocal.reset();
@@ -291,11 +290,6 @@ namespace ProtoMol {
 				reciprocal,
 				correction,
 				TSwitchingFunction>::~NonbondedFullEwaldSystemForce(){
-    if(reciprocal){
-      delete [] mySinCosA;
-      delete [] mySinCos;
-      delete [] myLastSinCos;
-    }
 #if defined(DEBUG_EWALD_TIMING)
     if(boundaryConditions.getVolume() > Constnat::EPSILON){
       report.setf(std::ios::showpoint|std::ios::fixed);
@@ -629,9 +623,9 @@ namespace ProtoMol {
     myHKLmax = std::max(2,std::max(myHmax,std::max(myKmax,myLmax))+1);
     myK.clear();
     myKSquared.clear();
-#ifndef USE_EWALD_NO_SINCOS_TABLE
     myKInt.clear();
-#endif
+    myKFactor.clear();
+    myKVirial.clear();
     int lastH = Constant::MAX_INT;
     int lastK = Constant::MAX_INT;
     int misses = 0;
@@ -643,49 +637,23 @@ namespace ProtoMol {
 	  Real ky = 2.0*M_PI*k*myLYr;
 	  for(int l = (h==0 && k==0 ? 1 : -myLmax); l <= myLmax; l++){
 	    Real kz = 2.0*M_PI*l*myLZr;
-	    if(kx*kx + ky*ky + kz*kz < kcSquared){
+	    Real kSquared = kx*kx + ky*ky + kz*kz;
+	    if(kSquared < kcSquared){
 	      myK.push_back(Vector3D(kx,ky,kz));
-	      myKSquared.push_back(kx*kx + ky*ky + kz*kz);
-#ifndef USE_EWALD_NO_SINCOS_TABLE
+	      myKSquared.push_back(kSquared);
+	      myKFactor.push_back(exp(-kSquared*myAlphaSquaredr/4.0)/kSquared);
+	      myKVirial.push_back(2.0*(1.0/kSquared+myFac));
 	      TripleInt tmp(h,k,l);
 	      myKInt.push_back(tmp);
 	      if(lastH != h || lastK != k)
 		misses++;
 	      lastH = h;
 	      lastK = k;
-#endif
 	    }
 	  }
 	}
       }
-    
-      // Allocate memeory for our tables
-      if(mySinCosA != NULL && (atomCount != myOldAtomCount)){
-	delete [] mySinCosA;
-	mySinCosA = NULL;
-      }
-      if(mySinCos != NULL && (atomCount != myOldAtomCount || myHKLmax != myOldHKLmax)){
-	delete [] mySinCos;
-	mySinCos = NULL;
-      }
-      if(myLastSinCos != NULL && (atomCount != myOldAtomCount)){
-	delete [] myLastSinCos;
-	myLastSinCos = NULL;
-      }
-      if(mySinCosA == NULL)
-	mySinCosA    = new Real[2*atomCount];
-      if(mySinCosA == NULL)
-	report << error << "[NonbondedFullEwaldSystemForce::evaluate] Not enough memory, requesting "<<2*atomCount*sizeof(Real)<<" bytes."<<endr;
-#ifndef USE_EWALD_NO_SINCOS_TABLE
-      if(mySinCos == NULL)
-	mySinCos     = new Vector3D[2*atomCount*myHKLmax];
-      if(myLastSinCos == NULL)
-	myLastSinCos = new Real[2*atomCount];
-      if(mySinCos == NULL || myLastSinCos == NULL)
-	report << error << "[NonbondedFullEwaldSystemForce::evaluate] Not enough memory, requesting "<<2*atomCount*myHKLmax *sizeof(Real)*3 + 2*atomCount *sizeof(Real)<<" bytes."<<endr;
-      myOldHKLmax = myHKLmax;
-#endif
-      myOldAtomCount = atomCount;
+
     }
   
     //
@@ -717,16 +685,9 @@ namespace ProtoMol {
     myLattice.insert(myLattice.begin(),Vector3D(0,0,0));
 
     report << hint <<"Ewald";
-#if defined(USE_EWALD_EXACT_ERF) && defined(USE_EWALD_NO_SINCOS_TABLE)
-    report << "(Exact)";
-#else
 #ifdef USE_EWALD_EXACT_ERF
     report << "(Exact erf)";
 #endif
-#ifdef USE_EWALD_NO_SINCOS_TABLE
-    report << "(No sincos table)";
-#endif
-#endif  
     report <<": alpha="<<toString(myAlpha)<<", V="<<myV<<", Rc="
 	   <<toString(myRc)<<", Kc ("<<myK.size()<<")="<<toString(myKc)<<", n="<<myLattice.size()<<", accuracy="
 	   <<myAccuracy<<", misses="
@@ -881,178 +842,88 @@ namespace ProtoMol {
     myReciprocal.start();
 #endif
     const unsigned int atomCount = realTopo->atoms.size();
-    
+    const int threads = ThreadForceBuffers::getNumThreads();
 
-    Real energy = 0.0;
-#ifndef USE_EWALD_NO_SINCOS_TABLE
     // Precompute/ cache cos/ sin (r*N*2*PI/L) for the lattice vectors in each dimension 
-    for(unsigned int j=0;j<atomCount;j++){
-      int l = 2*j*myHKLmax;
-      Vector3D r(boundaryConditions.minimalPosition((*positions)[j]));
-      // Multiply charge only with x-coord of each particle
-      // since we use the add theorem 
-      Real qi = realTopo->atoms[j].scaledCharge;
-      Real x = r.c[0]*2.0*M_PI*myLXr;
-      Real y = r.c[1]*2.0*M_PI*myLYr;
-      Real z = r.c[2]*2.0*M_PI*myLZr;
-      Real xsin = sin(x);
-      Real ysin = sin(y);
-      Real zsin = sin(z);
-      Real xcos = cos(x);
-      Real ycos = cos(y);
-      Real zcos = cos(z);
-      // The first two cos/ sin values
-      // sin(r*0*2*PI/L)
-      mySinCos[l  ].c[0] = 0.0;
-      mySinCos[l  ].c[1] = 0.0;
-      mySinCos[l  ].c[2] = 0.0;
-      // cos(r*0*2*PI/L)
-      mySinCos[l+1].c[0] = qi*1.0;
-      mySinCos[l+1].c[1] = 1.0;
-      mySinCos[l+1].c[2] = 1.0;
-      // sin(r*1*2*PI/L)
-      mySinCos[l+2].c[0] = qi*xsin;
-      mySinCos[l+2].c[1] = ysin;
-      mySinCos[l+2].c[2] = zsin;
-      // cos(r*1*2*PI/L)
-      mySinCos[l+3].c[0] = qi*xcos;
-      mySinCos[l+3].c[1] = ycos;
-      mySinCos[l+3].c[2] = zcos;
-      
-      // Using add theorem to compute sin(r*2*2*PI/L to r*myHKLmax*2*PI/L) 
-      // and cos(r*2*2*PI/L to r*myHKLmax*2*PI/L)
-      for(int i=4;i<2*myHKLmax;i+=2){
-	mySinCos[l+i  ].c[0] = xsin*mySinCos[l+i-1].c[0]+xcos*mySinCos[l+i-2].c[0];
-	mySinCos[l+i  ].c[1] = ysin*mySinCos[l+i-1].c[1]+ycos*mySinCos[l+i-2].c[1];
-	mySinCos[l+i  ].c[2] = zsin*mySinCos[l+i-1].c[2]+zcos*mySinCos[l+i-2].c[2];
-	mySinCos[l+i+1].c[0] = xcos*mySinCos[l+i-1].c[0]-xsin*mySinCos[l+i-2].c[0];
-	mySinCos[l+i+1].c[1] = ycos*mySinCos[l+i-1].c[1]-ysin*mySinCos[l+i-2].c[1];
-	mySinCos[l+i+1].c[2] = zcos*mySinCos[l+i-1].c[2]-zsin*mySinCos[l+i-2].c[2];
-      }
-    }
-    
-    //int nk = myK.size();
-    int lastH = Constant::MAX_INT;
-    int lastK = Constant::MAX_INT;
-#endif
-    // atomic virial
-    Real virialxx = 0.0;
-    Real virialxy = 0.0;
-    Real virialxz = 0.0;
-    Real virialyy = 0.0;
-    Real virialyz = 0.0;
-    Real virialzz = 0.0;
+    phaseTables(positions,realTopo,threads);
 
-    // molecular virial
-    bool doMolVirial = energies->molecularVirial();
-    bool doVirial = energies->virial();
+    // The k-vectors are split into blocks of consecutive vectors, such that
+    // a block mostly reuses the same (h,k) phases, the blocks are
+    // distributed over the threads
+    const int blockSize = 64;
+    const int blocks = (to - from + blockSize - 1)/blockSize;
+    const unsigned int scratchSize = 9*atomCount;
+    myScratch.resize(threads*scratchSize);
 
-    for(unsigned int l=from;l<to;l++){
-      // Energy
-      Vector3D k(myK[l]);
-      Real sumSin = 0.0;
-      Real sumCos = 0.0;
-      Real kSquared = myKSquared[l];
+    Real energy = 0.0;
+    Real virial[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
 
-#ifndef USE_EWALD_NO_SINCOS_TABLE
-      int indexH = myKInt[l].h;
-      int indexK = myKInt[l].k;
-      int indexKabs = abs(indexK);
-      int indexKsign = 1;
-      if(indexK < 0)
-	indexKsign = -1;
-      int indexL = myKInt[l].l;
-      int indexLabs = abs(indexL);
-      int indexLsign = 1;
-      if(indexL < 0)
-	indexLsign = -1;
-    
-      // Precompute and cache sin/ cos for h and k
-      // using the precompute table of sin/ cos
-      // Hit/miss rate vary from 6:1 to 12:1
-      if(indexH != lastH || indexK != lastK){
-	for(unsigned int i=0;i<atomCount;i++){
-	  Real xsin =            mySinCos[i*myHKLmax*2+indexH*2  ].c[0];
-	  Real xcos =            mySinCos[i*myHKLmax*2+indexH*2+1].c[0];
-	  Real ysin = indexKsign*mySinCos[i*myHKLmax*2+indexKabs*2  ].c[1];
-	  Real ycos =            mySinCos[i*myHKLmax*2+indexKabs*2+1].c[1];
-	
-	  myLastSinCos[i*2  ] = xsin*ycos + xcos*ysin;
-	  myLastSinCos[i*2+1] = xcos*ycos - xsin*ysin;
-	}
-	lastH = indexH;
-	lastK = indexK;
-      }
-#endif    
-      for(unsigned int i=0;i<atomCount;i++){
-#ifdef USE_EWALD_NO_SINCOS_TABLE
-	Real qi = realTopo->atoms[i].scaledCharge;
-	// It does not matter if coordinates are not in the minimal image since
-	// they are multiplied by 2PI/l, which is a shift of 2PI of a. 
-	Real a = k.dot(boundaryConditions.minimalPosition((*positions)[i]));
-	//Real a = k.dot((*positions)[i]);
-	Real sinA = qi*sin(a);
-	Real cosA = qi*cos(a);
-#else
-      
-	Real xysin = myLastSinCos[i*2  ];
-	Real xycos = myLastSinCos[i*2+1];
-      
-	Real zsin = indexLsign*mySinCos[i*myHKLmax*2+indexLabs*2  ].c[2];
-	Real zcos =            mySinCos[i*myHKLmax*2+indexLabs*2+1].c[2];
-      
-	Real sinA = xysin*zcos + xycos*zsin;
-	Real cosA = xycos*zcos - xysin*zsin;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
 #endif
-	mySinCosA[i*2  ] = sinA;
-	mySinCosA[i*2+1] = cosA;
-	sumSin += sinA;
-	sumCos += cosA;
+    {
+      Real* scratch = &myScratch[ThreadForceBuffers::getThreadId()*scratchSize];
+      std::fill(scratch+6*atomCount,scratch+9*atomCount,0.0);
+      Real threadEnergy = 0.0;
+      Real threadVirial[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for(int b=0;b<blocks;b++)
+	reciprocalBlock(from+b*blockSize,std::min(from+(b+1)*blockSize,to),
+			atomCount,scratch,threadEnergy,threadVirial);
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+      {
+	energy += threadEnergy;
+	for(int j=0;j<6;j++)
+	  virial[j] += threadVirial[j];
       }
+    }
 
-      // Energy
-      Real b = 1.0/kSquared*exp(-kSquared*myAlphaSquaredr/4.0);
-      Real e = b*(sumSin*sumSin+sumCos*sumCos);
-      energy += e;
-    
-      // Virial
-      if(doVirial){
-	Real c = 2.0*(1.0/kSquared+myFac);
-	virialxx += e * (1.0-c*k.c[0] * k.c[0]);
-	virialxy -= e * c * k.c[0] * k.c[1];
-	virialxz -= e * c * k.c[0] * k.c[2];
-	virialyy += e * (1.0-c*k.c[1] * k.c[1]);
-	virialyz -= e * c * k.c[1] * k.c[2];
-	virialzz += e * (1.0-c*k.c[2] * k.c[2]);
+    // Sum the forces of all threads
+    bool doMolVirial = energies->molecularVirial();
+    bool doVirial = energies->virial();
+    for(unsigned int i=0;i<atomCount;i++){
+      Vector3D fi(0.0,0.0,0.0);
+      for(int t=0;t<threads;t++){
+	const Real* f = &myScratch[t*scratchSize+6*atomCount];
+	fi.c[0] += f[i];
+	fi.c[1] += f[i+atomCount];
+	fi.c[2] += f[i+2*atomCount];
       }
-      // Force, F_i 
-      Real a = 8.0*M_PI*myVr*b;
-      for(unsigned int i=0;i<atomCount;i++){
+      (*forces)[i] += fi;     
 
-	// compute the force on atom i from the reciprocal space part
-	Vector3D fi(k*(a*(mySinCosA[i*2  ]*sumCos - mySinCosA[i*2+1]*sumSin)));
-	(*forces)[i] += fi;     
+      // compute the reciprocal space contribution to the molecular virial
+      // this expression is taken from Alejandre, Tildesley, and Chapela, J. Chem. Phys. 102 (11), 4574.
+      // It is linear in the force, hence done once with the sum over all k-vectors
+      if(doMolVirial){
+	// get the ID# of the molecule to which this atom belongs
+	int Mi = realTopo->atoms[i].molecule;
+
+	// compute the vector from atom i to the center of mass of the molecule
+	Vector3D ria(boundaryConditions.minimalPosition((*positions)[i]));
+	Vector3D mri(realTopo->boundaryConditions.minimalDifference(ria,realTopo->molecules[Mi].position));
 
 	// compute the reciprocal space contribution to the molecular virial
-	// this expression is taken from Alejandre, Tildesley, and Chapela, J. Chem. Phys. 102 (11), 4574.
-	if(doMolVirial){
-	  // get the ID# of the molecule to which this atom belongs
-	  int Mi = realTopo->atoms[i].molecule;
-	  
-	  // compute the vector from atom i to the center of mass of the molecule
-	  Vector3D ria(boundaryConditions.minimalPosition((*positions)[i]));
-	  Vector3D mri(realTopo->boundaryConditions.minimalDifference(ria,realTopo->molecules[Mi].position));
-
-	  // compute the reciprocal space contribution to the molecular virial
-	  // this expression is taken from Darden, et al. J. Chem. Phys. 103 (19), 8577.
-	  energies->addMolVirial(fi,mri);
-	}
+	// this expression is taken from Darden, et al. J. Chem. Phys. 103 (19), 8577.
+	energies->addMolVirial(fi,mri);
       }
     }
 
     Real c = 4.0*M_PI*myVr;
     reciprocalEnergy += c*energy;
 
+    Real virialxx = virial[0];
+    Real virialxy = virial[1];
+    Real virialxz = virial[2];
+    Real virialyy = virial[3];
+    Real virialyz = virial[4];
+    Real virialzz = virial[5];
+
     // atomic virial
     if(doVirial){
       (*energies)[ScalarStructure::VIRIALXX] += c*virialxx;
@@ -1082,6 +953,212 @@ namespace ProtoMol {
 #endif
   }
 
+  template <class TBoundaryConditions, 
+	    class TCellManager,
+	    bool  real,
+	    bool  reciprocal,
+	    bool  correction,
+	    class TSwitchingFunction>
+  void NonbondedFullEwaldSystemForce<TBoundaryConditions,
+				     TCellManager,
+				     real,
+				     reciprocal,
+				     correction,
+				     TSwitchingFunction>::phaseTables(const Vector3DBlock* positions,
+								      const RealTopologyType* realTopo,
+								      int threads) {
+    const int atomCount = realTopo->atoms.size();
+    const unsigned int size = atomCount*myHKLmax;
+    myCharge.resize(atomCount);
+    mySinX.resize(size); myCosX.resize(size);
+    mySinY.resize(size); myCosY.resize(size);
+    mySinZ.resize(size); myCosZ.resize(size);
+    Real* q  = &myCharge[0];
+    Real* sx = &mySinX[0]; Real* cx = &myCosX[0];
+    Real* sy = &mySinY[0]; Real* cy = &myCosY[0];
+    Real* sz = &mySinZ[0]; Real* cz = &myCosZ[0];
+
+    // Same static schedule in all loops, each thread keeps its atoms
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+    {
+#ifdef _OPENMP
+#pragma omp for schedule(static) nowait
+#endif
+      for(int i=0;i<atomCount;i++){
+	Vector3D r(boundaryConditions.minimalPosition((*positions)[i]));
+	Real x = r.c[0]*2.0*M_PI*myLXr;
+	Real y = r.c[1]*2.0*M_PI*myLYr;
+	Real z = r.c[2]*2.0*M_PI*myLZr;
+	q[i] = realTopo->atoms[i].scaledCharge;
+	// sin/ cos(r*0*2*PI/L)
+	sx[i] = 0.0; cx[i] = 1.0;
+	sy[i] = 0.0; cy[i] = 1.0;
+	sz[i] = 0.0; cz[i] = 1.0;
+	// sin/ cos(r*1*2*PI/L)
+	sx[atomCount+i] = sin(x); cx[atomCount+i] = cos(x);
+	sy[atomCount+i] = sin(y); cy[atomCount+i] = cos(y);
+	sz[atomCount+i] = sin(z); cz[atomCount+i] = cos(z);
+      }
+
+      // Using add theorem to compute sin(r*2*2*PI/L to r*myHKLmax*2*PI/L) 
+      // and cos(r*2*2*PI/L to r*myHKLmax*2*PI/L)
+      for(int n=2;n<myHKLmax;n++){
+	const int l = n*atomCount;
+	const int l1 = l-atomCount;
+#ifdef _OPENMP
+#pragma omp for schedule(static) nowait
+#endif
+	for(int i=0;i<atomCount;i++){
+	  const int j = atomCount+i;
+	  sx[l+i] = sx[j]*cx[l1+i] + cx[j]*sx[l1+i];
+	  cx[l+i] = cx[j]*cx[l1+i] - sx[j]*sx[l1+i];
+	  sy[l+i] = sy[j]*cy[l1+i] + cy[j]*sy[l1+i];
+	  cy[l+i] = cy[j]*cy[l1+i] - sy[j]*sy[l1+i];
+	  sz[l+i] = sz[j]*cz[l1+i] + cz[j]*sz[l1+i];
+	  cz[l+i] = cz[j]*cz[l1+i] - sz[j]*sz[l1+i];
+	}
+      }
+    }
+  }
+
+  template <class TBoundaryConditions, 
+	    class TCellManager,
+	    bool  real,
+	    bool  reciprocal,
+	    bool  correction,
+	    class TSwitchingFunction>
+  void NonbondedFullEwaldSystemForce<TBoundaryConditions,
+				     TCellManager,
+				     real,
+				     reciprocal,
+				     correction,
+				     TSwitchingFunction>::reciprocalBlock(unsigned int first,
+									  unsigned int last,
+									  unsigned int atomCount,
+									  Real* scratch,
+									  Real& energy,
+									  Real* virial) {
+    // Phases q*exp(i*k*r) of the (h,k) part, of the current and the
+    // previous k-vector, then the forces
+    const int n = atomCount;
+    Real* xySin = scratch;
+    Real* xyCos = scratch+n;
+    Real* sinA[2] = {scratch+2*n,scratch+4*n};
+    Real* cosA[2] = {scratch+3*n,scratch+5*n};
+    Real* fx = scratch+6*n;
+    Real* fy = scratch+7*n;
+    Real* fz = scratch+8*n;
+    const Real* q = &myCharge[0];
+
+    int lastH = Constant::MAX_INT;
+    int lastK = Constant::MAX_INT;
+    Real lastSumSin = 0.0;
+    Real lastSumCos = 0.0;
+
+    // Each sweep over the atoms computes the structure factor of k-vector
+    // l and the forces of k-vector l-1, one extra sweep does the forces of
+    // the last one
+    for(unsigned int l=first;l<=last;l++){
+      Real* sA = sinA[l%2];
+      Real* cA = cosA[l%2];
+      const Real* lastSA = sinA[(l+1)%2];
+      const Real* lastCA = cosA[(l+1)%2];
+
+      // Force, F_i of l-1
+      Real ax = 0.0, ay = 0.0, az = 0.0;
+      if(l > first){
+	Real a = 8.0*M_PI*myVr*myKFactor[l-1];
+	ax = a*myK[l-1].c[0];
+	ay = a*myK[l-1].c[1];
+	az = a*myK[l-1].c[2];
+      }
+
+      if(l == last){
+	for(int i=0;i<n;i++){
+	  Real g = lastSA[i]*lastSumCos - lastCA[i]*lastSumSin;
+	  fx[i] += ax*g;
+	  fy[i] += ay*g;
+	  fz[i] += az*g;
+	}
+	break;
+      }
+
+      int indexH = myKInt[l].h;
+      int indexK = myKInt[l].k;
+      int indexKabs = abs(indexK);
+      Real indexKsign = (indexK < 0 ? -1.0 : 1.0);
+      int indexL = myKInt[l].l;
+      int indexLabs = abs(indexL);
+      Real indexLsign = (indexL < 0 ? -1.0 : 1.0);
+
+      // Precompute and cache sin/ cos for h and k
+      // using the precompute table of sin/ cos
+      // Hit/miss rate vary from 6:1 to 12:1
+      if(indexH != lastH || indexK != lastK){
+	const Real* xs = &mySinX[indexH*n];
+	const Real* xc = &myCosX[indexH*n];
+	const Real* ys = &mySinY[indexKabs*n];
+	const Real* yc = &myCosY[indexKabs*n];
+	for(int i=0;i<n;i++){
+	  Real ysin = indexKsign*ys[i];
+	  xySin[i] = q[i]*(xs[i]*yc[i] + xc[i]*ysin);
+	  xyCos[i] = q[i]*(xc[i]*yc[i] - xs[i]*ysin);
+	}
+	lastH = indexH;
+	lastK = indexK;
+      }
+
+      const Real* zs = &mySinZ[indexLabs*n];
+      const Real* zc = &myCosZ[indexLabs*n];
+      Real sumSin = 0.0;
+      Real sumCos = 0.0;
+      if(l == first){
+	for(int i=0;i<n;i++){
+	  Real zsin = indexLsign*zs[i];
+	  Real s = xySin[i]*zc[i] + xyCos[i]*zsin;
+	  Real c = xyCos[i]*zc[i] - xySin[i]*zsin;
+	  sA[i] = s;
+	  cA[i] = c;
+	  sumSin += s;
+	  sumCos += c;
+	}
+      }
+      else {
+	for(int i=0;i<n;i++){
+	  Real g = lastSA[i]*lastSumCos - lastCA[i]*lastSumSin;
+	  fx[i] += ax*g;
+	  fy[i] += ay*g;
+	  fz[i] += az*g;
+	  Real zsin = indexLsign*zs[i];
+	  Real s = xySin[i]*zc[i] + xyCos[i]*zsin;
+	  Real c = xyCos[i]*zc[i] - xySin[i]*zsin;
+	  sA[i] = s;
+	  cA[i] = c;
+	  sumSin += s;
+	  sumCos += c;
+	}
+      }
+
+      // Energy
+      Real e = myKFactor[l]*(sumSin*sumSin+sumCos*sumCos);
+      energy += e;
+
+      // Virial
+      const Vector3D& k = myK[l];
+      Real c = myKVirial[l];
+      virial[0] += e * (1.0-c*k.c[0] * k.c[0]);
+      virial[1] -= e * c * k.c[0] * k.c[1];
+      virial[2] -= e * c * k.c[0] * k.c[2];
+      virial[3] += e * (1.0-c*k.c[1] * k.c[1]);
+      virial[4] -= e * c * k.c[1] * k.c[2];
+      virial[5] += e * (1.0-c*k.c[2] * k.c[2]);
+
+      lastSumSin = sumSin;
+      lastSumCos = sumCos;
+    }
+  }
 
   template <class TBoundaryConditions, 
 	    class TCellManager,
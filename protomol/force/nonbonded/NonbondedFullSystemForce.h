@@ -4,6 +4,7 @@
 
 #include <protomol/force/system/SystemForce.h>
 #include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
 #include <protomol/type/SimpleTypes.h>
 
 namespace ProtoMol {
@@ -38,31 +39,76 @@ namespace ProtoMol {
     void doEvaluate(const GenericTopology *topo, const Vector3DBlock *positions,
                     Vector3DBlock *forces, ScalarStructure *energies, int i0,
                     int i1, int j0, int j1) {
-      const RealTopologyType *realTopo =
-        dynamic_cast<const RealTopologyType *>(topo);
-      if (!myCached) {
-        myLattice = realTopo->boundaryConditions.buildLatticeVectors(myCutoff);
-        myCached = true;
-      }
+      const RealTopologyType *realTopo = initializeLattice(topo);
       myOneAtomPair.initialize(realTopo, positions, forces, energies,
                                &myLattice);
       
       for (int blocki = i0; blocki < i1; blocki += myBlockSize) {
         int blocki_max = blocki;
         if (blocki_max < j0) blocki_max = j0;
-        for (int blockj = blocki_max; blockj < j1; blockj += myBlockSize) {
-          int istart = blocki;
-          int iend = blocki + myBlockSize;
-          if (iend > i1) iend = i1;
-          for (int i = istart; i < iend; i++) {
-            int jstart = blockj;
-            if (jstart <= i) jstart = i;
-            int jend = blockj + myBlockSize;
-            if (jend > j1) jend = j1;
-            for (int j = jstart; j < jend; j++)
-              myOneAtomPair.doOneAtomPair(i, j);
-          }
-        }
+        for (int blockj = blocki_max; blockj < j1; blockj += myBlockSize)
+          doBlockPair(myOneAtomPair, blocki, blockj, i1, j1, myBlockSize);
+      }
+    }
+
+    /**
+     * Shared memory evaluation of all pairs. The pairs of blocks are handed
+     * out to the threads on demand, each thread works on its own copy of
+     * the pair and adds into its own force and energy buffers, which are
+     * reduced at the end.
+     */
+    void threadedEvaluate(const GenericTopology *topo,
+                          const Vector3DBlock *positions,
+                          Vector3DBlock *forces, ScalarStructure *energies,
+                          int threads) {
+      const RealTopologyType *realTopo = initializeLattice(topo);
+      const int n = static_cast<int>(topo->atoms.size());
+
+      myBlockPairs.clear();
+      for (int blocki = 0; blocki < n; blocki += myBlockSize)
+        for (int blockj = blocki; blockj < n; blockj += myBlockSize)
+          myBlockPairs.push_back(PairInt(blocki, blockj));
+
+      myBuffers.initialize(threads, positions->size(), energies);
+      myThreadPairs.assign(threads, myOneAtomPair);
+      for (int t = 0; t < threads; t++)
+        myThreadPairs[t].initialize(realTopo, positions, myBuffers.forces(t),
+                                    myBuffers.energies(t), &myLattice);
+
+      const int count = static_cast<int>(myBlockPairs.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
+      for (int k = 0; k < count; k++)
+        doBlockPair(myThreadPairs[ThreadForceBuffers::getThreadId()],
+                    myBlockPairs[k].first, myBlockPairs[k].second, n, n,
+                    myBlockSize);
+
+      myBuffers.reduce(forces, energies);
+    }
+
+    const RealTopologyType *initializeLattice(const GenericTopology *topo) {
+      const RealTopologyType *realTopo =
+        dynamic_cast<const RealTopologyType *>(topo);
+      if (!myCached) {
+        myLattice = realTopo->boundaryConditions.buildLatticeVectors(myCutoff);
+        myCached = true;
+      }
+      return realTopo;
+    }
+
+    /// Computes the pairs i <= j of block blocki with block blockj
+    static void doBlockPair(TOneAtomPair &oneAtomPair, int blocki, int blockj,
+                            int i1, int j1, unsigned int blockSize) {
+      int iend = blocki + blockSize;
+      if (iend > i1) iend = i1;
+      for (int i = blocki; i < iend; i++) {
+        int jstart = blockj;
+        if (jstart <= i) jstart = i;
+        int jend = blockj + blockSize;
+        if (jend > j1) jend = j1;
+        for (int j = jstart; j < jend; j++)
+          oneAtomPair.doOneAtomPair(i, j);
       }
     }
 
@@ -73,8 +119,12 @@ namespace ProtoMol {
     using SystemForce::evaluate; // Avoid compiler warning/error
     virtual void evaluate(const GenericTopology *to, const Vector3DBlock *pos,
                           Vector3DBlock *f, ScalarStructure *e) {
-      doEvaluate(to, pos, f, e, 0, (int)to->atoms.size(), 0,
-                 (int)to->atoms.size());
+      const int threads = ThreadForceBuffers::getNumThreads();
+      if (TOneAtomPair::THREAD_SAFE && threads > 1)
+        threadedEvaluate(to, pos, f, e, threads);
+      else
+        doEvaluate(to, pos, f, e, 0, (int)to->atoms.size(), 0,
+                   (int)to->atoms.size());
     }
 
     virtual void parallelEvaluate(const GenericTopology *topo,
@@ -160,6 +210,9 @@ namespace ProtoMol {
     std::vector<PairUInt> myFromRange;
     std::vector<PairUInt> myToRange;
     std::vector<Vector3D> myLattice;
+    std::vector<PairInt> myBlockPairs;
+    std::vector<TOneAtomPair> myThreadPairs;
+    ThreadForceBuffers myBuffers;
 
     static const unsigned int defaultBlockSize = 64;
   };
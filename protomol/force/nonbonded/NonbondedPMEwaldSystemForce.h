@@ -0,0 +1,551 @@
+/* -*- c++ -*- */
+#ifndef NONBONDEDPMEWALDSYSTEMFORCE_H
+#define NONBONDEDPMEWALDSYSTEMFORCE_H
+
+#include <protomol/force/nonbonded/NonbondedPMEwaldSystemForceBase.h>
+#include <protomol/force/nonbonded/NonbondedFullEwaldSystemForce.h>
+#include <protomol/force/system/SystemForce.h>
+#include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/FFTComplex.h>
+#include <protomol/type/ScalarStructure.h>
+#include <protomol/force/CoulombForce.h>
+#include <protomol/base/MathUtilities.h>
+#include <protomol/topology/Topology.h>
+#include <protomol/topology/PeriodicBoundaryConditions.h>
+#include <protomol/switch/CutoffSwitchingFunction.h>
+
+#include <vector>
+#include <algorithm>
+#include <string>
+
+using namespace ProtoMol::Report;
+
+namespace ProtoMol {
+
+  //_________________________________________________________________ NonbondedPMEwaldSystemForce
+
+  /**
+   * Smooth particle mesh Ewald (Essmann et al., J. Chem. Phys. 103, 8577,
+   * 1995). The real-space and correction terms are the ones of
+   * NonbondedFullEwaldSystemForce, the reciprocal term spreads the charges
+   * on a regular grid with cardinal B-splines of a given order, convolves
+   * the grid with the Ewald influence function by real-to-complex
+   * transforms of FFTComplex and interpolates the forces back with the
+   * analytic derivatives of the splines, O(N log N) instead of the
+   * O(N^1.5) of the k-vector sum.
+   *
+   * The splitting parameter alpha follows from the real-space cutoff and
+   * the accuracy, erfc(alpha*cutoff) ~ accuracy, the grid has at least
+   * one point every spacing Angstrom in each direction.
+   */
+  template<class TBoundaryConditions,
+           class TCellManager,
+           bool  real,
+           bool  reciprocal,
+           bool  correction,
+           class TSwitchingFunction>
+  class NonbondedPMEwaldSystemForce :
+    public SystemForce, private NonbondedPMEwaldSystemForceBase {
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Typedef
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    typedef Topology<TBoundaryConditions, TCellManager> RealTopologyType;
+    typedef NonbondedFullEwaldSystemForce<TBoundaryConditions, TCellManager,
+                                          real, false, correction,
+                                          TSwitchingFunction> EwaldType;
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    NonbondedPMEwaldSystemForce() :
+      SystemForce(), myCached(false), myCutoff(0.0), myAccuracy(0.0),
+      myOrder(0), mySpacing(0.0), myAlpha(0.0) {}
+
+    NonbondedPMEwaldSystemForce(Real cutoff, Real accuracy,
+                                unsigned int order, Real spacing) :
+      SystemForce(), myCached(false), myCutoff(cutoff),
+      myAccuracy(accuracy), myOrder(order), mySpacing(spacing),
+      myAlpha(sqrt(-log(accuracy)) / cutoff),
+      myEwald(myAlpha, accuracy, 3.0) {}
+
+    virtual ~NonbondedPMEwaldSystemForce() {}
+
+  private:
+    NonbondedPMEwaldSystemForce(const NonbondedPMEwaldSystemForce &);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class NonbondedPMEwaldSystemForce
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    void initialize(const RealTopologyType *realTopo);
+
+    void reciprocalTerm(const RealTopologyType *realTopo,
+                        const Vector3DBlock *positions,
+                        Vector3DBlock *forces, ScalarStructure *energies);
+
+    /// Smallest n >= m with no prime factors other than 2, 3 and 5
+    static int fftSize(int m);
+
+    /**
+     * Cardinal B-spline weights M_n(w + n - 1 - k) and their derivatives
+     * for k = 0..n-1, 0 <= w < 1 (Essmann et al., eq. 4.1).
+     */
+    static void fillSpline(Real w, unsigned int order, Real *theta,
+                           Real *dTheta);
+
+    /// Inverse squared moduli |b(m)|^-2 of the spline (Essmann, eq. 4.4)
+    static void splineModuli(unsigned int order, int n,
+                             std::vector<Real> &moduli);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class SystemForce
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    using SystemForce::evaluate; // Avoid compiler warning/error
+    virtual void evaluate(const GenericTopology *topo,
+                          const Vector3DBlock *positions,
+                          Vector3DBlock *forces, ScalarStructure *energies) {
+      const RealTopologyType *realTopo =
+        dynamic_cast<const RealTopologyType *>(topo);
+
+      if (real || correction)
+        myEwald.evaluate(topo, positions, forces, energies);
+
+      if (reciprocal) {
+        if (!myCached)
+          initialize(realTopo);
+        reciprocalTerm(realTopo, positions, forces, energies);
+      }
+    }
+
+    virtual void parallelEvaluate(const GenericTopology *topo,
+                                  const Vector3DBlock *positions,
+                                  Vector3DBlock *forces,
+                                  ScalarStructure *energies) {
+      const RealTopologyType *realTopo =
+        dynamic_cast<const RealTopologyType *>(topo);
+
+      if (real || correction)
+        myEwald.parallelEvaluate(topo, positions, forces, energies);
+
+      // The mesh is done as one block
+      if (reciprocal && Parallel::next()) {
+        if (!myCached)
+          initialize(realTopo);
+        reciprocalTerm(realTopo, positions, forces, energies);
+      }
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class Force
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    virtual unsigned int numberOfBlocks(const GenericTopology *topo,
+                                        const Vector3DBlock *positions) {
+      return ((real || correction) ?
+              myEwald.numberOfBlocks(topo, positions) : 0) +
+        (reciprocal ? 1 : 0);
+    }
+
+    virtual std::string getKeyword() const {return keyword;}
+
+    virtual void uncache() {
+      myCached = false;
+      myEwald.uncache();
+    }
+
+  private:
+    virtual Force *doMake(const std::vector<Value> &values) const {
+      Real cutoff = values[0];
+      Real accuracy = values[1];
+      unsigned int order = values[2];
+      Real spacing = values[3];
+      std::string err = "";
+
+      if (!values[0].valid())
+        err += " cutoff \'" + values[0].getString() + "\' not valid.";
+      if (!values[1].valid() || accuracy >= 1.0)
+        err += " accuracy \'" + values[1].getString() + "\' not valid.";
+      if (!values[2].valid() || order < 3)
+        err += " order \'" + values[2].getString() + "\' not valid (>= 3).";
+      if (!values[3].valid())
+        err += " spacing \'" + values[3].getString() + "\' not valid.";
+
+      if (!err.empty())
+        report << error << "force " << keyword << " :" << err << endr;
+
+      return new NonbondedPMEwaldSystemForce(cutoff, accuracy, order,
+                                             spacing);
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class Makeable
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    virtual std::string getIdNoAlias() const {
+      return CoulombForce::keyword + " -algorithm " + keyword +
+        std::string(real ? " -real" : "") +
+        std::string(reciprocal ? " -reciprocal" : "") +
+        std::string(correction ? " -correction" : "") +
+        ((TSwitchingFunction::getId() != CutoffSwitchingFunction::getId()) ?
+         std::string(" -switchingFunction " + TSwitchingFunction::getId()) :
+         std::string(""));
+    }
+
+    virtual void getParameters(std::vector<Parameter> &parameters) const {
+      parameters.push_back
+        (Parameter("-cutoff", Value(myCutoff, ConstraintValueType::Positive()),
+                   Text("real-space cutoff")));
+      parameters.push_back
+        (Parameter("-accuracy",
+                   Value(myAccuracy, ConstraintValueType::Positive()),
+                   0.00001, Text("erfc(alpha*cutoff), defines alpha")));
+      parameters.push_back
+        (Parameter("-order", Value(myOrder, ConstraintValueType::Positive()),
+                   4, Text("B-spline interpolation order")));
+      parameters.push_back
+        (Parameter("-spacing",
+                   Value(mySpacing, ConstraintValueType::Positive()), 1.0,
+                   Text("maximal grid spacing")));
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    bool myCached;
+    Real myCutoff;
+    Real myAccuracy;
+    unsigned int myOrder;
+    Real mySpacing;
+    Real myAlpha;
+
+    EwaldType myEwald;      // Real-space and correction terms
+
+    int myNX, myNY, myNZ;   // Grid dimensions
+    Real myLX, myLY, myLZ;
+    Real myLXr, myLYr, myLZr;
+    Real myV;
+    Vector3D myOrigin;
+
+    int myNZC;              // Non-negative z frequencies, myNZ/2 + 1
+    std::vector<double> myGrid;      // Charges, then convolution
+    std::vector<zomplex> myGridK;    // Structure factor, myNX*myNY*myNZC
+    std::vector<Real> myInfluence; // B(m)*exp(-PI^2 m^2/alpha^2)/(PI V m^2)
+    FFTComplex myFFT;
+
+    // Per atom and direction: first grid point and spline weights
+    std::vector<int> myIndex;
+    std::vector<Real> myTheta;
+    std::vector<Real> myDTheta;
+  };
+
+  //______________________________________________________________________ INLINES
+  template<class TBoundaryConditions, class TCellManager, bool real,
+           bool reciprocal, bool correction, class TSwitchingFunction>
+  int NonbondedPMEwaldSystemForce<TBoundaryConditions, TCellManager, real,
+                                  reciprocal, correction,
+                                  TSwitchingFunction>::fftSize(int m) {
+    for (int n = std::max(m, 1); ; n++) {
+      int k = n;
+      while (k % 2 == 0) k /= 2;
+      while (k % 3 == 0) k /= 3;
+      while (k % 5 == 0) k /= 5;
+      if (k == 1)
+        return n;
+    }
+  }
+
+  template<class TBoundaryConditions, class TCellManager, bool real,
+           bool reciprocal, bool correction, class TSwitchingFunction>
+  void NonbondedPMEwaldSystemForce<TBoundaryConditions, TCellManager, real,
+                                   reciprocal, correction,
+                                   TSwitchingFunction>::
+  fillSpline(Real w, unsigned int order, Real *theta, Real *dTheta) {
+    // Order 2
+    theta[order - 1] = 0.0;
+    theta[1] = w;
+    theta[0] = 1.0 - w;
+
+    // Up to order - 1 by the recursion
+    // M_n(x) = (x M_n-1(x) + (n - x) M_n-1(x - 1))/(n - 1)
+    for (unsigned int k = 3; k < order; k++) {
+      Real div = 1.0 / (k - 1);
+      theta[k - 1] = div * w * theta[k - 2];
+      for (unsigned int j = 1; j < k - 1; j++)
+        theta[k - j - 1] = div * ((w + j) * theta[k - j - 2] +
+                                  (k - j - w) * theta[k - j - 1]);
+      theta[0] = div * (1.0 - w) * theta[0];
+    }
+
+    // Derivatives, M_n'(x) = M_n-1(x) - M_n-1(x - 1)
+    dTheta[0] = -theta[0];
+    for (unsigned int j = 1; j < order; j++)
+      dTheta[j] = theta[j - 1] - theta[j];
+
+    // Order n
+    Real div = 1.0 / (order - 1);
+    theta[order - 1] = div * w * theta[order - 2];
+    for (unsigned int j = 1; j < order - 1; j++)
+      theta[order - j - 1] = div * ((w + j) * theta[order - j - 2] +
+                                    (order - j - w) * theta[order - j - 1]);
+    theta[0] = div * (1.0 - w) * theta[0];
+  }
+
+  template<class TBoundaryConditions, class TCellManager, bool real,
+           bool reciprocal, bool correction, class TSwitchingFunction>
+  void NonbondedPMEwaldSystemForce<TBoundaryConditions, TCellManager, real,
+                                   reciprocal, correction,
+                                   TSwitchingFunction>::
+  splineModuli(unsigned int order, int n, std::vector<Real> &moduli) {
+    // M_n(1) .. M_n(n-1)
+    std::vector<Real> theta(order), dTheta(order);
+    fillSpline(0.0, order, &theta[0], &dTheta[0]);
+
+    moduli.resize(n);
+    for (int m = 0; m < n; m++) {
+      Real sumCos = 0.0, sumSin = 0.0;
+      for (unsigned int k = 0; k + 1 < order; k++) {
+        Real a = 2.0 * M_PI * m * k / n;
+        sumCos += theta[order - 2 - k] * cos(a);
+        sumSin += theta[order - 2 - k] * sin(a);
+      }
+      moduli[m] = sumCos * sumCos + sumSin * sumSin;
+    }
+
+    // Odd orders vanish at m = n/2, interpolate (Essmann et al.)
+    for (int m = 0; m < n; m++)
+      if (moduli[m] < 1e-7)
+        moduli[m] = 0.5 * (moduli[(m - 1 + n) % n] + moduli[(m + 1) % n]);
+
+    for (int m = 0; m < n; m++)
+      moduli[m] = 1.0 / moduli[m];
+  }
+
+  template<class TBoundaryConditions, class TCellManager, bool real,
+           bool reciprocal, bool correction, class TSwitchingFunction>
+  void NonbondedPMEwaldSystemForce<TBoundaryConditions, TCellManager, real,
+                                   reciprocal, correction,
+                                   TSwitchingFunction>::
+  initialize(const RealTopologyType *realTopo) {
+    const PeriodicBoundaryConditions &boundary = realTopo->boundaryConditions;
+    if (!boundary.isOrthogonal())
+      report << error << "[NonbondedPMEwaldSystemForce::initialize] Not "
+             << "orthogonal, aborting." << endr;
+
+    myLX = boundary.e1().c[0];
+    myLY = boundary.e2().c[1];
+    myLZ = boundary.e3().c[2];
+    myLXr = boundary.e1r().c[0];
+    myLYr = boundary.e2r().c[1];
+    myLZr = boundary.e3r().c[2];
+    myV = boundary.getVolume();
+    myOrigin = boundary.origin();
+
+    // Grid, at least order points in each direction
+    const int order = static_cast<int>(myOrder);
+    myNX = fftSize(std::max(order, (int)ceil(myLX / mySpacing)));
+    myNY = fftSize(std::max(order, (int)ceil(myLY / mySpacing)));
+    myNZ = fftSize(std::max(order, (int)ceil(myLZ / mySpacing)));
+    myNZC = myNZ / 2 + 1;
+    myGrid.resize(myNX * myNY * myNZ);
+    myGridK.resize(myNX * myNY * myNZC);
+    myFFT.initialize(myNX, myNY, myNZ, &myGrid[0], &myGridK[0]);
+
+    // Influence function, m = (mx/Lx, my/Ly, mz/Lz), the charges are real
+    // so only mz >= 0 is stored
+    std::vector<Real> bx, by, bz;
+    splineModuli(myOrder, myNX, bx);
+    splineModuli(myOrder, myNY, by);
+    splineModuli(myOrder, myNZ, bz);
+
+    const Real fac = M_PI * M_PI / (myAlpha * myAlpha);
+    const Real c = 1.0 / (M_PI * myV);
+    myInfluence.resize(myGridK.size());
+    for (int x = 0; x < myNX; x++) {
+      Real mx = (x <= myNX / 2 ? x : x - myNX) * myLXr;
+      for (int y = 0; y < myNY; y++) {
+        Real my = (y <= myNY / 2 ? y : y - myNY) * myLYr;
+        for (int z = 0; z < myNZC; z++) {
+          Real mz = z * myLZr;
+          Real mSquared = mx * mx + my * my + mz * mz;
+          myInfluence[(x * myNY + y) * myNZC + z] =
+            (mSquared > 0.0 ?
+             c * bx[x] * by[y] * bz[z] * exp(-fac * mSquared) / mSquared :
+             0.0);
+        }
+      }
+    }
+
+    report << hint << "PMEwald: alpha=" << toString(myAlpha) << ", V=" << myV
+           << ", Rc=" << toString(myCutoff) << ", grid=" << myNX << "x"
+           << myNY << "x" << myNZ << ", order=" << myOrder << "." << endr;
+
+    myCached = true;
+  }
+
+  template<class TBoundaryConditions, class TCellManager, bool real,
+           bool reciprocal, bool correction, class TSwitchingFunction>
+  void NonbondedPMEwaldSystemForce<TBoundaryConditions, TCellManager, real,
+                                   reciprocal, correction,
+                                   TSwitchingFunction>::
+  reciprocalTerm(const RealTopologyType *realTopo,
+                 const Vector3DBlock *positions, Vector3DBlock *forces,
+                 ScalarStructure *energies) {
+    const unsigned int atomCount = realTopo->atoms.size();
+    const int order = static_cast<int>(myOrder);
+    const int n[3] = {myNX, myNY, myNZ};
+    const Real lr[3] = {myLXr, myLYr, myLZr};
+
+    myIndex.resize(3 * atomCount);
+    myTheta.resize(3 * atomCount * order);
+    myDTheta.resize(3 * atomCount * order);
+
+    // Spline weights and first grid point of each atom and direction
+    for (unsigned int i = 0; i < atomCount; i++) {
+      const Vector3D &r = (*positions)[i];
+      for (int d = 0; d < 3; d++) {
+        Real s = (r.c[d] - myOrigin.c[d]) * lr[d] + 0.5;
+        s -= floor(s);
+        Real u = s * n[d];
+        int k = static_cast<int>(u);
+        if (k >= n[d]) k -= n[d];
+        fillSpline(u - k, myOrder, &myTheta[(3 * i + d) * order],
+                   &myDTheta[(3 * i + d) * order]);
+        k -= order - 1;
+        myIndex[3 * i + d] = (k < 0 ? k + n[d] : k);
+      }
+    }
+
+    // Charge spreading
+    std::fill(myGrid.begin(), myGrid.end(), 0.0);
+    for (unsigned int i = 0; i < atomCount; i++) {
+      const Real q = realTopo->atoms[i].scaledCharge;
+      if (q == 0.0)
+        continue;
+      const Real *tx = &myTheta[(3 * i) * order];
+      const Real *ty = &myTheta[(3 * i + 1) * order];
+      const Real *tz = &myTheta[(3 * i + 2) * order];
+      int x = myIndex[3 * i];
+      for (int a = 0; a < order; a++, x = (x + 1 == myNX ? 0 : x + 1)) {
+        int y = myIndex[3 * i + 1];
+        for (int b = 0; b < order; b++, y = (y + 1 == myNY ? 0 : y + 1)) {
+          const Real qxy = q * tx[a] * ty[b];
+          double *line = &myGrid[(x * myNY + y) * myNZ];
+          int z = myIndex[3 * i + 2];
+          for (int c = 0; c < order; c++, z = (z + 1 == myNZ ? 0 : z + 1))
+            line[z] += qxy * tz[c];
+        }
+      }
+    }
+
+    myFFT.forward();
+
+    // Energy and virial, then convolution with the influence function
+    const bool doVirial = energies->virial();
+    const bool doMolVirial = energies->molecularVirial();
+    const Real fac = 1.0 / (4.0 * myAlpha * myAlpha);
+    Real energy = 0.0;
+    Real virialxx = 0.0, virialxy = 0.0, virialxz = 0.0;
+    Real virialyy = 0.0, virialyz = 0.0, virialzz = 0.0;
+    for (int x = 0; x < myNX; x++) {
+      Real kx = 2.0 * M_PI * (x <= myNX / 2 ? x : x - myNX) * myLXr;
+      for (int y = 0; y < myNY; y++) {
+        Real ky = 2.0 * M_PI * (y <= myNY / 2 ? y : y - myNY) * myLYr;
+        for (int z = 0; z < myNZC; z++) {
+          const int l = (x * myNY + y) * myNZC + z;
+          zomplex &g = myGridK[l];
+          const Real theta = myInfluence[l];
+          // Each stored mz > 0 stands for its conjugate -mz as well
+          const Real weight = (z == 0 || 2 * z == myNZ ? 0.5 : 1.0);
+          const Real e = weight * theta * (g.re * g.re + g.im * g.im);
+          energy += e;
+          if ((doVirial || doMolVirial) && theta > 0.0) {
+            Real kz = 2.0 * M_PI * z * myLZr;
+            Real c = 2.0 * (1.0 / (kx * kx + ky * ky + kz * kz) + fac);
+            virialxx += e * (1.0 - c * kx * kx);
+            virialxy -= e * c * kx * ky;
+            virialxz -= e * c * kx * kz;
+            virialyy += e * (1.0 - c * ky * ky);
+            virialyz -= e * c * ky * kz;
+            virialzz += e * (1.0 - c * kz * kz);
+          }
+          g.re *= theta;
+          g.im *= theta;
+        }
+      }
+    }
+
+    myFFT.backward();
+
+    // Forces, F_i = -q_i sum_k grad(theta_i(k)) (theta_rec * Q)(k)
+    const Real sx = myNX * myLXr, sy = myNY * myLYr, sz = myNZ * myLZr;
+    for (unsigned int i = 0; i < atomCount; i++) {
+      const Real q = realTopo->atoms[i].scaledCharge;
+      if (q == 0.0)
+        continue;
+      const Real *tx = &myTheta[(3 * i) * order];
+      const Real *ty = &myTheta[(3 * i + 1) * order];
+      const Real *tz = &myTheta[(3 * i + 2) * order];
+      const Real *dx = &myDTheta[(3 * i) * order];
+      const Real *dy = &myDTheta[(3 * i + 1) * order];
+      const Real *dz = &myDTheta[(3 * i + 2) * order];
+      Real fx = 0.0, fy = 0.0, fz = 0.0;
+      int x = myIndex[3 * i];
+      for (int a = 0; a < order; a++, x = (x + 1 == myNX ? 0 : x + 1)) {
+        int y = myIndex[3 * i + 1];
+        for (int b = 0; b < order; b++, y = (y + 1 == myNY ? 0 : y + 1)) {
+          const double *line = &myGrid[(x * myNY + y) * myNZ];
+          int z = myIndex[3 * i + 2];
+          for (int c = 0; c < order; c++, z = (z + 1 == myNZ ? 0 : z + 1)) {
+            const Real g = line[z];
+            fx += dx[a] * ty[b] * tz[c] * g;
+            fy += tx[a] * dy[b] * tz[c] * g;
+            fz += tx[a] * ty[b] * dz[c] * g;
+          }
+        }
+      }
+      Vector3D fi(-q * sx * fx, -q * sy * fy, -q * sz * fz);
+      (*forces)[i] += fi;
+
+      // Reciprocal contribution to the molecular virial (Darden et al.,
+      // J. Chem. Phys. 103 (19), 8577)
+      if (doMolVirial) {
+        int mi = realTopo->atoms[i].molecule;
+        Vector3D ri(realTopo->boundaryConditions.
+                    minimalPosition((*positions)[i]));
+        Vector3D mri(realTopo->boundaryConditions.
+                     minimalDifference(ri, realTopo->molecules[mi].position));
+        energies->addMolVirial(fi, mri);
+      }
+    }
+
+    (*energies)[ScalarStructure::COULOMB] += energy;
+
+    if (doVirial) {
+      (*energies)[ScalarStructure::VIRIALXX] += virialxx;
+      (*energies)[ScalarStructure::VIRIALXY] += virialxy;
+      (*energies)[ScalarStructure::VIRIALXZ] += virialxz;
+      (*energies)[ScalarStructure::VIRIALYX] += virialxy;
+      (*energies)[ScalarStructure::VIRIALYY] += virialyy;
+      (*energies)[ScalarStructure::VIRIALYZ] += virialyz;
+      (*energies)[ScalarStructure::VIRIALZX] += virialxz;
+      (*energies)[ScalarStructure::VIRIALZY] += virialyz;
+      (*energies)[ScalarStructure::VIRIALZZ] += virialzz;
+    }
+    if (doMolVirial) {
+      (*energies)[ScalarStructure::MOLVIRIALXX] += virialxx;
+      (*energies)[ScalarStructure::MOLVIRIALXY] += virialxy;
+      (*energies)[ScalarStructure::MOLVIRIALXZ] += virialxz;
+      (*energies)[ScalarStructure::MOLVIRIALYX] += virialxy;
+      (*energies)[ScalarStructure::MOLVIRIALYY] += virialyy;
+      (*energies)[ScalarStructure::MOLVIRIALYZ] += virialyz;
+      (*energies)[ScalarStructure::MOLVIRIALZX] += virialxz;
+      (*energies)[ScalarStructure::MOLVIRIALZY] += virialyz;
+      (*energies)[ScalarStructure::MOLVIRIALZZ] += virialzz;
+    }
+  }
+}
+#endif /* NONBONDEDPMEWALDSYSTEMFORCE_H */
@@ -0,0 +1,8 @@
+#include <protomol/force/nonbonded/NonbondedPMEwaldSystemForceBase.h>
+using std::string;
+
+namespace ProtoMol {
+  //_________________________________________________________________ NonbondedPMEwaldSystemForceBase
+
+  const string NonbondedPMEwaldSystemForceBase::keyword("PMEwald");
+}
@@ -0,0 +1,15 @@
+/*  -*- c++ -*-  */
+#ifndef NONBONDEDPMEWALDSYSTEMFORCEBASE_H
+#define NONBONDEDPMEWALDSYSTEMFORCEBASE_H
+
+#include<string>
+
+namespace ProtoMol {
+  //_________________________________________________________________ NonbondedPMEwaldSystemForceBase
+  
+  class NonbondedPMEwaldSystemForceBase {
+  public:
+    static const std::string keyword;
+  };
+}
+#endif /* NONBONDEDPMEWALDSYSTEMFORCEBASE_H */
@@ -129,6 +129,10 @@ namespace ProtoMol {
         (const RealTopologyType *)(topo);
       
       myOneAtomPair.initialize(realTopo, positions, forces, energies);
+
+      // The partners of atom i in a block are a contiguous range of atoms,
+      // handed to the pair kernel at once through the atom index table.
+      const int *atoms = atomIndices(topo->atoms.size());
       
       for (int blocki = i0; blocki < i1; blocki += myBlockSize) {
         int blocki_max = blocki;
@@ -142,13 +146,23 @@ namespace ProtoMol {
             if (jstart <= i) jstart = i + 1;
             int jend = blockj + myBlockSize;
             if (jend > j1) jend = j1;
-            for (int j = jstart; j < jend; j++)
-              myOneAtomPair.doOneAtomPair(i, j);
+            if (jstart < jend)
+              myOneAtomPair.doAtomPairBlock(i, atoms + jstart, atoms + jend);
           }
         }
       }
     }
 
+    /// Returns the table 0, 1, ..., n - 1 of atom indices
+    const int *atomIndices(unsigned int n) {
+      if (myAtoms.size() != n) {
+        myAtoms.resize(n);
+        for (unsigned int i = 0; i < n; i++)
+          myAtoms[i] = i;
+      }
+      return n ? &myAtoms[0] : 0;
+    }
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // My data members
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -157,6 +171,7 @@ namespace ProtoMol {
     unsigned int myBlockSize;
     std::vector<PairUInt> myFromRange;
     std::vector<PairUInt> myToRange;
+    std::vector<int> myAtoms;
     bool myCached;
 
     static const unsigned int defaultBlockSize = 64;
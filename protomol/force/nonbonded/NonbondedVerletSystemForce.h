@@ -0,0 +1,188 @@
+/* -*- c++ -*- */
+#ifndef NONBONDEDVERLETSYSTEMFORCE_H
+#define NONBONDEDVERLETSYSTEMFORCE_H
+
+#include <protomol/force/system/SystemForce.h>
+#include <protomol/parallel/Parallel.h>
+#include <protomol/topology/Topology.h>
+#include <protomol/topology/VerletList.h>
+
+namespace ProtoMol {
+  //____ NonbondedVerletSystemForce
+
+  /**
+   * Cutoff force evaluated over a persistent Verlet neighbor list. The
+   * list holds all pairs within cutoff + skin and is reused until an atom
+   * moved more than half the skin, such that the cell lists are only
+   * traversed on a rebuild. The atoms are visited in the list's
+   * space-filling curve order, so that consecutive blocks of a parallel
+   * evaluation cover compact regions.
+   *
+   * The list has the exclusions compiled in, the pairs of each row are
+   * evaluated without exclusion look ups, the modified (scaled 1-4) pairs
+   * of the rows in a second pass.
+   *
+   * The list is shared with all other Verlet forces of the same cutoff and
+   * skin (see VerletList::shared()), e.g., with the forces of the other
+   * levels of a multiple time stepping integrator.
+   */
+  template<class TCellManager, class TOneAtomPair>
+  class NonbondedVerletSystemForce : public SystemForce {
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Typedef
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    typedef typename TOneAtomPair::BoundaryConditions BoundaryConditions;
+    typedef Topology<BoundaryConditions, TCellManager> RealTopologyType;
+    typedef VerletList<BoundaryConditions, TCellManager> VerletListType;
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    NonbondedVerletSystemForce() :
+      SystemForce(), myCutoff(0.0), mySkin(defaultSkin), myVerletList(NULL) {}
+
+    NonbondedVerletSystemForce(Real cutoff, TOneAtomPair oneAtomPair,
+                               Real skin = defaultSkin) :
+      SystemForce(), myCutoff(cutoff), mySkin(skin),
+      myOneAtomPair(oneAtomPair), myVerletList(NULL) {}
+
+    virtual ~NonbondedVerletSystemForce() {}
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class NonbondedVerletSystemForce
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    /// Looks up the shared list and brings it up to date
+    void updateList(const RealTopologyType *topo,
+                    const Vector3DBlock *positions) {
+      myVerletList = &VerletListType::shared(topo, myCutoff, mySkin);
+      myVerletList->update(topo, positions, myCutoff, mySkin);
+    }
+
+    void doEvaluate(unsigned int from, unsigned int to) {
+      const VerletListType &list = *myVerletList;
+      for (unsigned int k = from; k < to; k++)
+        myOneAtomPair.doAtomPairBlock(list.atom(k), list.begin(k),
+                                      list.end(k), EXCLUSION_NONE);
+
+      for (unsigned int k = from; k < to; k++)
+        if (list.beginModified(k) != list.endModified(k))
+          myOneAtomPair.doAtomPairBlock(list.atom(k), list.beginModified(k),
+                                        list.endModified(k),
+                                        EXCLUSION_MODIFIED);
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class SystemForce
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    using SystemForce::evaluate; // Avoid compiler warning/error
+    virtual void evaluate(const GenericTopology *topo,
+                          const Vector3DBlock *positions,
+                          Vector3DBlock *forces, ScalarStructure *energies) {
+      const RealTopologyType *realTopo = (const RealTopologyType *)topo;
+      myOneAtomPair.initialize(realTopo, positions, forces, energies);
+      updateList(realTopo, positions);
+      doEvaluate(0, myVerletList->size());
+    }
+
+    virtual void parallelEvaluate(const GenericTopology *topo,
+                                  const Vector3DBlock *positions,
+                                  Vector3DBlock *forces,
+                                  ScalarStructure *energies) {
+      const RealTopologyType *realTopo =
+        dynamic_cast<const RealTopologyType *>(topo);
+
+      myOneAtomPair.initialize(realTopo, positions, forces, energies);
+      updateList(realTopo, positions);
+
+      unsigned int n = myVerletList->size();
+      unsigned int count = numberOfBlocks(realTopo, positions);
+
+      for (unsigned int i = 0; i < count; i++)
+        if (Parallel::next())
+          doEvaluate((n * i) / count, (n * (i + 1)) / count);
+    }
+
+    virtual void preProcess(const GenericTopology *apptopo,
+                            const Vector3DBlock *positions) {
+      myOneAtomPair.preProcess(apptopo, positions);
+    }
+
+    virtual void postProcess(const GenericTopology *apptopo,
+                             ScalarStructure *appenergies,
+                             Vector3DBlock *forces) {
+      myOneAtomPair.postProcess(apptopo, appenergies, forces);
+    }
+
+    virtual void parallelPostProcess(const GenericTopology *apptopo,
+                                     ScalarStructure *appenergies) {
+      myOneAtomPair.parallelPostProcess(apptopo, appenergies);
+    }
+
+    virtual bool doParallelPostProcess() {
+      return myOneAtomPair.doParallelPostProcess();
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class Force
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    virtual unsigned int numberOfBlocks(const GenericTopology *topo,
+                                        const Vector3DBlock *) {
+      return Parallel::getNumberOfPackages(topo->atoms.size());
+    }
+
+    virtual std::string getKeyword() const {return "NonbondedVerlet";}
+
+    virtual void uncache() {if (myVerletList) myVerletList->uncache();}
+
+  private:
+    virtual Force *doMake(const std::vector<Value> &values) const {
+      int n = values.size() - 2;
+      std::vector<Value> atomPairValues(values.begin(), values.end() - 2);
+
+      return new NonbondedVerletSystemForce(values[n],
+                                            TOneAtomPair::make(atomPairValues),
+                                            values[n + 1]);
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // From class Makeable
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    virtual std::string getIdNoAlias() const {
+      return TOneAtomPair::getId() + " -algorithm " + getKeyword();
+    }
+
+    virtual void getParameters(std::vector<Parameter> &parameters) const {
+      myOneAtomPair.getParameters(parameters);
+      parameters.push_back
+        (Parameter("-cutoff", Value(myCutoff, ConstraintValueType::Positive()),
+                   Text("algorithm cutoff")));
+      parameters.push_back
+        (Parameter("-skin",
+                   Value(mySkin, ConstraintValueType::NotNegative()),
+                   defaultSkin,
+                   Text("Verlet list buffer beyond the cutoff")));
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    Real myCutoff;
+    Real mySkin;
+    TOneAtomPair myOneAtomPair;
+    VerletListType *myVerletList; // Shared, owned by the topology
+
+    static const Real defaultSkin;
+  };
+
+  template<class TCellManager, class TOneAtomPair>
+  const Real NonbondedVerletSystemForce<TCellManager, TOneAtomPair>::
+    defaultSkin = 2.0;
+}
+#endif /* NONBONDEDVERLETSYSTEMFORCE_H */
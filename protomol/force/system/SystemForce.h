@@ -78,6 +78,18 @@ namespace ProtoMol {
     // either by ranges or sequences. Overload numberOfBlocks() such that the 
     // number matches the next() calls inside parallelEvaluate().
 
+    /**
+     * Range of the interactions for the halo of the spatial domain
+     * decomposition (see DomainDecomposition), where parallelEvaluate()
+     * only computes the interactions starting at atoms owned by the node.
+     * Negative if the force does not support domain decomposition. Called
+     * before each exchange of the halo; at the first call all nodes know
+     * all atoms, such that a range computed from the positions once is the
+     * same on all nodes.
+     */
+    virtual Real getDomainHalo(const GenericTopology *,
+                               const Vector3DBlock *) {return -1.0;}
+
     virtual CompareForce *makeCompareForce(Force *actualForce,
                                            CompareForce *compareForce) const;
     virtual TimeForce *makeTimeForce(Force *actualForce) const;
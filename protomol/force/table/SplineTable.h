@@ -0,0 +1,165 @@
+/*  -*- c++ -*-  */
+#ifndef SPLINETABLE_H
+#define SPLINETABLE_H
+
+#include <protomol/type/Real.h>
+
+namespace ProtoMol {
+  //____ SplineTable
+
+  /**
+   * Cubic Hermite spline table of TERMS functions of the squared
+   * distance r^2 on a uniform grid [from, to]. The look up index is
+   * (r^2 - from)/delta, hence neither a sqrt nor any bit hashing is needed.
+   * Each node holds NV = 4 coefficients (value, gradient, 2. and 3. order)
+   * per term, the terms of a node are stored next to each other such that
+   * a look up touches one or two cache lines of the aligned table.
+   *
+   * The functions are given by a kernel with
+   * void operator()(Real r2, Real *value, Real *deriv) const, returning the
+   * value and the derivative with respect to r^2 of all terms.
+   */
+  template<unsigned int TERMS, typename TReal = Real>
+  class SplineTable {
+  public:
+    enum {NV = 4};
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    SplineTable() :
+      myTable(0), myMem(0), mySize(0), myAlign(0), myPoints(0),
+      myFrom(0.0), myTo(0.0), myDelta(0.0), myInvDelta(0.0) {}
+
+    SplineTable(const SplineTable &rhs) : myTable(0), myMem(0) {copy(rhs);}
+
+    ~SplineTable() {
+      if (myMem != 0) delete[] myMem;
+    }
+
+    SplineTable &operator=(const SplineTable &rhs) {
+      if (&rhs != this) copy(rhs);
+      return *this;
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class SplineTable
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    /// Tabulates the functions of kernel with points intervals
+    template<class TKernel>
+    void build(const TKernel &kernel, Real from, Real to, int points,
+               unsigned int align = 64) {
+      myPoints = points;
+      myFrom = from;
+      myTo = to;
+      myDelta = (to - from) / points;
+      myInvDelta = 1.0 / myDelta;
+      allocate((points + 1) * TERMS * NV, align);
+
+      Real v0[TERMS], g0[TERMS], v1[TERMS], g1[TERMS];
+      const Real h = myDelta;
+
+      kernel(from, v0, g0);
+      for (int i = 0; i < points; i++) {
+        kernel(from + (i + 1) * h, v1, g1);
+        TReal *t = myTable + i * TERMS * NV;
+        for (unsigned int k = 0; k < TERMS; k++) {
+          Real dv = v1[k] - v0[k];
+          t[k * NV + 0] = v0[k];
+          t[k * NV + 1] = g0[k];
+          t[k * NV + 2] = (3.0 * dv - h * (2.0 * g0[k] + g1[k])) / (h * h);
+          t[k * NV + 3] = (-2.0 * dv + h * (g0[k] + g1[k])) / (h * h * h);
+          v0[k] = v1[k];
+          g0[k] = g1[k];
+        }
+      }
+      // Last node, only reached by r^2 == to
+      TReal *t = myTable + points * TERMS * NV;
+      for (unsigned int k = 0; k < TERMS; k++) {
+        t[k * NV + 0] = v0[k];
+        t[k * NV + 1] = g0[k];
+        t[k * NV + 2] = 0.0;
+        t[k * NV + 3] = 0.0;
+      }
+    }
+
+    /// r^2 is covered by the table
+    bool inside(Real distSquared) const {
+      return distSquared >= myFrom && distSquared <= myTo;
+    }
+
+    /**
+     * Energy and force (-dE/dr/r) of the sum of the terms weighted by
+     * coefficients, r^2 must be inside().
+     */
+    void operator()(Real distSquared, const Real *coefficients, Real &energy,
+                    Real &force) const {
+      Real x = (distSquared - myFrom) * myInvDelta;
+      int i = static_cast<int>(x);
+      Real dt = (x - i) * myDelta;
+      const TReal *t = myTable + i * TERMS * NV;
+      Real a = 0.0, b = 0.0, c = 0.0, d = 0.0;
+      for (unsigned int k = 0; k < TERMS; k++, t += NV) {
+        a += t[0] * coefficients[k];
+        b += t[1] * coefficients[k];
+        c += t[2] * coefficients[k];
+        d += t[3] * coefficients[k];
+      }
+      energy = ((dt * d + c) * dt + b) * dt + a;
+      force = -2.0 * ((3.0 * dt * d + 2.0 * c) * dt + b);
+    }
+
+    Real from() const {return myFrom;}
+    Real to() const {return myTo;}
+    Real delta() const {return myDelta;}
+    int points() const {return myPoints;}
+    /// Table size in bytes
+    unsigned int size() const {return mySize * sizeof(TReal);}
+
+  private:
+    void allocate(int size, unsigned int align) {
+      if (myMem != 0) delete[] myMem;
+      mySize = size;
+      myAlign = align;
+      myMem = new TReal[size + align / sizeof(TReal)];
+      myTable = myMem;
+      while ((long)(myTable) % align)
+        ++myTable;
+    }
+
+    void copy(const SplineTable &rhs) {
+      myPoints = rhs.myPoints;
+      myFrom = rhs.myFrom;
+      myTo = rhs.myTo;
+      myDelta = rhs.myDelta;
+      myInvDelta = rhs.myInvDelta;
+      if (rhs.myMem == 0) {
+        if (myMem != 0) delete[] myMem;
+        myMem = myTable = 0;
+        mySize = 0;
+        myAlign = rhs.myAlign;
+        return;
+      }
+      allocate(rhs.mySize, rhs.myAlign);
+      for (int i = 0; i < mySize; i++)
+        myTable[i] = rhs.myTable[i];
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    TReal *myTable;
+    TReal *myMem;
+    int mySize;
+    unsigned int myAlign;
+    int myPoints;
+    Real myFrom;
+    Real myTo;
+    Real myDelta;
+    Real myInvDelta;
+  };
+}
+#endif /* SPLINETABLE_H */
@@ -0,0 +1,264 @@
+/* -*- c++ -*- */
+#ifndef SPLINETABLEFORCE_H
+#define SPLINETABLEFORCE_H
+
+#include <protomol/topology/GenericTopology.h>
+#include <protomol/topology/LennardJonesParameters.h>
+#include <protomol/type/ScalarStructure.h>
+#include <protomol/topology/ExclusionTable.h>
+#include <protomol/config/Parameter.h>
+#include <protomol/base/MathUtilities.h>
+#include <protomol/base/Report.h>
+#include <protomol/force/ThreadSafeForce.h>
+#include <protomol/force/CoulombForce.h>
+#include <protomol/force/LennardJonesForce.h>
+#include <protomol/force/table/SplineTable.h>
+#include <string>
+#include <cmath>
+
+namespace ProtoMol {
+  //____ SplineTableKernel
+
+  /**
+   * Splits a pair potential into TERMS functions of r^2 weighted by
+   * coefficients of the atom pair, the functions get tabulated by
+   * SplineTableForce. Defined for the potentials which can be tabulated.
+   */
+  template<class TForce>
+  struct SplineTableKernel;
+
+  /// q1*q2/r
+  template<>
+  struct SplineTableKernel<CoulombForce> {
+    enum {TERMS = 1};
+
+    static void terms(Real distSquared, Real *value, Real *deriv) {
+      Real r1 = 1.0 / sqrt(distSquared);
+      value[0] = r1;
+      deriv[0] = -0.5 * r1 / distSquared;
+    }
+
+    static void coefficients(const GenericTopology *topo, int atom1,
+                             int atom2, ExclusionClass excl, Real *c) {
+      c[0] = topo->atoms[atom1].scaledCharge * topo->atoms[atom2].scaledCharge;
+      if (excl == EXCLUSION_MODIFIED)
+        c[0] *= topo->coulombScalingFactor;
+    }
+  };
+
+  /// A/r^12 - B/r^6
+  template<>
+  struct SplineTableKernel<LennardJonesForce> {
+    enum {TERMS = 2};
+
+    static void terms(Real distSquared, Real *value, Real *deriv) {
+      Real r2 = 1.0 / distSquared;
+      Real r6 = r2 * r2 * r2;
+      value[0] = r6 * r6;
+      deriv[0] = -6.0 * value[0] * r2;
+      value[1] = -r6;
+      deriv[1] = 3.0 * r6 * r2;
+    }
+
+    static void coefficients(const GenericTopology *topo, int atom1,
+                             int atom2, ExclusionClass excl, Real *c) {
+      const LennardJonesParameters &params =
+        topo->lennardJonesParameters(topo->atoms[atom1].type,
+                                     topo->atoms[atom2].type);
+      c[0] = (excl != EXCLUSION_MODIFIED ? params.A : params.A14);
+      c[1] = (excl != EXCLUSION_MODIFIED ? params.B : params.B14);
+    }
+  };
+
+  //____ SplineTableForce
+
+  /**
+   * Tabulated form of the potential TForce multiplied by the switching
+   * function TSwitchingFunction, using a cubic spline table in r^2 (see
+   * SplineTable). The switching function is part of the table, hence
+   * SplineTableForce is used with UniversalSwitchingFunction in OneAtomPair
+   * and OneAtomPairTwo and replaces the sqrt, pow and division of both the
+   * potential and the switching function by one look up.
+   *
+   * The table starts at r = 1; closer pairs are evaluated analytically.
+   * When the table is built the maximal relative errors of the energy and
+   * the force against the analytic kernel are reported.
+   */
+  template<class TSwitchingFunction, class TForce, typename TReal = Real>
+  class SplineTableForce {
+    typedef SplineTableKernel<TForce> Kernel;
+
+    /// Switched terms for the table, derivatives with respect to r^2
+    class Switched {
+    public:
+      Switched(const TSwitchingFunction &swf) : mySwf(swf) {}
+
+      void operator()(Real distSquared, Real *value, Real *deriv) const {
+        Real s, ds;
+        Kernel::terms(distSquared, value, deriv);
+        mySwf(s, ds, distSquared);
+        for (int k = 0; k < Kernel::TERMS; k++) {
+          deriv[k] = deriv[k] * s + 0.5 * value[k] * ds;
+          value[k] *= s;
+        }
+      }
+
+    private:
+      const TSwitchingFunction &mySwf;
+    };
+
+  public:
+    enum {DIST_R2 = 0};
+    enum {CUTOFF = 1};
+    /// Number of table intervals
+    enum {POINTS = 4096};
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    SplineTableForce() : myCutoff(0.0), myCutoff2(0.0) {}
+
+    SplineTableForce(TSwitchingFunction swf, Real rc, int points = POINTS) :
+      myCutoff(rc), myCutoff2(rc * rc), switchingFunction(swf) {
+      myTable.build(Switched(switchingFunction), 1.0, myCutoff2, points);
+      reportAccuracy();
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class SplineTableForce
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    void operator()(Real &energy, Real &force,
+                    Real distSquared, Real /*rDistSquared*/,
+                    const Vector3D & /*diff*/, const GenericTopology *topo,
+                    int atom1, int atom2, ExclusionClass excl) const {
+      Real c[Kernel::TERMS];
+      Kernel::coefficients(topo, atom1, atom2, excl, c);
+
+      if (myTable.inside(distSquared))
+        myTable(distSquared, c, energy, force);
+      else if (distSquared < myTable.from())
+        analytic(distSquared, c, energy, force);
+      else
+        energy = force = 0.0;
+    }
+
+    static void accumulateEnergy(ScalarStructure *energies, Real energy) {
+      TForce::accumulateEnergy(energies, energy);
+    }
+
+    static Real getEnergy(const ScalarStructure *energies) {
+      return TForce::getEnergy(energies);
+    }
+
+    static std::string getKeyword() {return TForce::keyword + "Spline";}
+
+    static void preProcess(const GenericTopology *, const Vector3DBlock *) {}
+
+    static void postProcess(const GenericTopology *, ScalarStructure *,
+                            Vector3DBlock *) {}
+
+    static void parallelPostProcess(const GenericTopology *,
+                                    ScalarStructure *) {}
+
+    static bool doParallelPostProcess() {return false;}
+
+    // Parsing
+    static std::string getId() {
+      return getKeyword() +
+        std::string(!TSwitchingFunction::USE ? "" :
+                    std::string(" -switchingFunction " +
+                                TSwitchingFunction::getId()));
+    }
+
+    void getParameters(std::vector<Parameter> &parameters) const {
+      switchingFunction.getParameters(parameters);
+      if (!TSwitchingFunction::CUTOFF)
+        parameters.push_back
+          (Parameter("-cutoff",
+                     Value(myCutoff, ConstraintValueType::Positive()),
+                     Text("cutoff for table look up")));
+    }
+
+    static unsigned int getParameterSize() {
+      return TSwitchingFunction::getParameterSize() +
+        (TSwitchingFunction::CUTOFF ? 0 : 1);
+    }
+
+    static SplineTableForce make(const std::vector<Value> &values) {
+      if (!TSwitchingFunction::CUTOFF) {
+        std::vector<Value> sValues(values.begin(), values.end() - 1);
+        return SplineTableForce(TSwitchingFunction::make(sValues),
+                                values[values.size() - 1]);
+      }
+      TSwitchingFunction swf = TSwitchingFunction::make(values);
+      return SplineTableForce(swf, swf.cutoff());
+    }
+
+    Real cutoffSquared() const {return myCutoff2;}
+
+  private:
+    void analytic(Real distSquared, const Real *c, Real &energy,
+                  Real &force) const {
+      Real value[Kernel::TERMS], deriv[Kernel::TERMS];
+      Switched kernel(switchingFunction);
+      kernel(distSquared, value, deriv);
+      energy = force = 0.0;
+      for (int k = 0; k < Kernel::TERMS; k++) {
+        energy += c[k] * value[k];
+        force -= 2.0 * c[k] * deriv[k];
+      }
+    }
+
+    /**
+     * Compares each term at three points per interval with the kernel, the
+     * errors are relative to the unswitched energy and force, such that
+     * the vanishing values at the cutoff do not dominate.
+     */
+    void reportAccuracy() const {
+      Real errE = 0.0, errF = 0.0;
+      Real c[Kernel::TERMS];
+      Real value[Kernel::TERMS], deriv[Kernel::TERMS];
+      for (int i = 0; i < myTable.points(); i++)
+        for (int j = 1; j < 4; j++) {
+          Real r2 = myTable.from() + (i + 0.25 * j) * myTable.delta();
+          Real s, ds;
+          Kernel::terms(r2, value, deriv);
+          switchingFunction(s, ds, r2);
+          for (int k = 0; k < Kernel::TERMS; k++) {
+            for (int l = 0; l < Kernel::TERMS; l++)
+              c[l] = (k == l ? 1.0 : 0.0);
+            Real e, f;
+            myTable(r2, c, e, f);
+            Real e0 = value[k] * s;
+            Real f0 = -2.0 * deriv[k] * s - value[k] * ds;
+            Real scaleF = fabs(2.0 * deriv[k]) + fabs(value[k] * ds);
+            errE = std::max(errE, fabs(e - e0) / fabs(value[k]));
+            errF = std::max(errF, fabs(f - f0) / scaleF);
+          }
+        }
+
+      Report::report
+        << Report::hint << getKeyword() << ": " << myTable.points()
+        << " points, r^2=[" << myTable.from() << "," << myTable.to()
+        << "], " << myTable.size() / 1024 << " kB, relative error: energy="
+        << errE << ", force=" << errF << "." << Report::endr;
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    Real myCutoff;
+    Real myCutoff2;
+    TSwitchingFunction switchingFunction;
+    SplineTable<Kernel::TERMS, TReal> myTable;
+  };
+
+  template<class TSwitchingFunction, class TForce, typename TReal>
+  struct ThreadSafeForce<SplineTableForce<TSwitchingFunction, TForce, TReal> > {
+    enum {VALUE = 1};
+  };
+}
+#endif /* SPLINETABLEFORCE_H */
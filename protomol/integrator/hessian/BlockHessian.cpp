@@ -30,6 +30,7 @@
 #include <protomol/topology/SemiGenericTopology.h>
 #include <protomol/topology/VacuumBoundaryConditions.h>
 #include <protomol/type/BlockMatrix.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
 
 #include <protomol/force/bonded/BondSystemForce.h>
 #include <protomol/force/bonded/AngleSystemForce.h>
@@ -261,6 +262,43 @@ void BlockHessian::initialResidueData(const GenericTopology *myTopo, int res_per
     electroStatics.initialize(0,0,_3N,_3N);
     memory_base += _3N * _3N;
   }
+  //bonded terms with all atoms inside one block, for evaluateResidues
+  block_terms.assign(num_blocks, BlockTerms());
+  for(unsigned int i=0;i<myTopo->rb_dihedrals.size();i++){
+    const RBTorsion &rbt = myTopo->rb_dihedrals[i];
+    const int ar0 = atom_block[rbt.atom1];
+    if((rbt.C0 || rbt.C1 || rbt.C2 || rbt.C3 || rbt.C4 || rbt.C5) &&
+        atom_block[rbt.atom2] == ar0 && atom_block[rbt.atom3] == ar0 && atom_block[rbt.atom4] == ar0)
+      block_terms[ar0].rbDihedrals.push_back(i);
+  }
+  for(unsigned int i=0;i<myTopo->impropers.size();i++){
+    const Torsion &tor = myTopo->impropers[i];
+    bool nonZForce = false;       //test for force constants
+    for (int j = 0; j < tor.multiplicity; j++)
+      if (tor.forceConstant[j]) nonZForce = true;
+    const int ar0 = atom_block[tor.atom1];
+    if(nonZForce && atom_block[tor.atom2] == ar0 && atom_block[tor.atom3] == ar0 && atom_block[tor.atom4] == ar0)
+      block_terms[ar0].impropers.push_back(i);
+  }
+  for(unsigned int i=0;i<myTopo->dihedrals.size();i++){
+    const Torsion &tor = myTopo->dihedrals[i];
+    bool nonZForce = false;       //test for force constants
+    for (int j = 0; j < tor.multiplicity; j++)
+      if (tor.forceConstant[j]) nonZForce = true;
+    const int ar0 = atom_block[tor.atom1];
+    if(nonZForce && atom_block[tor.atom2] == ar0 && atom_block[tor.atom3] == ar0 && atom_block[tor.atom4] == ar0)
+      block_terms[ar0].dihedrals.push_back(i);
+  }
+  for(unsigned int i=0;i<myTopo->bonds.size();i++){
+    const int ar0 = atom_block[myTopo->bonds[i].atom1];
+    if(atom_block[myTopo->bonds[i].atom2] == ar0)
+      block_terms[ar0].bonds.push_back(i);
+  }
+  for(unsigned int i=0;i<myTopo->angles.size();i++){
+    const int ar0 = atom_block[myTopo->angles[i].atom1];
+    if(atom_block[myTopo->angles[i].atom2] == ar0 && atom_block[myTopo->angles[i].atom3] == ar0)
+      block_terms[ar0].angles.push_back(i);
+  }
 
 }
 
@@ -270,255 +308,14 @@ void BlockHessian::initialResidueData(const GenericTopology *myTopo, int res_per
 void BlockHessian::evaluateResidues(const Vector3DBlock *myPositions,
                                       GenericTopology *myTopo,
                                         bool simuMin) {
-  int a1, a2, a3;
-  unsigned int i;
-  ReducedHessAngle rh;
-  Matrix3By3 rha;
-  
-  //
-  for(int i=0;i<num_blocks;i++)
-    blocks[i].clear();  //clear blocks
-  
-  //RBDihedrals
-  if (myRBDihedral){
-    
-    HessDihedral hd;        //create dihedral hessian
-    //loop over all
-    for (unsigned int i = 0; i < myTopo->rb_dihedrals.size(); i++) {
-      RBTorsion rbt = myTopo->rb_dihedrals[i];
-      bool nonZForce = false;       //test for force constants
-      
-      if (rbt.C0 || rbt.C1 || rbt.C2 || rbt.C3 || rbt.C4 || rbt.C5) nonZForce = true;
-      
-      if (nonZForce) {
-        int aout[4];
-        aout[0] = rbt.atom1; aout[1] = rbt.atom2;
-        aout[2] = rbt.atom3; aout[3] = rbt.atom4;
-        
-        //test all in same block
-        int ar0 = atom_block[aout[0]];
-        if(atom_block[aout[1]] == ar0 && atom_block[aout[2]] == ar0 && atom_block[aout[3]] == ar0){
-          //pseudo minimum?
-          if(simuMin){
-            const Real phi = dihedralAngle(aout, *myPositions);
-            //
-            RBTorsion currRBTorsion = myTopo->rb_dihedrals[i];
-            
-            currRBTorsion.Offset = phi;
-            
-
-            //
-            hd.evaluate(currRBTorsion, (*myPositions)[aout[0]],
-                        (*myPositions)[aout[1]], (*myPositions)[aout[2]],
-                        (*myPositions)[aout[3]]);
-            
-          //else normal
-          }else{
-            //
-            hd.evaluate(rbt, (*myPositions)[aout[0]],
-                        (*myPositions)[aout[1]], (*myPositions)[aout[2]],
-                        (*myPositions)[aout[3]]);
-          }
-          
-          //output sparse matrix
-          for (int ii = 0; ii < 4; ii++){
-            for (int kk = 0; kk < 4; kk++) {
-              Matrix3By3 rhd = hd(ii, kk);
-              outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]],
-                             sqrtMass[aout[kk]], rhd, blocks[ar0].Rows, blocks[ar0].arrayPointer());
-            
-            }
-          }
-                      
-        }
-        
-      }
-      
-    }
-    
-  }
-  
-  //Impropers
-  if (myImproper) {
-    HessDihedral hi;        //create improper hessian    
-    unsigned int impropers_size = myTopo->impropers.size();
-    for (unsigned int i = 0; i < impropers_size; i++) {
-      bool nonZForce = false;       //test for force constants
-      for (int j = 0; j < myTopo->impropers[i].multiplicity; j++)
-        if (myTopo->impropers[i].forceConstant[j]) nonZForce = true;
-
-      if (nonZForce) {
-        int aout[4] = {myTopo->impropers[i].atom1, myTopo->impropers[i].atom2,
-                          myTopo->impropers[i].atom3, myTopo->impropers[i].atom4};
-        //test all in same block
-        int ar0 = atom_block[aout[0]];
-        if(atom_block[aout[1]] == ar0 && atom_block[aout[2]] == ar0 && atom_block[aout[3]] == ar0){
-          if(simuMin){
-              //    
-              Real phi = dihedralAngle(aout, *myPositions);
-              //
-              Torsion currTorsion = myTopo->impropers[i];
-              for (int j = 0; j < currTorsion.multiplicity; j++){
-                  currTorsion.phaseShift[j] = phi;
-              }
-              hi.evaluate(currTorsion, (*myPositions)[aout[0]],
-                          (*myPositions)[aout[1]], (*myPositions)[aout[2]],
-                          (*myPositions)[aout[3]]);
-
-          }else{
-              //
-              hi.evaluate(myTopo->impropers[i], (*myPositions)[aout[0]],
-                          (*myPositions)[aout[1]], (*myPositions)[aout[2]],
-                          (*myPositions)[aout[3]]);
-          }
-          //output sparse matrix
-          for (int ii = 0; ii < 4; ii++){
-            for (int kk = 0; kk < 4; kk++) {
-              Matrix3By3 rhd = hi(ii, kk);
-              outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]],
-                  sqrtMass[aout[kk]], rhd, blocks[ar0].Rows, blocks[ar0].arrayPointer());
 
-            }
-          }
-        }
-
-      }
-    }
-  }
-  
-  //Dihedrals
-  if (myDihedral) {
-    HessDihedral hd;        //create dihedral hessian    
-    unsigned int dihedrals_size = myTopo->dihedrals.size();
-    for (unsigned int i = 0; i < dihedrals_size; i++) {
-      bool nonZForce = false;       //test for force constants
-      for (int j = 0; j < myTopo->dihedrals[i].multiplicity; j++)
-        if (myTopo->dihedrals[i].forceConstant[j]) nonZForce = true;
-
-      if (nonZForce) {
-        int aout[4];
-        aout[0] = myTopo->dihedrals[i].atom1; aout[1] =
-          myTopo->dihedrals[i].atom2;
-        aout[2] = myTopo->dihedrals[i].atom3; aout[3] =
-          myTopo->dihedrals[i].atom4;
-        //test all in same block
-        int ar0 = atom_block[aout[0]];
-        if(atom_block[aout[1]] == ar0 && atom_block[aout[2]] == ar0 && atom_block[aout[3]] == ar0){
-          if(simuMin){
-            Real phi = dihedralAngle(aout, *myPositions);
-            //
-            Torsion currTorsion = myTopo->dihedrals[i];
-            
-            for (int j = 0; j < currTorsion.multiplicity; j++){
-                currTorsion.phaseShift[j] = M_PI - currTorsion.periodicity[j] * phi;
-            }
-            hd.evaluate(currTorsion, (*myPositions)[aout[0]],
-                        (*myPositions)[aout[1]], (*myPositions)[aout[2]],
-                        (*myPositions)[aout[3]]);
-          }else{
-            //
-            hd.evaluate(myTopo->dihedrals[i], (*myPositions)[aout[0]],
-                        (*myPositions)[aout[1]], (*myPositions)[aout[2]],
-                        (*myPositions)[aout[3]]);
-          }
-          //output sparse matrix
-          for (int ii = 0; ii < 4; ii++){
-            for (int kk = 0; kk < 4; kk++) {
-              Matrix3By3 rhd = hd(ii, kk);
-              outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]],
-                  sqrtMass[aout[kk]], rhd, blocks[ar0].Rows, blocks[ar0].arrayPointer());
-            }
-          }
-        }
-
-      }
-    }
-  }
-
-  //Bonds
-  if (myBond){    
-    unsigned int bonds_size = myTopo->bonds.size();
-    for (i = 0; i < bonds_size; i++) {
-      a1 = myTopo->bonds[i].atom1; a2 = myTopo->bonds[i].atom2;
-      //test all in same block
-      int ar1 = atom_block[a1];
-      if(atom_block[a1] == atom_block[a2]){
-        Real r_0 = myTopo->bonds[i].restLength;
-        //
-        if(simuMin) r_0 = ((*myPositions)[a2] - (*myPositions)[a1]).norm();
-        //
-        Real k = myTopo->bonds[i].springConstant;
-
-        Matrix3By3 bondHess12 =
-          reducedHessBond((*myPositions)[a1], (*myPositions)[a2], k, r_0);
-        //
-        //output
-        int aout[2]={a1,a2};
-        for (int ii = 0; ii < 2; ii++){
-          for (int kk = 0; kk < 2; kk++) {
-            if(ii == kk) rha = bondHess12;
-            else rha = -bondHess12;
-            outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]], 
-                          sqrtMass[aout[kk]], rha, blocks[ar1].Rows, blocks[ar1].arrayPointer());
-          }
-        }
-      }
-
-    }
-  }
-
-  //Angles
-  if (myAngle){    
-    unsigned int angles_size = myTopo->angles.size();
-    for (i = 0; i < angles_size; i++) {
-      a1 = myTopo->angles[i].atom1;
-      a2 = myTopo->angles[i].atom2;
-      a3 = myTopo->angles[i].atom3;
-      //test all in same block
-      int ar1 = atom_block[a1];
-      int aout[3];
-      aout[0] = a1; aout[1] = a2; aout[2] = a3;
-      //
-      if(atom_block[a2] == ar1 && atom_block[a3] == ar1){
-        Real theta0 = myTopo->angles[i].restAngle;
-        Real k_t = myTopo->angles[i].forceConstant;
-        Real ubConst = myTopo->angles[i].ureyBradleyConstant;
-        Real ubRestL = myTopo->angles[i].ureyBradleyRestLength;
-        //
-        if(simuMin){
-            Vector3D rij((*myPositions)[a2] - (*myPositions)[a1]);
-            Vector3D rkj((*myPositions)[a2] - (*myPositions)[a3]);
-            theta0 = atan2((rij.cross(rkj)).norm(), rij.dot(rkj));
-            ubRestL = ((*myPositions)[a3] - (*myPositions)[a1]).norm();
-        }
-        //
-        // ReducedHessAngle for atoms a1, a2 and a3
-        rh.evaluate((*myPositions)[a1], (*myPositions)[a2], (*myPositions)[a3],
-                    k_t,
-                    theta0);
-        //ureyBradley
-        if (ubConst) {
-          //Cheat using bond hessian as same as UB!!!!
-          Matrix3By3 ubm =
-            reducedHessBond((*myPositions)[a1], (*myPositions)[a3], ubConst,
-                            ubRestL);
-          rh.accumulateTo(0, 0, ubm);
-          rh.accumulateTo(2, 2, ubm);
-          rh.accumulateNegTo(2, 0, ubm);
-          rh.accumulateNegTo(0, 2, ubm);
-        }
-        //output sparse matrix
-        for (int ii = 0; ii < 3; ii++){
-          for (int kk = 0; kk < 3; kk++) {
-            rha = rh(ii, kk);
-            outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]],
-                sqrtMass[aout[kk]], rha, blocks[ar1].Rows, blocks[ar1].arrayPointer());
-          }
-        }
-      }
-
-    }
-  }
+  //blocks are independent, each thread evaluates whole blocks
+  const int threads = ThreadForceBuffers::getNumThreads();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
+  for(int i=0;i<num_blocks;i++)
+    evaluateResidueBlock(i, myPositions, myTopo, simuMin);
   
 #ifdef BLOCKPAIRWISEINTERACTION
   
@@ -592,6 +389,222 @@ void BlockHessian::evaluateResidues(const Vector3DBlock *myPositions,
   
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Evaluate course high frequency Hessian of block ar0, from the bonded terms
+// with all atoms inside the block
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void BlockHessian::evaluateResidueBlock(const int ar0,
+                                          const Vector3DBlock *myPositions,
+                                            const GenericTopology *myTopo,
+                                              bool simuMin) {
+  int a1, a2, a3;
+  ReducedHessAngle rh;
+  Matrix3By3 rha;
+  const BlockTerms &terms = block_terms[ar0];
+  
+  blocks[ar0].clear();  //clear block
+  
+  //RBDihedrals
+  if (myRBDihedral){
+    
+    HessDihedral hd;        //create dihedral hessian
+    //loop over all in block
+    for (unsigned int t = 0; t < terms.rbDihedrals.size(); t++) {
+      const int i = terms.rbDihedrals[t];
+      RBTorsion rbt = myTopo->rb_dihedrals[i];
+      int aout[4];
+      aout[0] = rbt.atom1; aout[1] = rbt.atom2;
+      aout[2] = rbt.atom3; aout[3] = rbt.atom4;
+      
+      //pseudo minimum?
+      if(simuMin){
+        const Real phi = dihedralAngle(aout, *myPositions);
+        //
+        RBTorsion currRBTorsion = myTopo->rb_dihedrals[i];
+        
+        currRBTorsion.Offset = phi;
+        
+        //
+        hd.evaluate(currRBTorsion, (*myPositions)[aout[0]],
+                    (*myPositions)[aout[1]], (*myPositions)[aout[2]],
+                    (*myPositions)[aout[3]]);
+        
+      //else normal
+      }else{
+        //
+        hd.evaluate(rbt, (*myPositions)[aout[0]],
+                    (*myPositions)[aout[1]], (*myPositions)[aout[2]],
+                    (*myPositions)[aout[3]]);
+      }
+      
+      //output sparse matrix
+      for (int ii = 0; ii < 4; ii++){
+        for (int kk = 0; kk < 4; kk++) {
+          Matrix3By3 rhd = hd(ii, kk);
+          outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]],
+                         sqrtMass[aout[kk]], rhd, blocks[ar0].Rows, blocks[ar0].arrayPointer());
+        
+        }
+      }
+      
+    }
+    
+  }
+  
+  //Impropers
+  if (myImproper) {
+    HessDihedral hi;        //create improper hessian    
+    for (unsigned int t = 0; t < terms.impropers.size(); t++) {
+      const int i = terms.impropers[t];
+      int aout[4] = {myTopo->impropers[i].atom1, myTopo->impropers[i].atom2,
+                        myTopo->impropers[i].atom3, myTopo->impropers[i].atom4};
+      if(simuMin){
+          //    
+          Real phi = dihedralAngle(aout, *myPositions);
+          //
+          Torsion currTorsion = myTopo->impropers[i];
+          for (int j = 0; j < currTorsion.multiplicity; j++){
+              currTorsion.phaseShift[j] = phi;
+          }
+          hi.evaluate(currTorsion, (*myPositions)[aout[0]],
+                      (*myPositions)[aout[1]], (*myPositions)[aout[2]],
+                      (*myPositions)[aout[3]]);
+
+      }else{
+          //
+          hi.evaluate(myTopo->impropers[i], (*myPositions)[aout[0]],
+                      (*myPositions)[aout[1]], (*myPositions)[aout[2]],
+                      (*myPositions)[aout[3]]);
+      }
+      //output sparse matrix
+      for (int ii = 0; ii < 4; ii++){
+        for (int kk = 0; kk < 4; kk++) {
+          Matrix3By3 rhd = hi(ii, kk);
+          outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]],
+              sqrtMass[aout[kk]], rhd, blocks[ar0].Rows, blocks[ar0].arrayPointer());
+
+        }
+      }
+    }
+  }
+  
+  //Dihedrals
+  if (myDihedral) {
+    HessDihedral hd;        //create dihedral hessian    
+    for (unsigned int t = 0; t < terms.dihedrals.size(); t++) {
+      const int i = terms.dihedrals[t];
+      int aout[4];
+      aout[0] = myTopo->dihedrals[i].atom1; aout[1] =
+        myTopo->dihedrals[i].atom2;
+      aout[2] = myTopo->dihedrals[i].atom3; aout[3] =
+        myTopo->dihedrals[i].atom4;
+      if(simuMin){
+        Real phi = dihedralAngle(aout, *myPositions);
+        //
+        Torsion currTorsion = myTopo->dihedrals[i];
+        
+        for (int j = 0; j < currTorsion.multiplicity; j++){
+            currTorsion.phaseShift[j] = M_PI - currTorsion.periodicity[j] * phi;
+        }
+        hd.evaluate(currTorsion, (*myPositions)[aout[0]],
+                    (*myPositions)[aout[1]], (*myPositions)[aout[2]],
+                    (*myPositions)[aout[3]]);
+      }else{
+        //
+        hd.evaluate(myTopo->dihedrals[i], (*myPositions)[aout[0]],
+                    (*myPositions)[aout[1]], (*myPositions)[aout[2]],
+                    (*myPositions)[aout[3]]);
+      }
+      //output sparse matrix
+      for (int ii = 0; ii < 4; ii++){
+        for (int kk = 0; kk < 4; kk++) {
+          Matrix3By3 rhd = hd(ii, kk);
+          outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]],
+              sqrtMass[aout[kk]], rhd, blocks[ar0].Rows, blocks[ar0].arrayPointer());
+        }
+      }
+    }
+  }
+
+  //Bonds
+  if (myBond){    
+    for (unsigned int t = 0; t < terms.bonds.size(); t++) {
+      const int i = terms.bonds[t];
+      a1 = myTopo->bonds[i].atom1; a2 = myTopo->bonds[i].atom2;
+      Real r_0 = myTopo->bonds[i].restLength;
+      //
+      if(simuMin) r_0 = ((*myPositions)[a2] - (*myPositions)[a1]).norm();
+      //
+      Real k = myTopo->bonds[i].springConstant;
+
+      Matrix3By3 bondHess12 =
+        reducedHessBond((*myPositions)[a1], (*myPositions)[a2], k, r_0);
+      //
+      //output
+      int aout[2]={a1,a2};
+      for (int ii = 0; ii < 2; ii++){
+        for (int kk = 0; kk < 2; kk++) {
+          if(ii == kk) rha = bondHess12;
+          else rha = -bondHess12;
+          outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]], 
+                        sqrtMass[aout[kk]], rha, blocks[ar0].Rows, blocks[ar0].arrayPointer());
+        }
+      }
+
+    }
+  }
+
+  //Angles
+  if (myAngle){    
+    for (unsigned int t = 0; t < terms.angles.size(); t++) {
+      const int i = terms.angles[t];
+      a1 = myTopo->angles[i].atom1;
+      a2 = myTopo->angles[i].atom2;
+      a3 = myTopo->angles[i].atom3;
+      int aout[3];
+      aout[0] = a1; aout[1] = a2; aout[2] = a3;
+      //
+      Real theta0 = myTopo->angles[i].restAngle;
+      Real k_t = myTopo->angles[i].forceConstant;
+      Real ubConst = myTopo->angles[i].ureyBradleyConstant;
+      Real ubRestL = myTopo->angles[i].ureyBradleyRestLength;
+      //
+      if(simuMin){
+          Vector3D rij((*myPositions)[a2] - (*myPositions)[a1]);
+          Vector3D rkj((*myPositions)[a2] - (*myPositions)[a3]);
+          theta0 = atan2((rij.cross(rkj)).norm(), rij.dot(rkj));
+          ubRestL = ((*myPositions)[a3] - (*myPositions)[a1]).norm();
+      }
+      //
+      // ReducedHessAngle for atoms a1, a2 and a3
+      rh.evaluate((*myPositions)[a1], (*myPositions)[a2], (*myPositions)[a3],
+                  k_t,
+                  theta0);
+      //ureyBradley
+      if (ubConst) {
+        //Cheat using bond hessian as same as UB!!!!
+        Matrix3By3 ubm =
+          reducedHessBond((*myPositions)[a1], (*myPositions)[a3], ubConst,
+                          ubRestL);
+        rh.accumulateTo(0, 0, ubm);
+        rh.accumulateTo(2, 2, ubm);
+        rh.accumulateNegTo(2, 0, ubm);
+        rh.accumulateNegTo(0, 2, ubm);
+      }
+      //output sparse matrix
+      for (int ii = 0; ii < 3; ii++){
+        for (int kk = 0; kk < 3; kk++) {
+          rha = rh(ii, kk);
+          outputMatrix(atom_block_num[aout[ii]], atom_block_num[aout[kk]], sqrtMass[aout[ii]],
+              sqrtMass[aout[kk]], rha, blocks[ar0].Rows, blocks[ar0].arrayPointer());
+        }
+      }
+
+    }
+  }
+  
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Calculate Dihedral/Improper angles
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
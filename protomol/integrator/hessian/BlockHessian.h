@@ -50,6 +50,8 @@ namespace ProtoMol {
     void outputMatrix(int i, int j, Real sqrtMassi, Real sqrtMassj, 
                         Matrix3By3 rha, int arrSz, double *basePoint);
   private:
+    void evaluateResidueBlock(const int ar0, const Vector3DBlock *myPositions,
+                                const GenericTopology *myTopo, bool simuMin);
     Real dihedralAngle(const int *aout, const Vector3DBlock &myPositions) const;
     void outputTorsions(const std::vector<Torsion> &torsions, const Vector3DBlock &myPositions);  
 
@@ -74,6 +76,11 @@ namespace ProtoMol {
     //Blocks
     int num_blocks, rpb, *blocks_max, *atom_block, *atom_block_num;
     //
+    //Bonded terms inside each block, topology indices in order
+    struct BlockTerms {
+      vector<int> rbDihedrals, impropers, dihedrals, bonds, angles;
+    };
+    vector<BlockTerms> block_terms;
     //Block Hessian
     vector<BlockMatrix> blocks;
     vector<BlockMatrix> adj_blocks;
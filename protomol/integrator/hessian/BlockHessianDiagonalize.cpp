@@ -6,6 +6,7 @@
 #include <protomol/type/BlockMatrix.h>
 
 #include <protomol/base/Lapack.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
 
 #include <iostream>
 #include <stdio.h>
@@ -182,6 +183,10 @@ namespace ProtoMol {
     //
     //**** Multiply block eigenvectors with inner eigenvectors ****************
     innerEigVec.columnResize(sz_col);
+    const int threads = ThreadForceBuffers::getNumThreads();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
     for(int ii=0;ii<bHess->num_blocks;ii++)
       blockEigVect[ii].productToArray(innerEigVec, mhQu, 0, 0, sz_row, sz_col); //Aaa^{T}This
     //**** Return max eigenvalue for minimizer line search ********************
@@ -302,51 +307,76 @@ namespace ProtoMol {
       i_res_sum += blocks_num_eigs[i];
     }
 
-    //Do blocks if Hessian distance is 0
-    for(int ii=0;ii<bHess->num_blocks;ii++){  
-      BlockMatrix tempM((blockEigVect[ii]).ColumnStart, (bHess->blocks[ii]).ColumnStart, (blockEigVect[ii]).Columns, (bHess->blocks[ii]).Columns);
-      (blockEigVect[ii]).transposeProduct(bHess->blocks[ii], tempM); //Aaa^{T}This
-      tempM.product(blockEigVect[ii], innerDiag); //Aaa^{T}HAaa
-    }
+    //Off diagonal blocks by the row block they start in. A row block ii only
+    //writes rows ii and, mirrored, columns ii of S, so each row block is done
+    //by one thread in the serial order.
+    const int num_blks = bHess->num_blocks;
+    vector<vector<int> > non_adj_rows(num_blks), adj_nonbond_rows(num_blks);
+    int non_adj_bond_blocks_size = bHess->non_adj_bond_blocks.size();
+    for(int ii=0;ii<non_adj_bond_blocks_size;ii++)
+      non_adj_rows[bHess->non_adj_bond_index[ii*2]].push_back(ii);
+    int adj_nonbond_blocks_size = bHess->adj_nonbond_blocks.size();
+    for(int ii=0;ii<adj_nonbond_blocks_size;ii++)
+      adj_nonbond_rows[bHess->adj_nonbond_index[ii*2]].push_back(ii);
 
-    //Do blocks if Hessian distance is 1
-    for(int ii=0;ii<bHess->num_blocks-1;ii++){  
-      BlockMatrix tempM((blockEigVect[ii]).ColumnStart, (bHess->adj_blocks[ii]).ColumnStart, (blockEigVect[ii]).Columns, (bHess->adj_blocks[ii]).Columns);
-      (blockEigVect[ii]).transposeProduct(bHess->adj_blocks[ii], tempM); //Aaa^{T}This
-      tempM.product(blockEigVect[ii+1], innerDiag); //Aaa^{T}HAbb
-      if(SYMHESS){
-        //Dont need this except for symmetric Hessians
-        for(unsigned jj=tempM.RowStart;jj<tempM.Rows+tempM.RowStart;jj++)
-          for(unsigned kk=(blockEigVect[ii+1]).ColumnStart;kk<(blockEigVect[ii+1]).Columns+(blockEigVect[ii+1]).ColumnStart;kk++)
-             innerDiag(kk,jj) = innerDiag(jj,kk);
+    const int threads = ThreadForceBuffers::getNumThreads();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
+    for(int ii=0;ii<num_blks;ii++){  
+      //Do blocks if Hessian distance is 0
+      {
+        BlockMatrix tempM((blockEigVect[ii]).ColumnStart, (bHess->blocks[ii]).ColumnStart, (blockEigVect[ii]).Columns, (bHess->blocks[ii]).Columns);
+        (blockEigVect[ii]).transposeProduct(bHess->blocks[ii], tempM); //Aaa^{T}This
+        tempM.product(blockEigVect[ii], innerDiag); //Aaa^{T}HAaa
       }
-    }
-    //Do non-adjacent bond blocks, distance > 1
-    int non_adj_bond_blocks_size = bHess->non_adj_bond_blocks.size();
-    for(int ii=0;ii<non_adj_bond_blocks_size;ii++){  
-      int ar0 = bHess->non_adj_bond_index[ii*2]; int ar1 = bHess->non_adj_bond_index[ii*2+1];
-      BlockMatrix tempM((blockEigVect[ar0]).ColumnStart, (bHess->non_adj_bond_blocks[ii]).ColumnStart, (blockEigVect[ar0]).Columns, (bHess->non_adj_bond_blocks[ii]).Columns);
-      (blockEigVect[ar0]).transposeProduct(bHess->non_adj_bond_blocks[ii], tempM); //Aaa^{T}This
-      tempM.product(blockEigVect[ar1], innerDiag); //Aaa^{T}HAbb
-      if(SYMHESS){
-        //Dont need this except for symmetric Hessians
-        for(unsigned jj=tempM.RowStart;jj<tempM.Rows+tempM.RowStart;jj++)
-          for(unsigned kk=(blockEigVect[ar1]).ColumnStart;kk<(blockEigVect[ar1]).Columns+(blockEigVect[ar1]).ColumnStart;kk++)
-            innerDiag(kk,jj) = innerDiag(jj,kk);
+
+      //Do blocks if Hessian distance is 1
+      if(ii < num_blks-1){  
+        BlockMatrix tempM((blockEigVect[ii]).ColumnStart, (bHess->adj_blocks[ii]).ColumnStart, (blockEigVect[ii]).Columns, (bHess->adj_blocks[ii]).Columns);
+        (blockEigVect[ii]).transposeProduct(bHess->adj_blocks[ii], tempM); //Aaa^{T}This
+        tempM.product(blockEigVect[ii+1], innerDiag); //Aaa^{T}HAbb
+        if(SYMHESS){
+          //Dont need this except for symmetric Hessians
+          for(unsigned jj=tempM.RowStart;jj<tempM.Rows+tempM.RowStart;jj++)
+            for(unsigned kk=(blockEigVect[ii+1]).ColumnStart;kk<(blockEigVect[ii+1]).Columns+(blockEigVect[ii+1]).ColumnStart;kk++)
+               innerDiag(kk,jj) = innerDiag(jj,kk);
+        }
+      }
+
+      //Do non-adjacent bond blocks, distance > 1
+      for(unsigned int nn=0;nn<non_adj_rows[ii].size();nn++){  
+        const int kk0 = non_adj_rows[ii][nn];
+        int ar0 = bHess->non_adj_bond_index[kk0*2]; int ar1 = bHess->non_adj_bond_index[kk0*2+1];
+        BlockMatrix tempM((blockEigVect[ar0]).ColumnStart, (bHess->non_adj_bond_blocks[kk0]).ColumnStart, (blockEigVect[ar0]).Columns, (bHess->non_adj_bond_blocks[kk0]).Columns);
+        (blockEigVect[ar0]).transposeProduct(bHess->non_adj_bond_blocks[kk0], tempM); //Aaa^{T}This
+        tempM.product(blockEigVect[ar1], innerDiag); //Aaa^{T}HAbb
+        if(SYMHESS){
+          //Dont need this except for symmetric Hessians
+          for(unsigned jj=tempM.RowStart;jj<tempM.Rows+tempM.RowStart;jj++)
+            for(unsigned kk=(blockEigVect[ar1]).ColumnStart;kk<(blockEigVect[ar1]).Columns+(blockEigVect[ar1]).ColumnStart;kk++)
+              innerDiag(kk,jj) = innerDiag(jj,kk);
+        }
       }
     }
-    //Do adjacent non-bond blocks
-    int adj_nonbond_blocks_size = bHess->adj_nonbond_blocks.size();
-    for(int ii=0;ii<adj_nonbond_blocks_size;ii++){  
-      int ar0 = bHess->adj_nonbond_index[ii*2]; int ar1 = bHess->adj_nonbond_index[ii*2+1];
-      BlockMatrix tempM((blockEigVect[ar0]).ColumnStart, (bHess->adj_nonbond_blocks[ii]).ColumnStart, (blockEigVect[ar0]).Columns, (bHess->adj_nonbond_blocks[ii]).Columns);
-      (blockEigVect[ar0]).transposeProduct(bHess->adj_nonbond_blocks[ii], tempM); //Aaa^{T}This
-      tempM.sumProduct(blockEigVect[ar1], innerDiag); //Aaa^{T}HAbb
-      if(SYMHESS){
-        //Dont need this except for symmetric Hessians
-        for(unsigned jj=tempM.RowStart;jj<tempM.Rows+tempM.RowStart;jj++)
-          for(unsigned kk=(blockEigVect[ar1]).ColumnStart;kk<(blockEigVect[ar1]).Columns+(blockEigVect[ar1]).ColumnStart;kk++)
-            innerDiag(kk,jj) = innerDiag(jj,kk);
+
+    //Do adjacent non-bond blocks, after all bond blocks as they are summed
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
+    for(int ii=0;ii<num_blks;ii++){  
+      for(unsigned int nn=0;nn<adj_nonbond_rows[ii].size();nn++){  
+        const int kk0 = adj_nonbond_rows[ii][nn];
+        int ar0 = bHess->adj_nonbond_index[kk0*2]; int ar1 = bHess->adj_nonbond_index[kk0*2+1];
+        BlockMatrix tempM((blockEigVect[ar0]).ColumnStart, (bHess->adj_nonbond_blocks[kk0]).ColumnStart, (blockEigVect[ar0]).Columns, (bHess->adj_nonbond_blocks[kk0]).Columns);
+        (blockEigVect[ar0]).transposeProduct(bHess->adj_nonbond_blocks[kk0], tempM); //Aaa^{T}This
+        tempM.sumProduct(blockEigVect[ar1], innerDiag); //Aaa^{T}HAbb
+        if(SYMHESS){
+          //Dont need this except for symmetric Hessians
+          for(unsigned jj=tempM.RowStart;jj<tempM.Rows+tempM.RowStart;jj++)
+            for(unsigned kk=(blockEigVect[ar1]).ColumnStart;kk<(blockEigVect[ar1]).Columns+(blockEigVect[ar1]).ColumnStart;kk++)
+              innerDiag(kk,jj) = innerDiag(jj,kk);
+        }
       }
     }
     //
@@ -357,7 +387,11 @@ namespace ProtoMol {
   //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   void BlockHessianDiagonalize::fullElectrostaticBlocks(){
   
-    //Full electrostatics
+    //Full electrostatics, row blocks ii of S are independent
+    const int threads = ThreadForceBuffers::getNumThreads();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
     for(int ii=0;ii<bHess->num_blocks;ii++){
       BlockMatrix tempM((blockEigVect[ii]).ColumnStart, (bHess->electroStatics).ColumnStart, (blockEigVect[ii]).Columns, bHess->electroStatics.Columns);
       (blockEigVect[ii]).transposeProduct(bHess->electroStatics, tempM); //Aaa^{T}This
@@ -395,24 +429,29 @@ namespace ProtoMol {
     Real max_eigenvalue = 0;
     int bHess_num_blks = bHess->num_blocks;
 
-    //find atom block start
-    unsigned int block_start = 0;
+    //diagonalize the blocks, each thread with its own LAPACK work arrays
+    const int threads = ThreadForceBuffers::getNumThreads();
+    if((int)workspaces.size() < threads) workspaces.resize(threads);
+    vector<int> blockInfo(bHess_num_blks, 0);
 
-    //for each block
+    rediagTime.start();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
     for(int ii=0;ii<bHess_num_blks;ii++){
+      DiagWorkspace &ws = workspaces[ThreadForceBuffers::getThreadId()];
       int numFound;
 
       //diagonalize block
-      rediagTime.start();
-      int infor = diagHessian(blockEigVect[ii].arrayPointer(), &rE[bHess->hess_eig_point[ii] * 3], 
-                                bHess->blocks[ii].arrayPointer(), bHess->blocks[ii].Rows, numFound);
-      rediagTime.stop();
-
-      if(infor) report << error << "[BlockHessianDiagonalize::findCoarseBlockEigs] Residue "<<ii+1<<" diagonalization failed."<<endr;
+      blockInfo[ii] = diagHessian(blockEigVect[ii].arrayPointer(), &rE[bHess->hess_eig_point[ii] * 3], 
+                                    bHess->blocks[ii].arrayPointer(), bHess->blocks[ii].Rows, numFound, ws);
+      if(blockInfo[ii]) continue;
 
       //sort by magnitude of eigenvalue
-      for(int i=0;i<bHess->blocks_max[ii] * 3;i++) eigIndx[i] = i;
-      absSort(blockEigVect[ii].arrayPointer(), &rE[bHess->hess_eig_point[ii] * 3], eigIndx, bHess->blocks_max[ii] * 3);
+      const int blockiisize = bHess->blocks_max[ii] * 3;
+      if((int)ws.index.size() < blockiisize) ws.index.resize(blockiisize);
+      for(int i=0;i<blockiisize;i++) ws.index[i] = i;
+      absSort(blockEigVect[ii].arrayPointer(), &rE[bHess->hess_eig_point[ii] * 3], &ws.index[0], blockiisize);
 
       //~~~~Use geometrically generated conserved dof to generate a new basis set?
       if( geom ){
@@ -429,8 +468,9 @@ namespace ProtoMol {
           //clear it
           tmpEigs.clear();
 
-          //find positions
+          //find positions, atoms are in sequence
           const unsigned int block_max = bHess->blocks_max[ii];
+          const unsigned int block_start = bHess->hess_eig_point[ii];
 
           //find center and norm (1/sqrt mass)
           Vector3D pos_center(0.0,0.0,0.0);
@@ -568,6 +608,9 @@ namespace ProtoMol {
 
               //remove if 1/20 th of original
               if( nnorm < 0.05 && cdof > 0 ){//TODO## AND not last?
+#ifdef _OPENMP
+#pragma omp critical
+#endif
                   report << debug(12) << "Residual vector " << jj << " norm is low = " << nnorm << " in block " 
                                 << ii << ", skipping." << endr;
                   cdof--;
@@ -586,11 +629,15 @@ namespace ProtoMol {
           //copy across
           blockEigVect[ii] = tmpEigs;
 
-          //update start atom for next block
-          block_start += block_max;
-
       }
       //~~~~End geometric~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    }
+    rediagTime.stop();
+
+    //for each block
+    for(int ii=0;ii<bHess_num_blks;ii++){
+
+      if(blockInfo[ii]) report << error << "[BlockHessianDiagonalize::findCoarseBlockEigs] Residue "<<ii+1<<" diagonalization failed."<<endr;
 
       //find number of eigs required, by the eigenvalue threshold, if block vector number not set
       //fix for no block vectors and eig_thresh greater than max_eig
@@ -693,21 +740,26 @@ namespace ProtoMol {
   // Diagonalize Hessian
   //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   int BlockHessianDiagonalize::diagHessian(double *eigVecO, double *eigValO, double *hsnhessM, int dim, int &numFound){
-   double *wrkSp = 0;
-   int *isuppz, *iwork;
-
+    if(workspaces.empty()) workspaces.resize(1);
+    return diagHessian(eigVecO, eigValO, hsnhessM, dim, numFound, workspaces[0]);
+  }
 
-   isuppz = new int[2*dim];
-   iwork = new int[10*dim];
+  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  // Diagonalize Hessian with the work arrays ws, which only grow
+  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  int BlockHessianDiagonalize::diagHessian(double *eigVecO, double *eigValO, double *hsnhessM, int dim, int &numFound,
+                                           DiagWorkspace &ws){
+   if((int)ws.isuppz.size() < 2*dim) ws.isuppz.resize(2*dim);
+   if((int)ws.iwork.size() < 10*dim) ws.iwork.resize(10*dim);
    //Diagonalize
 //QR?
 #if defined( HAVE_QRDIAG )    
    //copy Hessian to eig I/O space, could just copy the upper triangular part with diagonal
    const int dimsq = dim*dim;
    for(int i=0;i<dimsq;i++) eigVecO[i] = hsnhessM[i];
-   wrkSp = new double[1];
+   if(ws.work.empty()) ws.work.resize(1);
 #else
-   wrkSp = new double[26*dim];
+   if((int)ws.work.size() < 26*dim) ws.work.resize(26*dim);
 #endif
 //
     char jobz = 'V'; char range = 'A'; char uplo = 'U'; /* LAPACK checks only first character N/V */
@@ -729,29 +781,319 @@ namespace ProtoMol {
 //QR?
 #if defined( HAVE_QRDIAG )    
     lwork = -1;
-    Lapack::dsyev(&jobz, &uplo, &n, eigVecO, &lda, eigValO, wrkSp, &lwork, &info);
+    Lapack::dsyev(&jobz, &uplo, &n, eigVecO, &lda, eigValO, &ws.work[0], &lwork, &info);
     if(info == 0){
-      lwork = wrkSp[0];
-      delete [] wrkSp;
-      wrkSp = new double[lwork];
-      Lapack::dsyev(&jobz, &uplo, &n, eigVecO, &lda, eigValO, wrkSp, &lwork, &info);
+      lwork = ws.work[0];
+      if((int)ws.work.size() < lwork) ws.work.resize(lwork);
+      Lapack::dsyev(&jobz, &uplo, &n, eigVecO, &lda, eigValO, &ws.work[0], &lwork, &info);
     }
 #else
     abstol = Lapack::dlamch( &cmach);	//find machine safe minimum  
     //abstol = 1e-15;	//use small value for tolerence  
     //
-    Lapack::dsyevr( &jobz, &range, &uplo, &n, hsnhessM, &lda, &vl, &vu, &il, &iu, &abstol, &m, eigValO, eigVecO, &ldz, isuppz, 
-                wrkSp, &lwork, iwork, &liwork, &info);
+    Lapack::dsyevr( &jobz, &range, &uplo, &n, hsnhessM, &lda, &vl, &vu, &il, &iu, &abstol, &m, eigValO, eigVecO, &ldz, &ws.isuppz[0], 
+                &ws.work[0], &lwork, &ws.iwork[0], &liwork, &info);
 #endif
 	numFound = m;
-    //delete arrays
-    delete [] iwork;
-    delete [] isuppz;
-    delete [] wrkSp;
     //return status
     return info;
   }
 
+  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  // Helpers for the iterative diagonalization
+  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  //eigenvalues (ascending) and eigenvectors of the small symmetric n x n matrix a
+  static int smallDiag(double *a, double *w, int n){
+    char jobz = 'V'; char uplo = 'U';
+    int lda = n; int lwork = -1; int info = 0;
+    double wrkSize = 0.0;
+    Lapack::dsyev(&jobz, &uplo, &n, a, &lda, w, &wrkSize, &lwork, &info);
+    if(info) return info;
+    lwork = (int)wrkSize;
+    vector<double> wrkSp(lwork);
+    Lapack::dsyev(&jobz, &uplo, &n, a, &lda, w, &wrkSp[0], &lwork, &info);
+    return info;
+  }
+
+  //c (m x n) = a^T b, a (dim x m) and b (dim x n)
+  static void gramMatrix(double *a, double *b, double *c, int dim, int m, int n){
+    char transA = 'T'; char transB = 'N';
+    double alpha = 1.0; double beta = 0.0;
+    Lapack::dgemm(&transA, &transB, &m, &n, &dim, &alpha, a, &dim, b, &dim, &beta, c, &m);
+  }
+
+  //c (dim x n) = a b, a (dim x k) and b (k x n) with leading dimension ldb
+  static void combine(double *a, double *b, int ldb, double *c, int dim, int k, int n){
+    char trans = 'N';
+    double alpha = 1.0; double beta = 0.0;
+    Lapack::dgemm(&trans, &trans, &dim, &n, &k, &alpha, a, &dim, b, &ldb, &beta, c, &dim);
+  }
+
+  static double dot(const double *a, const double *b, int dim){
+    double sum = 0.0;
+    for(int i=0;i<dim;i++) sum += a[i] * b[i];
+    return sum;
+  }
+
+  //start vectors, own generator to keep the integrator random streams unchanged
+  static void startVectors(double *x, int dim, int num){
+    unsigned long seed = 1234;
+    for(int i=0;i<dim*num;i++){
+      seed = (seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+      x[i] = (double)seed / 2147483648.0 - 0.5;
+    }
+  }
+
+  //Orthonormalizes columns k..k+n-1 of v against columns 0..k-1 and each other
+  //by twice applied modified Gram-Schmidt. The same operations are applied to av
+  //if given, such that av = H v holds. Vanishing columns are dropped, returns the
+  //number of columns kept.
+  static int orthonormalize(double *v, double *av, int k, int n, int dim){
+    int kept = k;
+    for(int j=k;j<k+n;j++){
+      double *vj = v + j * dim;
+      double *avj = av != 0 ? av + j * dim : 0;
+      const double norm0 = sqrt(dot(vj, vj, dim));
+      for(int pass=0;pass<2;pass++)
+        for(int i=0;i<kept;i++){
+          const double *vi = v + i * dim;
+          const double r = dot(vi, vj, dim);
+          for(int l=0;l<dim;l++) vj[l] -= r * vi[l];
+          if(avj != 0){
+            const double *avi = av + i * dim;
+            for(int l=0;l<dim;l++) avj[l] -= r * avi[l];
+          }
+        }
+      const double norm = sqrt(dot(vj, vj, dim));
+      if(norm0 == 0.0 || norm <= 1e-10 * norm0) continue;
+      double *vk = v + kept * dim;
+      double *avk = av != 0 ? av + kept * dim : 0;
+      for(int l=0;l<dim;l++) vk[l] = vj[l] / norm;
+      if(avj != 0)
+        for(int l=0;l<dim;l++) avk[l] = avj[l] / norm;
+      kept++;
+    }
+    return kept - k;
+  }
+
+  //Block Jacobi preconditioner, inverses of the diagonal Hessian blocks of the atoms
+  //[blockStart[b], blockStart[b + 1]) with their eigenvalues bounded away from zero.
+  //The inverses are stored one after the other, column major.
+  static void blockPreconditioner(const Hessian &hsn, const vector<int> &blockStart,
+                                  vector<double> &prec, int dim){
+    const int numBlocks = blockStart.size() - 1;
+    int size = 0;
+    for(int b=0;b<numBlocks;b++){
+      const int n = 3 * (blockStart[b + 1] - blockStart[b]);
+      size += n * n;
+    }
+    prec.assign(size, 0.0);
+
+    //blocks and their eigenvalues
+    vector<double> w(dim);
+    double *h = &prec[0];
+    double mean = 0.0;
+    for(int b=0;b<numBlocks;b++){
+      const int first = blockStart[b];
+      const int n = 3 * (blockStart[b + 1] - first);
+      for(int c=0;c<n;c++)
+        for(int r=0;r<n;r++)
+          h[r + c * n] = hsn.isSparse() ? hsn.hessS(3 * first + r, 3 * first + c) :
+            hsn.hessM[(3 * first + r) + (3 * first + c) * dim];
+      for(int c=0;c<n;c++)
+        for(int r=0;r<c;r++)
+          h[r + c * n] = h[c + r * n] = 0.5 * (h[r + c * n] + h[c + r * n]);
+      smallDiag(h, &w[3 * first], n);
+      for(int e=0;e<n;e++) mean += fabs(w[3 * first + e]) / dim;
+      h += n * n;
+    }
+
+    //inverses, small eigenvalues (rigid block motions) are floored
+    const double floor = 1e-2 * mean;
+    vector<double> v;
+    h = &prec[0];
+    for(int b=0;b<numBlocks;b++){
+      const int first = blockStart[b];
+      const int n = 3 * (blockStart[b + 1] - first);
+      v.assign(h, h + n * n);
+      for(int e=0;e<n;e++){
+        const double d = 1.0 / max(fabs(w[3 * first + e]), floor);
+        for(int l=0;l<n;l++) v[l + e * n] *= sqrt(d);
+      }
+      //V D V^T
+      char transA = 'N'; char transB = 'T';
+      double alpha = 1.0; double beta = 0.0;
+      int nn = n;
+      Lapack::dgemm(&transA, &transB, &nn, &nn, &nn, &alpha, &v[0], &nn, &v[0], &nn, &beta, h, &nn);
+      h += n * n;
+    }
+  }
+
+  //w = T r
+  static void applyPreconditioner(const vector<int> &blockStart, const vector<double> &prec,
+                                  const double *r, double *w){
+    const int numBlocks = blockStart.size() - 1;
+    const double *h = &prec[0];
+    for(int b=0;b<numBlocks;b++){
+      const int first = 3 * blockStart[b];
+      const int n = 3 * blockStart[b + 1] - first;
+      for(int i=0;i<n;i++) w[first + i] = 0.0;
+      for(int c=0;c<n;c++){
+        const double rc = r[first + c];
+        for(int i=0;i<n;i++) w[first + i] += h[i + c * n] * rc;
+      }
+      h += n * n;
+    }
+  }
+
+  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  // Estimate largest eigenvalue by Lanczos
+  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  Real BlockHessianDiagonalize::maxEigenvalue(Hessian &hsn, int dim){
+    int steps = min(dim, 30);
+    vector<double> q((steps + 1) * dim), alpha(steps), beta(steps);
+    startVectors(&q[0], dim, 1);
+    orthonormalize(&q[0], 0, 0, 1, dim);
+    for(int j=0;j<steps;j++){
+      double *qj = &q[j * dim];
+      double *w = &q[(j + 1) * dim];
+      hsn.multiply(qj, w);
+      alpha[j] = dot(qj, w, dim);
+      for(int l=0;l<dim;l++) w[l] -= alpha[j] * qj[l];
+      if(j > 0){
+        const double *qi = &q[(j - 1) * dim];
+        for(int l=0;l<dim;l++) w[l] -= beta[j - 1] * qi[l];
+      }
+      //full re-orthogonalization, cheap for the few steps
+      for(int i=0;i<=j;i++){
+        const double r = dot(&q[i * dim], w, dim);
+        for(int l=0;l<dim;l++) w[l] -= r * q[i * dim + l];
+      }
+      beta[j] = sqrt(dot(w, w, dim));
+      if(beta[j] <= 1e-12 * fabs(alpha[j])){
+        steps = j + 1;
+        break;
+      }
+      for(int l=0;l<dim;l++) w[l] /= beta[j];
+    }
+    //largest Ritz value plus its residual
+    vector<double> t(steps * steps, 0.0), theta(steps);
+    for(int j=0;j<steps;j++){
+      t[j + j * steps] = alpha[j];
+      if(j + 1 < steps) t[j + (j + 1) * steps] = t[(j + 1) + j * steps] = beta[j];
+    }
+    if(smallDiag(&t[0], &theta[0], steps)) return 0.0;
+    return theta[steps - 1] + fabs(beta[steps - 1] * t[(steps - 1) + (steps - 1) * steps]);
+  }
+
+  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  // Lowest eigenpairs by LOBPCG, Hessian vector products only
+  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  int BlockHessianDiagonalize::iterativeDiagHessian(Hessian &hsn, double *eigVecO,
+                                                    double *eigValO, int dim, int numVec,
+                                                    int numOut, const vector<int> &blockStart,
+                                                    bool warmStart, Real tolerance,
+                                                    Real &maxEig){
+    //block size, the guard vectors speed up the convergence of the last wanted ones
+    const int m = min(dim, numVec + max(4, numVec / 5));
+    const int maxIter = 1000;
+
+    //residual tolerance relative to the largest eigenvalue
+    maxEig = maxEigenvalue(hsn, dim);
+    const double resTol = tolerance * fabs(maxEig);
+
+    vector<double> prec;
+    blockPreconditioner(hsn, blockStart, prec, dim);
+
+    //basis [X P W] and H times the basis, X and P of m columns
+    vector<double> v(3 * m * dim), av(3 * m * dim);
+    vector<double> xn(m * dim), axn(m * dim), pn(m * dim), apn(m * dim);
+    vector<double> g(9 * m * m), lambda(3 * m), resid(m), r(dim);
+
+    //start from the previous eigenvectors and random guard vectors
+    startVectors(&v[0], dim, m);
+    if(warmStart)
+      for(int i=0;i<numOut*dim;i++) v[i] = eigVecO[i];
+    int nx = orthonormalize(&v[0], 0, 0, m, dim);
+    if(nx < m)
+      report << error << "[BlockHessianDiagonalize::iterativeDiagHessian] Start vectors are "
+             << "linearly dependent (" << nx << " of " << m << ")." << endr;
+    hsn.multiply(&v[0], &av[0], nx);
+
+    int np = 0, iter = 0, converged = 0;
+    for(;;){
+      //Rayleigh-Ritz in span[X P W], first pass over X only
+      int n = nx;
+      if(iter > 0){
+        //W = T R of the unconverged vectors
+        int nw = 0;
+        for(int j=0;j<m;j++){
+          if(resid[j] <= resTol) continue;
+          const double *x = &v[j * dim];
+          const double *ax = &av[j * dim];
+          for(int l=0;l<dim;l++) r[l] = ax[l] - lambda[j] * x[l];
+          applyPreconditioner(blockStart, prec, &r[0], &v[(m + np + nw) * dim]);
+          nw++;
+        }
+        nw = orthonormalize(&v[0], 0, m + np, nw, dim);
+        if(nw > 0) hsn.multiply(&v[(m + np) * dim], &av[(m + np) * dim], nw);
+        n = m + np + nw;
+      }
+
+      gramMatrix(&v[0], &av[0], &g[0], dim, n, n);
+      for(int i=0;i<n;i++)
+        for(int j=0;j<i;j++)
+          g[i + j * n] = g[j + i * n] = 0.5 * (g[i + j * n] + g[j + i * n]);
+      if(smallDiag(&g[0], &lambda[0], n))
+        report << error << "[BlockHessianDiagonalize::iterativeDiagHessian] Rayleigh-Ritz failed." << endr;
+
+      //X = V C, P = [P W] C with the rows of X removed
+      combine(&v[0], &g[0], n, &xn[0], dim, n, m);
+      combine(&av[0], &g[0], n, &axn[0], dim, n, m);
+      if(n > m){
+        combine(&v[m * dim], &g[m], n, &pn[0], dim, n - m, m);
+        combine(&av[m * dim], &g[m], n, &apn[0], dim, n - m, m);
+      }
+      copy(xn.begin(), xn.end(), v.begin());
+      copy(axn.begin(), axn.end(), av.begin());
+      np = 0;
+      if(n > m){
+        copy(pn.begin(), pn.end(), v.begin() + m * dim);
+        copy(apn.begin(), apn.end(), av.begin() + m * dim);
+        np = orthonormalize(&v[0], &av[0], m, m, dim);
+      }
+
+      //residual norms
+      for(int j=0;j<m;j++){
+        const double *x = &v[j * dim];
+        const double *ax = &av[j * dim];
+        double sum = 0.0;
+        for(int l=0;l<dim;l++) sum += (ax[l] - lambda[j] * x[l]) * (ax[l] - lambda[j] * x[l]);
+        resid[j] = sqrt(sum);
+      }
+      for(converged=0;converged<numVec && resid[converged]<=resTol;converged++);
+
+      if(converged == numVec || iter == maxIter) break;
+      iter++;
+    }
+
+    report << debug(1) << "[BlockHessianDiagonalize::iterativeDiagHessian] " << converged
+           << " of " << numVec << " eigenvectors converged in " << iter << " iterations." << endr;
+
+    //order by magnitude as absSort
+    vector<pair<double, int> > order(numVec);
+    for(int j=0;j<numVec;j++) order[j] = make_pair(fabs(lambda[j]), j);
+    stable_sort(order.begin(), order.end());
+    for(int j=0;j<numVec;j++){
+      eigValO[j] = lambda[order[j].second];
+      if(j < numOut)
+        copy(v.begin() + order[j].second * dim, v.begin() + (order[j].second + 1) * dim,
+             eigVecO + j * dim);
+    }
+
+    return numVec - converged;
+  }
+
   //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   // Sort vectors for absolute value
   //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -25,6 +25,12 @@ namespace ProtoMol {
   enum {OUTPUTEGVAL = 0};
   enum {OUTPUTBHESS = 0};
 
+    /// LAPACK work arrays of one thread, kept between diagonalizations
+    struct DiagWorkspace {
+      vector<double> work;
+      vector<int> iwork, isuppz, index;
+    };
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // Constructors, destructors, assignment
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -48,9 +54,16 @@ namespace ProtoMol {
                           const bool geom, const bool numeric);
     int diagHessian(double *eigVecO, double *eigValO,
                     double *hsnhessM, int dim, int &numFound);
+    int iterativeDiagHessian(Hessian &hsn, double *eigVecO,
+                             double *eigValO, int dim, int numVec,
+                             int numOut, const vector<int> &blockStart,
+                             bool warmStart, Real tolerance, Real &maxEig);
+    Real maxEigenvalue(Hessian &hsn, int dim);
     void absSort(double *eigVec, double *eigVal, int *eigIndx, int dim);
 
   private:
+    int diagHessian(double *eigVecO, double *eigValO, double *hsnhessM,
+                    int dim, int &numFound, DiagWorkspace &ws);
     void innerHessian();
     void calculateS(Vector3DBlock *myPositions,
                        GenericTopology *myTopo);
@@ -80,6 +93,7 @@ namespace ProtoMol {
     vector<BlockMatrix> blockEigVect;
     BlockMatrix innerDiag, innerEigVec;
     vector<Real> blocVectCol;
+    vector<DiagWorkspace> workspaces;
     //
     StandardIntegrator *intg;
     //
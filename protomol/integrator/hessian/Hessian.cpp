@@ -42,10 +42,18 @@ namespace ProtoMol {
 //constructors
 Hessian::Hessian() {
   hessM = 0;
+  mySparse = false;
+  myMatrixFree = false;
+  myFreePositions = 0; myFreeTopo = 0; myFreeMrw = false;
+  myProductX = 0; myProductY = 0; myProductVecs = 0;
 }
 
 Hessian::Hessian(unsigned int szin) {
   sz = szin;
+  mySparse = false;
+  myMatrixFree = false;
+  myFreePositions = 0; myFreeTopo = 0; myFreeMrw = false;
+  myProductX = 0; myProductY = 0; myProductVecs = 0;
   try{
     hessM = new double[sz * sz];   //assign array
   }catch(bad_alloc&){
@@ -70,6 +78,14 @@ Hessian::Hessian(const Hessian &hess) {
     for (unsigned int i = 0; i < sz * sz; i++) hessM[i] = hess.hessM[i];
   } else
     hessM = 0;
+  mySparse = hess.mySparse;
+  hessS = hess.hessS;
+  myMatrixFree = hess.myMatrixFree;
+  myBlockOf = hess.myBlockOf;
+  myFreePositions = hess.myFreePositions;
+  myFreeTopo = hess.myFreeTopo;
+  myFreeMrw = hess.myFreeMrw;
+  myProductX = 0; myProductY = 0; myProductVecs = 0;
   myBond = hess.myBond;
   myAngle = hess.myAngle;
   myCoulomb = hess.myCoulomb;
@@ -101,8 +117,14 @@ Hessian::Hessian(const Hessian &hess) {
   lSwitchoff = hess.lSwitchoff;
 }
 
-void Hessian::initialData(unsigned int szin) {
+void Hessian::initialData(unsigned int szin, bool sparse) {
   sz = szin;
+  mySparse = sparse;
+  if (mySparse) {
+    //blocks of interacting atoms only
+    hessS.initialize(sz / 3);
+    return;
+  }
   if (hessM == 0){
       try{
         hessM = new double[sz * sz];   //assign array
@@ -113,6 +135,15 @@ void Hessian::initialData(unsigned int szin) {
   //if (hessM == 0) hessM = new double[sz * sz]; //assign array
 }
 
+void Hessian::initialMatrixFree(unsigned int szin, const vector<int> &blockStart) {
+  sz = szin;
+  mySparse = myMatrixFree = true;
+  hessS.initialize(sz / 3);
+  myBlockOf.assign(sz / 3, 0);
+  for (unsigned int b = 0; b + 1 < blockStart.size(); b++)
+    for (int i = blockStart[b]; i < blockStart[b + 1]; i++) myBlockOf[i] = b;
+}
+
 void Hessian::findForces(ForceGroup *overloadedForces) {
   vector<Force *> ListForces = overloadedForces->getForces();
   //
@@ -423,6 +454,36 @@ void Hessian::findForces(ForceGroup *overloadedForces) {
 void Hessian::evaluate(const Vector3DBlock *myPositions,
                        GenericTopology *myTopo,
                        bool mrw) {
+  if (myMatrixFree) {
+    //products are found at these positions
+    myFreePositions = myPositions;
+    myFreeTopo = myTopo;
+    myFreeMrw = mrw;
+  }
+  evaluateTerms(myPositions, myTopo, mrw);
+  //
+  if (mySparse) hessS.compress();
+
+}
+
+void Hessian::product(const Vector3DBlock *myPositions, GenericTopology *myTopo,
+                      const bool mrw, const double *x, double *y, int numVec) {
+  if (numVec < 1) return;
+  sz = 3 * myPositions->size();
+  for (unsigned int i = 0; i < sz * numVec; i++) y[i] = 0.0;
+  //the blocks go to y instead of the matrix
+  myProductX = x;
+  myProductY = y;
+  myProductVecs = numVec;
+  evaluateTerms(myPositions, myTopo, mrw);
+  myProductX = 0;
+  myProductY = 0;
+  myProductVecs = 0;
+}
+
+void Hessian::evaluateTerms(const Vector3DBlock *myPositions,
+                            GenericTopology *myTopo,
+                            const bool mrw) {
   int a1, a2, a3;
   unsigned int i;
   ReducedHessAngle rh;
@@ -451,8 +512,8 @@ void Hessian::evaluate(const Vector3DBlock *myPositions,
         for (int ii = 0; ii < 4; ii++)
           for (int kk = 0; kk < 4; kk++) {
             Matrix3By3 rhd = hi(ii, kk);
-            outputSparseMatrix(aout[ii], aout[kk], myTopo->atoms[aout[ii]].scaledMass,
-                myTopo->atoms[aout[kk]].scaledMass, rhd, mrw, sz, hessM);
+            outputBlock(aout[ii], aout[kk], myTopo->atoms[aout[ii]].scaledMass,
+                myTopo->atoms[aout[kk]].scaledMass, rhd, mrw);
           }
 
       }
@@ -481,8 +542,8 @@ void Hessian::evaluate(const Vector3DBlock *myPositions,
         for (int ii = 0; ii < 4; ii++)
           for (int kk = 0; kk < 4; kk++) {
             Matrix3By3 rhd = hd(ii, kk);
-            outputSparseMatrix(aout[ii], aout[kk], myTopo->atoms[aout[ii]].scaledMass,
-                myTopo->atoms[aout[kk]].scaledMass, rhd, mrw, sz, hessM);
+            outputBlock(aout[ii], aout[kk], myTopo->atoms[aout[ii]].scaledMass,
+                myTopo->atoms[aout[kk]].scaledMass, rhd, mrw);
           }
 
       }
@@ -510,8 +571,8 @@ void Hessian::evaluate(const Vector3DBlock *myPositions,
         for (int ii = 0; ii < 4; ii++)
           for (int kk = 0; kk < 4; kk++) {
             Matrix3By3 rhd = hd(ii, kk);
-            outputSparseMatrix(aout[ii], aout[kk], myTopo->atoms[aout[ii]].scaledMass,
-                myTopo->atoms[aout[kk]].scaledMass, rhd, mrw, sz, hessM);
+            outputBlock(aout[ii], aout[kk], myTopo->atoms[aout[ii]].scaledMass,
+                myTopo->atoms[aout[kk]].scaledMass, rhd, mrw);
           }
 
       }
@@ -528,8 +589,8 @@ void Hessian::evaluate(const Vector3DBlock *myPositions,
       Matrix3By3 bondHess12 =
         reducedHessBond((*myPositions)[a1], (*myPositions)[a2], k, r_0);
       //output sparse matrix
-      outputSparsePairMatrix(a1,a2,myTopo->atoms[a1].scaledMass,myTopo->atoms[a2].scaledMass,
-                                bondHess12,mrw,sz,hessM);
+      outputPair(a1,a2,myTopo->atoms[a1].scaledMass,myTopo->atoms[a2].scaledMass,
+                                bondHess12,mrw);
 
     }
   }
@@ -565,8 +626,8 @@ void Hessian::evaluate(const Vector3DBlock *myPositions,
       for (int ii = 0; ii < 3; ii++)
         for (int kk = 0; kk < 3; kk++) {
           rha = rh(ii, kk);
-          outputSparseMatrix(aout[ii], aout[kk], myTopo->atoms[aout[ii]].scaledMass,
-              myTopo->atoms[aout[kk]].scaledMass, rha, mrw, sz, hessM);
+          outputBlock(aout[ii], aout[kk], myTopo->atoms[aout[ii]].scaledMass,
+              myTopo->atoms[aout[kk]].scaledMass, rha, mrw);
 
         }
 
@@ -592,41 +653,67 @@ void Hessian::evaluate(const Vector3DBlock *myPositions,
     //report << plain <<"Hessian : Appropriate flags set for calculation of GB hessian"<<endr;
   }
 
-  unsigned int atoms_size = myTopo->atoms.size();
-  for (unsigned int i = 0; i < atoms_size; i++){
-    for (unsigned int j = i + 1; j < atoms_size; j++){
-      Matrix3By3 rhp(0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0);
-      //Lennard jones
-      if (myLennardJones)
-        rhp += evaluatePairsMatrix(i, j, LENNARDJONES, myPositions, myTopo, mrw);
-      //Coulombic
-      if (myCoulomb)
-        rhp += evaluatePairsMatrix(i, j, COULOMB, myPositions, myTopo, mrw);
-      //Coulombic Implicit solvent
-      if (myCoulombDielec)
-        rhp += evaluatePairsMatrix(i, j, COULOMBDIELEC, myPositions, myTopo, mrw);
-      //SCP
-      if (myCoulombSCPISM)
-        rhp += evaluatePairsMatrix(i, j, COULOMBSCPISM, myPositions, myTopo, mrw);
-      //Bourn radii
-      if (myBornRadii && myBornSelf && myTopo->doSCPISM)
-        rhp += evaluateBornSelfPair(i, j, myPositions, myTopo);
-
-
-      if (myGBBornRadii && myGBACEForce && myTopo->doGBSAOpenMM) {
-        rhp += evaluateGBACEPair(i, j, myPositions, myTopo);
-      }
+  //pairs within the cutoffs from the cell lists, else all pairs
+  const Real pairCutoff = pairListCutoff(myTopo);
+  if (pairCutoff > 0.0) {
+    myTopo->uncacheCellList();
+    myTopo->getCutoffPairs(*myPositions, pairCutoff, myPairs);
+    for (unsigned int k = 0; k < myPairs.size(); k++)
+      evaluatePairTerms(myPairs[k].first, myPairs[k].second, myPositions, myTopo, mrw);
+  } else if (pairCutoff == 0.0) {
+    unsigned int atoms_size = myTopo->atoms.size();
+    for (unsigned int i = 0; i < atoms_size; i++)
+      for (unsigned int j = i + 1; j < atoms_size; j++)
+        evaluatePairTerms(i, j, myPositions, myTopo, mrw);
+  }
 
-      if (myGBBornRadii && myGBForce && myTopo->doGBSAOpenMM) {
-         rhp += evaluateGBPair(i, j, myPositions, myTopo);
-      }
-      //output sum to matrix
-      outputSparsePairMatrix(i, j, myTopo->atoms[i].scaledMass, myTopo->atoms[j].scaledMass,
-                              rhp, mrw, sz, hessM);
-      //
-    }
+}
+
+//Cutoff of the pair list, 0 if a pairwise term has no cutoff and
+//negative without pairwise terms
+Real Hessian::pairListCutoff(const GenericTopology *myTopo) const {
+  const bool coulomb = myCoulomb || myCoulombDielec || myCoulombSCPISM;
+  const bool bornSelf = myBornRadii && myBornSelf && myTopo->doSCPISM;
+  const bool gb = myGBBornRadii && (myGBACEForce || myGBForce) && myTopo->doGBSAOpenMM;
+
+  if (!myLennardJones && !coulomb && !bornSelf && !gb) return -1.0;
+  if (gb || (myLennardJones && !lSwitch) || (coulomb && !cSwitch)) return 0.0;
+
+  Real cutoff = cutOff;
+  if (bornSelf) cutoff = max(cutoff, sqrt((Real)BORNCUTOFF2));
+  return cutoff;
+}
+
+void Hessian::evaluatePairTerms(int i, int j, const Vector3DBlock *myPositions,
+                                const GenericTopology *myTopo, const bool mrw) {
+  Matrix3By3 rhp(0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0);
+  //Lennard jones
+  if (myLennardJones)
+    rhp += evaluatePairsMatrix(i, j, LENNARDJONES, myPositions, myTopo, mrw);
+  //Coulombic
+  if (myCoulomb)
+    rhp += evaluatePairsMatrix(i, j, COULOMB, myPositions, myTopo, mrw);
+  //Coulombic Implicit solvent
+  if (myCoulombDielec)
+    rhp += evaluatePairsMatrix(i, j, COULOMBDIELEC, myPositions, myTopo, mrw);
+  //SCP
+  if (myCoulombSCPISM)
+    rhp += evaluatePairsMatrix(i, j, COULOMBSCPISM, myPositions, myTopo, mrw);
+  //Bourn radii
+  if (myBornRadii && myBornSelf && myTopo->doSCPISM)
+    rhp += evaluateBornSelfPair(i, j, myPositions, myTopo);
+
+
+  if (myGBBornRadii && myGBACEForce && myTopo->doGBSAOpenMM) {
+    rhp += evaluateGBACEPair(i, j, myPositions, myTopo);
   }
-  //
+
+  if (myGBBornRadii && myGBForce && myTopo->doGBSAOpenMM) {
+     rhp += evaluateGBPair(i, j, myPositions, myTopo);
+  }
+  //output sum to matrix
+  outputPair(i, j, myTopo->atoms[i].scaledMass, myTopo->atoms[j].scaledMass,
+                          rhp, mrw);
 
 }
 
@@ -793,6 +880,92 @@ void Hessian::outputSparseMatrix(int i, int j, Real massi, Real massj,
 
 }
 
+void Hessian::outputSparsePairMatrix(int i, int j, Real massi, Real massj,
+                                        Matrix3By3 rha, bool mrw, SparseBlockMatrix &mat){
+    //pairs beyond the cutoffs add no blocks
+    if (rha.zero()) return;
+
+    Real fi = 1.0, fj = 1.0, fij = -1.0;
+    if (mrw) {
+        fi = 1.0 / sqrt(massi * massi);
+        fj = 1.0 / sqrt(massj * massj);
+        fij = -1.0 / sqrt(massi * massj);
+    }
+    mat.add(i, i, rha, fi);
+    mat.add(j, j, rha, fj);
+    mat.add(i, j, rha, fij);
+    mat.add(j, i, rha, fij);
+}
+
+void Hessian::outputSparseMatrix(int i, int j, Real massi, Real massj,
+                                    Matrix3By3 rha, bool mrw, SparseBlockMatrix &mat){
+
+    mat.add(i, j, rha, mrw ? 1.0 / sqrt(massi * massj) : 1.0);
+
+}
+
+//y += H_pair x for the pair blocks of outputSparsePairMatrix
+void Hessian::productPair(int i, int j, Real massi, Real massj,
+                            const Matrix3By3 &rha, bool mrw){
+    if (rha.zero()) return;
+
+    Real fi = 1.0, fj = 1.0, fij = -1.0;
+    if (mrw) {
+        fi = 1.0 / sqrt(massi * massi);
+        fj = 1.0 / sqrt(massj * massj);
+        fij = -1.0 / sqrt(massi * massj);
+    }
+    for (int k = 0; k < myProductVecs; k++) {
+        const double *xi = myProductX + k * sz + 3 * i, *xj = myProductX + k * sz + 3 * j;
+        double *yi = myProductY + k * sz + 3 * i, *yj = myProductY + k * sz + 3 * j;
+        for (int ll = 0; ll < 3; ll++)
+            for (int mm = 0; mm < 3; mm++) {
+                const double h = rha(ll, mm);
+                yi[ll] += h * (fi * xi[mm] + fij * xj[mm]);
+                yj[ll] += h * (fij * xi[mm] + fj * xj[mm]);
+            }
+    }
+}
+
+//y += H_ij x_j for the block of outputSparseMatrix
+void Hessian::productBlock(int i, int j, Real massi, Real massj,
+                            const Matrix3By3 &rha, bool mrw){
+    const double f = mrw ? 1.0 / sqrt(massi * massj) : 1.0;
+    for (int k = 0; k < myProductVecs; k++) {
+        const double *xj = myProductX + k * sz + 3 * j;
+        double *yi = myProductY + k * sz + 3 * i;
+        for (int ll = 0; ll < 3; ll++)
+            yi[ll] += f * (rha(ll, 0) * xj[0] + rha(ll, 1) * xj[1] + rha(ll, 2) * xj[2]);
+    }
+}
+
+void Hessian::outputPair(int i, int j, Real massi, Real massj,
+                            const Matrix3By3 &rha, bool mrw){
+    if (myProductY != 0)
+        productPair(i, j, massi, massj, rha, mrw);
+    else if (myMatrixFree && myBlockOf[i] != myBlockOf[j]) {
+        //matrix free, diagonal blocks of the pair only
+        if (rha.zero()) return;
+        hessS.add(i, i, rha, mrw ? 1.0 / sqrt(massi * massi) : 1.0);
+        hessS.add(j, j, rha, mrw ? 1.0 / sqrt(massj * massj) : 1.0);
+    } else if (mySparse)
+        outputSparsePairMatrix(i, j, massi, massj, rha, mrw, hessS);
+    else
+        outputSparsePairMatrix(i, j, massi, massj, rha, mrw, sz, hessM);
+}
+
+void Hessian::outputBlock(int i, int j, Real massi, Real massj,
+                            const Matrix3By3 &rha, bool mrw){
+    if (myProductY != 0)
+        productBlock(i, j, massi, massj, rha, mrw);
+    else if (myMatrixFree && myBlockOf[i] != myBlockOf[j])
+        return;
+    else if (mySparse)
+        outputSparseMatrix(i, j, massi, massj, rha, mrw, hessS);
+    else
+        outputSparseMatrix(i, j, massi, massj, rha, mrw, sz, hessM);
+}
+
 //Find Born radii
 void Hessian::evaluateBornRadii(const Vector3DBlock *myPositions,
                                   GenericTopology *myTopo){
@@ -807,19 +980,20 @@ void Hessian::evaluateBornRadii(const Vector3DBlock *myPositions,
     myTopo->atoms[i].mySCPISM_A->energySum = true;
     myTopo->atoms[i].mySCPISM_A->D_s = 0.0;
   }
-  //check all pairs
-  for (unsigned int i = 0; i < atoms_size; i++){
-    for (unsigned int j = i + 1; j < atoms_size; j++){
-      //if not bonded/dihedral
-      ExclusionClass ec = myTopo->exclusions.check(i, j);
-      if (ec != EXCLUSION_FULL) {
-        Vector3D rij =
-              myTopo->minimalDifference((*myPositions)[i], (*myPositions)[j]);
-        Real a = rij.normSquared();
-        if(a < BORNCUTOFF2){ //within cutoff of 5A?
-          Real rawE = 0.0, rawF = 0.0;
-          br(rawE, rawF, a, 1.0 / a, rij, myTopo, i, j, ec);  //do the calculation, no force/energy returned.
-        }
+  //check all pairs within 5A, from the cell lists
+  myTopo->uncacheCellList();
+  myTopo->getCutoffPairs(*myPositions, sqrt((Real)BORNCUTOFF2), myPairs);
+  for (unsigned int k = 0; k < myPairs.size(); k++){
+    const int i = myPairs[k].first, j = myPairs[k].second;
+    //if not bonded/dihedral
+    ExclusionClass ec = myTopo->exclusions.check(i, j);
+    if (ec != EXCLUSION_FULL) {
+      Vector3D rij =
+            myTopo->minimalDifference((*myPositions)[i], (*myPositions)[j]);
+      Real a = rij.normSquared();
+      if(a < BORNCUTOFF2){ //within cutoff of 5A?
+        Real rawE = 0.0, rawF = 0.0;
+        br(rawE, rawF, a, 1.0 / a, rij, myTopo, i, j, ec);  //do the calculation, no force/energy returned.
       }
     }
   }
@@ -928,7 +1102,7 @@ Matrix3By3 Hessian::evaluateGBPair(int i, int j, const Vector3DBlock *myPosition
    if (1) { //ec != EXCLUSION_FULL) {
       Vector3D rij = myTopo->minimalDifference((*myPositions)[i], (*myPositions)[j]);
       Real a = rij.normSquared();
-      rha = rHessGB(a, rij, myTopo, i, j, sz, soluteDielec, solventDielec, ec);
+      rha = rHessGB(a, rij, myTopo, myPositions, i, j, sz, soluteDielec, solventDielec, ec);
    }
 
    return rha;
@@ -937,9 +1111,43 @@ Matrix3By3 Hessian::evaluateGBPair(int i, int j, const Vector3DBlock *myPosition
 
 //Clear Hessian
 void Hessian::clear() {
-  if (hessM != 0)
+  if (mySparse)
+    hessS.clear();
+  else if (hessM != 0)
     for (unsigned int i = 0; i < sz * sz; i++) hessM[i] = 0.0;
 
+}
+
+//Scale Hessian
+void Hessian::scale(double s) {
+  if (mySparse)
+    hessS.scale(s);
+  else if (hessM != 0)
+    for (unsigned int i = 0; i < sz * sz; i++) hessM[i] *= s;
+
+}
+
+//Hessian vector product
+void Hessian::multiply(const double *x, double *y, int numVec) {
+  if (myMatrixFree) {
+    //terms at the positions of the last evaluate(), the state is
+    //restored by product()
+    product(myFreePositions, myFreeTopo, myFreeMrw, x, y, numVec);
+    return;
+  }
+  for (int k = 0; k < numVec; k++, x += sz, y += sz) {
+    if (mySparse) {
+      hessS.multiply(x, y);
+      continue;
+    }
+    //symmetric, so rows of the column major array
+    for (unsigned int i = 0; i < sz; i++) {
+      double sum = 0.0;
+      const double *col = hessM + i * sz;
+      for (unsigned int j = 0; j < sz; j++) sum += col[j] * x[j];
+      y[i] = sum;
+    }
+  }
 }
     //set Hessian column
     bool Hessian::setHessianColumn( const Vector3DBlock &hescol, const unsigned int columnNumber,
@@ -948,7 +1156,21 @@ void Hessian::clear() {
         sz = 3 * hescol.size();
 
         //loop over column elements
-        if (hessM != 0 && columnNumber < sz){
+        if (mySparse && columnNumber < sz){
+            for (unsigned int i = 0; i < sz; i++){
+
+                Real factor = 1.0;
+
+                if(massWeight) factor /= sqrt(myTopo->atoms[i/3].scaledMass);
+
+                if(hescol[i/3][i%3] != 0.0)
+                    hessS.add(i, columnNumber, hescol[i/3][i%3] * factor);
+            }
+            hessS.compress();
+
+            return true;
+
+        }else if (hessM != 0 && columnNumber < sz){
             for (unsigned int i = 0; i < sz; i++){
 
                 Real factor = 1.0;
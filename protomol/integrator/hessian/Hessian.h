@@ -5,6 +5,10 @@
 #include <protomol/force/Force.h>
 #include <protomol/type/Vector3DBlock.h>
 #include <protomol/type/Matrix3By3.h>
+#include <protomol/type/SparseBlockMatrix.h>
+#include <protomol/type/SimpleTypes.h>
+
+#include <vector>
 
 namespace ProtoMol {
   /**
@@ -12,6 +16,16 @@ namespace ProtoMol {
    * Calculates the Hessian or mass re-weighted hessian
    * for the current force field.
    *
+   * The Hessian is either dense, hessM of sz*sz doubles, or block sparse,
+   * hessS holding the 3x3 blocks of interacting atom pairs only (see
+   * initialData). Both forms support products with vectors, the sparse
+   * form needs O(N) memory for bonded and cutoff force fields.
+   *
+   * Products can also be found without storing the Hessian (product()),
+   * the 3x3 blocks of the terms are applied to the vector as they are
+   * evaluated. With cutoffs the pairs are taken from the cell lists, so
+   * a product needs O(N) time and memory.
+   *
    */
   class Hessian {
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -37,11 +51,19 @@ namespace ProtoMol {
     // New methods of class Hessian
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   public:
-    void initialData(unsigned int szin);
+    void initialData(unsigned int szin, bool sparse = false);
+    // matrix free: evaluate() keeps the blocks within the atom blocks
+    // [blockStart[b], blockStart[b + 1]) only, e.g. for preconditioners,
+    // and multiply() calls product() at the positions of evaluate()
+    void initialMatrixFree(unsigned int szin, const std::vector<int> &blockStart);
     void findForces(ForceGroup *overloadedForces);
     void evaluate(const Vector3DBlock *myPositions,   //positions
                   GenericTopology *myTopo,      //topology
                   const bool mrw);                    //mass re-weighted
+    // y = H x, x and y of numVec vectors of size 3N, without forming H.
+    // Each block is evaluated once for all vectors.
+    void product(const Vector3DBlock *myPositions, GenericTopology *myTopo,
+                 const bool mrw, const double *x, double *y, int numVec = 1);
 
     Matrix3By3 evaluatePairsMatrix(int i, int j, int pairType, const Vector3DBlock *myPositions,
                        const GenericTopology *myTopo, bool mrw);
@@ -52,6 +74,10 @@ namespace ProtoMol {
                                 bool mrw, int arrSz, double * basePoint);
     void outputSparseMatrix(int i, int j, Real massi, Real massj, Matrix3By3 rha, 
                             bool mrw, int arrSz, double * basePoint);
+    void outputSparsePairMatrix(int i, int j, Real massi, Real massj, Matrix3By3 rha, 
+                                bool mrw, SparseBlockMatrix &mat);
+    void outputSparseMatrix(int i, int j, Real massi, Real massj, Matrix3By3 rha, 
+                            bool mrw, SparseBlockMatrix &mat);
 
     void evaluateBornRadii(const Vector3DBlock *myPositions, GenericTopology *myTopo);
 
@@ -72,8 +98,25 @@ namespace ProtoMol {
     Matrix3By3 evaluateGBPair(int i, int j, const Vector3DBlock *myPositions,
                                   const GenericTopology *myTopo);
 
+  private:
+    void evaluateTerms(const Vector3DBlock *myPositions, GenericTopology *myTopo,
+                       const bool mrw);
+    void evaluatePairTerms(int i, int j, const Vector3DBlock *myPositions,
+                           const GenericTopology *myTopo, const bool mrw);
+    Real pairListCutoff(const GenericTopology *myTopo) const;
+    void productPair(int i, int j, Real massi, Real massj, const Matrix3By3 &rha, bool mrw);
+    void productBlock(int i, int j, Real massi, Real massj, const Matrix3By3 &rha, bool mrw);
+    void outputPair(int i, int j, Real massi, Real massj, const Matrix3By3 &rha, bool mrw);
+    void outputBlock(int i, int j, Real massi, Real massj, const Matrix3By3 &rha, bool mrw);
+
   public:
     void clear(); // clear the hessian matrix
+    void scale(double s); // multiply the hessian matrix by s
+    // y = H x, x and y of numVec vectors of size sz. Not const, matrix
+    // free products use the work members of product()
+    void multiply(const double *x, double *y, int numVec = 1);
+    bool isSparse() const {return mySparse;}
+    bool isMatrixFree() const {return myMatrixFree;}
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // Friends of class Hessian
@@ -112,8 +155,19 @@ namespace ProtoMol {
     unsigned int sz; //size
     int myBornSwitch;
     Real myDielecConst;
+    bool mySparse;  //block sparse storage
+    bool myMatrixFree;  //products by product(), hessS holds the atom blocks
+    std::vector<int> myBlockOf;  //atom block of each atom if matrix free
+    const Vector3DBlock *myFreePositions;  //state of the last evaluate()
+    GenericTopology *myFreeTopo;
+    bool myFreeMrw;
+    const double *myProductX;  //product in progress
+    double *myProductY;
+    int myProductVecs;
+    std::vector<PairInt> myPairs;  //pairs within the cutoffs
   public:
     double *hessM;  //matrix
+    SparseBlockMatrix hessS;  //block sparse matrix
     Real cutOff;
   };
 }
@@ -56,12 +56,11 @@ HessianInt::~HessianInt() {
   info = 0;
   int numModes = numberOfModes;
   //fix summed Hessian to average
-  if (hsn.hessM != 0 && totStep > 1 && fullDiag)
-    for (unsigned int i = 0; i < sz * sz; i++)
-      hsn.hessM[i] /= (double)totStep;
+  if (totStep > 1 && fullDiag)
+    hsn.scale(1.0 / (double)totStep);
 
   //
-  if (eigVec != 0 && totStep &&
+  if ((eigVec != 0 || hsn.isSparse()) && totStep &&
       (evecfile != "" || evalfile != "" || hessfile != "")) {
 
     if(evecfile != "" || evalfile != ""){
@@ -106,6 +105,8 @@ HessianInt::~HessianInt() {
           report <<plain<<"NML Timing: Hessian: "<<(blockDiag.hessianTime.getTime()).getRealTime()
               <<"[s] ("<<totStep<<" times), diagonalize: "<<(blockDiag.rediagTime.getTime()).getRealTime()<<
                   "[s]."<<endl;
+          if(hsn.isSparse()) report <<plain<<"NML Memory: Hessian: "<<hsn.hessS.memory() / 1000000
+              <<"[Mb] ("<<hsn.hessS.blocks()<<" blocks)."<<endl;
           if(!fullDiag) report <<plain<<"NML Memory: Hessian: "<<(hsn.memory_base + hsn.memory_blocks) * sizeof(Real) / 1000000
               <<"[Mb], diagonalize: "<<blockDiag.memory_footprint * sizeof(Real) / 1000000<<
               "[Mb], vectors: "<<sz*numberOfModes*sizeof(double)/1000000<<"[Mb]."<<endl;
@@ -146,7 +147,9 @@ void HessianInt::initialize(ProtoMolApp *app) {
   if(numberOfModes == 0 || numberOfModes > sz) numberOfModes = sz;
   //
   if(fullDiag){
-    hsn.initialData(sz);
+    //Hessian output only, store the blocks of interacting atoms
+    bool sparse = (evecfile == "" && evalfile == "");
+    hsn.initialData(sz, sparse);
     hsn.clear();
   }else{
     //assign hessian array for residues, and clear.
@@ -157,11 +160,13 @@ void HessianInt::initialize(ProtoMolApp *app) {
   //
   int vecSize = sz * sz;
   if(!fullDiag) vecSize = sz * numberOfModes;
-  try{
-    eigVec = new double[vecSize];
-  }catch(bad_alloc&){
-      report << error << "[HessianInt::initialize] Cannot allocate memory for "
-             << "Eigenvectors." << endr;
+  if(!hsn.isSparse()){
+    try{
+      eigVec = new double[vecSize];
+    }catch(bad_alloc&){
+        report << error << "[HessianInt::initialize] Cannot allocate memory for "
+               << "Eigenvectors." << endr;
+    }
   }
   //Initialize BlockHessianDiagonalize, pass BlockHessian if Blocks (not full diag)
   if(fullDiag){
@@ -268,7 +273,17 @@ void HessianInt::outputDiagHess(int numModes) {
   if (hessfile != "") {
     myFile.open(hessfile.c_str(), ofstream::out);
     myFile.precision(10);
-    if(fullDiag){
+    if(fullDiag && hsn.isSparse()){
+      //output hessian blocks, column row value as for the dense form
+      const SparseBlockMatrix &hs = hsn.hessS;
+      for (i = 0; i < hs.blockRows(); i++)
+        for (unsigned int k = hs.rowStart(i); k < hs.rowStart(i + 1); k++)
+          for (unsigned int l = 0; l < 9; l++)
+            if (hs.block(k)[l] != 0.0)
+              myFile << 3 * hs.column(k) + l % 3 + 1 << " " << 3 * i + l / 3 + 1
+                     << " " << hs.block(k)[l] << endl;
+
+    }else if(fullDiag){
       //output hessian matrix to sparse form
       for (i = 0; i < sz * sz; i++)
         if (hsn.hessM[i] != 0.0)
@@ -40,14 +40,15 @@ namespace ProtoMol
     memory_eigenvector(0), checkpointUpdate(false), origCEigVal(0),
     origTimestep(0), autoParmeters(false), adaptiveTimestep(0),
     postDiagonalizeMinimize(0), minLim(0), maxMinSteps(0), 
-    geometricfdof(false), numerichessians(false) {
+    geometricfdof(false), numerichessians(false), iterativeDiag(false),
+    iterativeTolerance(0), matrixFree(false) {
   }
 
   NormalModeDiagonalize::
   NormalModeDiagonalize(int cycles, int redi, bool fDiag, bool rRand,
                         Real redhy, Real eTh, int bvc, int rpb, Real dTh, 
                         bool apar, bool adts, bool pdm, Real ml, int maxit,
-                        bool geo, bool num,
+                        bool geo, bool num, bool iter, Real itol, bool mfree,
                         ForceGroup *overloadedForces,
                         StandardIntegrator *nextIntegrator ) :
     MTSIntegrator( cycles, overloadedForces, nextIntegrator ),
@@ -60,7 +61,8 @@ namespace ProtoMol
     residuesPerBlock( rpb ),  memory_Hessian(0), memory_eigenvector(0),
     checkpointUpdate( false ), origCEigVal(0), origTimestep(0),
     autoParmeters(apar), adaptiveTimestep( adts ), postDiagonalizeMinimize(pdm),
-    minLim(ml), maxMinSteps(maxit), geometricfdof(geo), numerichessians(num) {
+    minLim(ml), maxMinSteps(maxit), geometricfdof(geo), numerichessians(num),
+    iterativeDiag(iter), iterativeTolerance(itol), matrixFree(mfree) {
 
     //find forces and parameters
     rHsn.findForces( overloadedForces );
@@ -77,7 +79,7 @@ namespace ProtoMol
       << " diagonalize: " << ( blockDiag.rediagTime.getTime() ).getRealTime() << "[s] (" << rediagCounter << " re-diagonalizations)."
       << endl;
 
-      if ( !fullDiag ) {
+      if ( !fullDiag || iterativeDiag ) {
         report << plain << "NML Memory: "
         << "Hessian: "     << memory_Hessian     << "[Mb], "
         << "diagonalize: " << memory_eigenvector << "[Mb], "
@@ -117,9 +119,40 @@ namespace ProtoMol
     app->energies.clear(); //Need this or initial error, due to inner integrator energy?
     initializeForces();
 
+    if ( iterativeDiag && !fullDiag ) {
+      report << error << "[NormalModeDiagonalize::initialize] iterativeDiag requires fullDiag." << endr;
+    }
+
+    if ( matrixFree && !iterativeDiag ) {
+      report << error << "[NormalModeDiagonalize::initialize] matrixFree requires iterativeDiag." << endr;
+    }
+
     //Initialize Hessian array, OR assign hessian array for residues.
+    //The iterative eigensolver needs Hessian vector products only.
     if ( fullDiag ) {
-      rHsn.initialData( _3N );
+      if ( !matrixFree ) rHsn.initialData( _3N, iterativeDiag );
+
+      //blocks of residuesPerBlock residues for the preconditioner
+      if ( iterativeDiag ) {
+        if ( residuesPerBlock == 0 ) residuesPerBlock = std::max( 1, (int)pow((double)_N,0.6) / 15 );
+        preconditionerBlocks.clear();
+        preconditionerBlocks.push_back( 0 );
+        int current_id = app->topology->atoms[0].residue_seq;
+        int residues = 0;
+        for ( int i = 1; i < _N; i++ ) {
+          if ( app->topology->atoms[i].residue_seq != current_id ) {
+            current_id = app->topology->atoms[i].residue_seq;
+            if ( ++residues == residuesPerBlock ) {
+              preconditionerBlocks.push_back( i );
+              residues = 0;
+            }
+          }
+        }
+        preconditionerBlocks.push_back( _N );
+
+        //only the preconditioner blocks are stored
+        if ( matrixFree ) rHsn.initialMatrixFree( _3N, preconditionerBlocks );
+      }
     } else {
 
       //automatically generate parameters?
@@ -146,7 +179,7 @@ namespace ProtoMol
 
       //Calculate array size to be created
       app->eigenInfo.myEigenvectorLength = _N;
-      app->eigenInfo.myNumEigenvectors = ( fullDiag == true ) ? _3N : _rfM;
+      app->eigenInfo.myNumEigenvectors = ( fullDiag && !iterativeDiag ) ? _3N : _rfM;
       if(!app->eigenInfo.initializeEigenvectors())
           report << error << "Eigenvector array allocation error." << endr;
 
@@ -264,7 +297,7 @@ namespace ProtoMol
 
         //set flags if firstDiag
         if ( firstDiag ) {
-          numEigvectsu = ( fullDiag == true ) ? _3N : _rfM;
+          numEigvectsu = ( fullDiag && !iterativeDiag ) ? _3N : _rfM;
           *eigValP = max_eig;
 
           //first max eigenvalue in C, save original timestep for adaptive use
@@ -338,7 +371,39 @@ namespace ProtoMol
   Real NormalModeDiagonalize::doDiagonalization(){
     
     //Diagonalize
-    if ( fullDiag ) {
+    if ( fullDiag && iterativeDiag ) {
+      //****Iterative method*****************************************************************//
+      // LOBPCG for the lowest _rfM + 1 modes from sparse Hessian vector products, started  //
+      // from the current eigenvectors. Matrix free products evaluate the force field terms  //
+      // for each product.                                                                   //
+      //*************************************************************************************//
+      report << debug(2) << "Start iterative diagonalization." << endr;
+
+      blockDiag.hessianTime.start(); //time Hessian
+      rHsn.clear();
+      rHsn.evaluate( &app->positions, app->topology, true ); //mass re-weighted hessian
+      blockDiag.hessianTime.stop();
+      hessianCounter++;
+
+      blockDiag.rediagTime.start();
+      const int numVec = std::min( _rfM + 1, _3N );
+      Real max_eigenvalue;
+      int unconverged = blockDiag.iterativeDiagHessian( rHsn, *Q, blockDiag.eigVal, _3N,
+                                                        numVec, _rfM, preconditionerBlocks, validMaxEigv,
+                                                        iterativeTolerance, max_eigenvalue );
+      if ( unconverged ) {
+        report << warning << "[NormalModeDiagonalize::run] " << unconverged
+               << " eigenvectors not converged." << endr;
+      }
+      blockDiag.rediagTime.stop();
+      rediagCounter++;
+
+      //diagnostics
+      memory_Hessian = rHsn.hessS.memory() / 1000000;
+
+      return max_eigenvalue;
+
+    } else if ( fullDiag ) {
       //****Full method**********************************************************************//
       // Uses BLAS/LAPACK to do 'brute force' diagonalization                                //
       //*************************************************************************************//
@@ -503,6 +568,18 @@ namespace ProtoMol
                                     Value(numerichessians, ConstraintValueType::NoConstraints()),
                                     false, Text("Calculate Hessians numerically.")));
 
+    parameters.push_back( Parameter("iterativeDiag",
+                                    Value(iterativeDiag, ConstraintValueType::NoConstraints()),
+                                    false, Text("Find the lowest modes of the full Hessian iteratively (LOBPCG).")));
+
+    parameters.push_back( Parameter("iterativeTolerance",
+                                    Value(iterativeTolerance, ConstraintValueType::Positive()),
+                                    1e-6, Text("Residual tolerance of the iterative eigensolver, relative to the largest eigenvalue.")));
+
+    parameters.push_back( Parameter("matrixFree",
+                                    Value(matrixFree, ConstraintValueType::NoConstraints()),
+                                    false, Text("Iterative eigensolver Hessian vector products without storing the Hessian.")));
+
 
     
       }
@@ -515,6 +592,7 @@ namespace ProtoMol
                                       values[6], values[7], values[8], 
                                       values[9], values[10], values[11],
                                       values[12], values[13],values[14], values[15], 
+                                      values[16], values[17], values[18],
                                       fg, nextIntegrator               );
   }
 
@@ -39,7 +39,8 @@ namespace ProtoMol
                              bool rRand,
                              Real redhy, Real eTh, int bvc, int rpb, Real dTh, 
                              bool apar, bool adts, bool pdm, Real ml, int maxit,
-                             bool geo, bool num, ForceGroup *overloadedForces,
+                             bool geo, bool num, bool iter, Real itol, bool mfree,
+                             ForceGroup *overloadedForces,
                              StandardIntegrator *nextIntegrator );
       ~NormalModeDiagonalize();
 
@@ -57,7 +58,7 @@ namespace ProtoMol
       //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     public:
       virtual std::string getIdNoAlias() const {return keyword;}
-      virtual unsigned int getParameterSize() const {return 16;}
+      virtual unsigned int getParameterSize() const {return 18;}
       virtual void getParameters( std::vector<Parameter>& parameters ) const;
 
       //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -132,6 +133,12 @@ namespace ProtoMol
       //numerical and geometric Hessian
       bool geometricfdof, numerichessians;
 
+      //iterative eigensolver for the full Hessian
+      bool iterativeDiag;
+      Real iterativeTolerance;
+      bool matrixFree; ///< Hessian vector products without storing the Hessian
+      std::vector<int> preconditionerBlocks; ///< First atom of each residue block
+
   };
 }
 
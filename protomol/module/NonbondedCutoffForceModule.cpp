@@ -17,6 +17,7 @@
 #include <protomol/force/born/BornSelfForce.h>
 #include <protomol/force/nonbonded/NonbondedCutoffSystemForce.h>
 #include <protomol/force/table/LennardJonesTableForce.h>
+#include <protomol/force/table/SplineTableForce.h>
 
 #include <protomol/switch/C1SwitchingFunction.h>
 #include <protomol/switch/C2SwitchingFunction.h>
@@ -52,6 +53,7 @@ void NonbondedCutoffForceModule::registerForces(ProtoMolApp *app) {
   typedef UniversalSwitchingFunction Universal;
   typedef CutoffSwitchingFunction Cutoff;
 #define CutoffSystem NonbondedCutoffSystemForce
+#define Spline SplineTableForce
 
   if (equalNocase(boundConds, PeriodicBoundaryConditions::keyword)) {
     // NonbondedCutoffSystemForce CoulombForce
@@ -72,6 +74,24 @@ void NonbondedCutoffForceModule::registerForces(ProtoMolApp *app) {
           LennardJonesTableForce<Cn, 7 ,Real> > >());
     f.reg(new CutoffSystem<CCM, OneAtomPair<PBC, Universal,
           LennardJonesTableForce<CmpCnCn, 7 ,Real> > >());
+
+    // Spline tables of the switched LennardJonesForce and CoulombForce
+    f.reg(new CutoffSystem<CCM, OneAtomPair<PBC, Universal,
+          Spline<C2, LennardJonesForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPair<PBC, Universal,
+          Spline<Cn, LennardJonesForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPair<PBC, Universal,
+          Spline<CmpCnCn, LennardJonesForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPair<PBC, Universal,
+          Spline<C2, CoulombForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPair<PBC, Universal,
+          Spline<Cn, CoulombForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPairTwo<PBC, Universal,
+          Spline<C2, LennardJonesForce>, Universal, Spline<C2, CoulombForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPairTwo<PBC, Universal,
+          Spline<C2, LennardJonesForce>, Universal, Spline<Cn, CoulombForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPairTwo<PBC, Universal,
+          Spline<Cn, LennardJonesForce>, Universal, Spline<Cn, CoulombForce> > >());
     
     // NonbondedCutoffSystemForce LennardJonesForce CoulombForce
     f.reg(new CutoffSystem<CCM, OneAtomPairTwo<PBC, C2, LennardJonesForce,
@@ -126,6 +146,24 @@ void NonbondedCutoffForceModule::registerForces(ProtoMolApp *app) {
           LennardJonesTableForce<Cn, 7 ,Real> > >());
     f.reg(new CutoffSystem<CCM, OneAtomPair<VBC, Universal,
           LennardJonesTableForce<CmpCnCn, 7 ,Real> > >());
+
+    // Spline tables of the switched LennardJonesForce and CoulombForce
+    f.reg(new CutoffSystem<CCM, OneAtomPair<VBC, Universal,
+          Spline<C2, LennardJonesForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPair<VBC, Universal,
+          Spline<Cn, LennardJonesForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPair<VBC, Universal,
+          Spline<CmpCnCn, LennardJonesForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPair<VBC, Universal,
+          Spline<C2, CoulombForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPair<VBC, Universal,
+          Spline<Cn, CoulombForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPairTwo<VBC, Universal,
+          Spline<C2, LennardJonesForce>, Universal, Spline<C2, CoulombForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPairTwo<VBC, Universal,
+          Spline<C2, LennardJonesForce>, Universal, Spline<Cn, CoulombForce> > >());
+    f.reg(new CutoffSystem<CCM, OneAtomPairTwo<VBC, Universal,
+          Spline<Cn, LennardJonesForce>, Universal, Spline<Cn, CoulombForce> > >());
     
     // NonbondedCutoffSystemForce LennardJonesForce CoulombForce
     f.reg(new CutoffSystem<CCM, OneAtomPairTwo<VBC, C2, LennardJonesForce, C1,
@@ -6,6 +6,7 @@
 #include <protomol/topology/PeriodicBoundaryConditions.h>
 
 #include <protomol/force/nonbonded/NonbondedFullEwaldSystemForce.h>
+#include <protomol/force/nonbonded/NonbondedPMEwaldSystemForce.h>
 
 #include <protomol/switch/CutoffSwitchingFunction.h>
 
@@ -25,6 +26,7 @@ void NonbondedFullElectrostaticForceModule::registerForces(ProtoMolApp *app) {
   typedef PeriodicBoundaryConditions PBC;
   typedef CutoffSwitchingFunction Cutoff;
 #define FullEwald NonbondedFullEwaldSystemForce
+#define PMEwald NonbondedPMEwaldSystemForce
 
   if (equalNocase(boundConds, PBC::keyword)) {
     // Full Ewald
@@ -35,6 +37,14 @@ void NonbondedFullElectrostaticForceModule::registerForces(ProtoMolApp *app) {
     f.reg(new FullEwald<PBC,CCM,false,true,true,Cutoff>());
     f.reg(new FullEwald<PBC,CCM,false,false,true,Cutoff>());
 
+    // Smooth particle mesh Ewald
+    f.reg(new PMEwald<PBC,CCM,true,true,true,Cutoff>(),Vector<std::string>("CoulombPME"));
+    f.reg(new PMEwald<PBC,CCM,true,false,false,Cutoff>());
+    f.reg(new PMEwald<PBC,CCM,true,false,true,Cutoff>());
+    f.reg(new PMEwald<PBC,CCM,false,true,false,Cutoff>());
+    f.reg(new PMEwald<PBC,CCM,false,true,true,Cutoff>());
+    f.reg(new PMEwald<PBC,CCM,false,false,true,Cutoff>());
+
   } 
 
 }
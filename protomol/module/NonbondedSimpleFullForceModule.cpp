@@ -34,6 +34,7 @@
 #include <protomol/force/GB/GBForce.h>
 #include <protomol/force/GB/GBACEForce.h>
 #include <protomol/force/GB/GBPartialSum.h>
+#include <protomol/force/GB/GBOBCSystemForce.h>
 
 
 using namespace std;
@@ -204,6 +205,7 @@ void NonbondedSimpleFullForceModule::registerForces(ProtoMolApp *app) {
     f.reg(new SimpleFullSystem<OneAtomPairNoExclusion<VBC, Universal, GBForce> >());
     f.reg(new SimpleFullSystem<OneAtomPairNoExclusion<VBC, Universal, GBACEForce> >());
     f.reg(new SimpleFullSystem<OneAtomPairNoExclusion<VBC, Universal, GBPartialSum> >());
+    f.reg(new GBOBCSystemForce<VBC>());
 
 
     // OneAtomPairTwo
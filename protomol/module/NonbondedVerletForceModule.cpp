@@ -0,0 +1,79 @@
+#include <protomol/module/NonbondedVerletForceModule.h>
+
+#include <protomol/ProtoMolApp.h>
+#include <protomol/base/StringUtilities.h>
+#include <protomol/module/TopologyModule.h>
+#include <protomol/topology/PeriodicBoundaryConditions.h>
+#include <protomol/topology/VacuumBoundaryConditions.h>
+
+#include <protomol/force/OneAtomPair.h>
+#include <protomol/force/OneAtomPairTwo.h>
+#include <protomol/force/CoulombForce.h>
+#include <protomol/force/LennardJonesForce.h>
+#include <protomol/force/nonbonded/NonbondedVerletSystemForce.h>
+
+#include <protomol/switch/C1SwitchingFunction.h>
+#include <protomol/switch/C2SwitchingFunction.h>
+#include <protomol/switch/CnSwitchingFunction.h>
+
+#include <protomol/topology/CellListEnumeratorPeriodicBoundaries.h>
+#include <protomol/topology/CellListEnumeratorStandard.h>
+
+using namespace std;
+using namespace ProtoMol;
+
+void NonbondedVerletForceModule::registerForces(ProtoMolApp *app) {
+  ForceFactory &f = app->forceFactory;
+  string boundConds = app->config[InputBoundaryConditions::keyword];
+
+  typedef PeriodicBoundaryConditions PBC;
+  typedef VacuumBoundaryConditions VBC;
+  typedef CubicCellManager CCM;
+  typedef C1SwitchingFunction C1;
+  typedef C2SwitchingFunction C2;
+  typedef CnSwitchingFunction Cn;
+#define VerletSystem NonbondedVerletSystemForce
+
+  if (equalNocase(boundConds, PeriodicBoundaryConditions::keyword)) {
+    // NonbondedVerletSystemForce CoulombForce
+    f.reg(new VerletSystem<CCM, OneAtomPair<PBC, C1, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPair<PBC, C2, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPair<PBC, Cn, CoulombForce> >());
+
+    // NonbondedVerletSystemForce LennardJonesForce
+    f.reg(new VerletSystem<CCM, OneAtomPair<PBC, C1, LennardJonesForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPair<PBC, C2, LennardJonesForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPair<PBC, Cn, LennardJonesForce> >());
+
+    // NonbondedVerletSystemForce LennardJonesForce CoulombForce
+    f.reg(new VerletSystem<CCM, OneAtomPairTwo<PBC, C2, LennardJonesForce,
+          C1, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPairTwo<PBC, C2, LennardJonesForce,
+          C2, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPairTwo<PBC, C2, LennardJonesForce,
+          Cn, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPairTwo<PBC, Cn, LennardJonesForce,
+          Cn, CoulombForce> >());
+
+  } else if (equalNocase(boundConds, VacuumBoundaryConditions::keyword)) {
+    // NonbondedVerletSystemForce CoulombForce
+    f.reg(new VerletSystem<CCM, OneAtomPair<VBC, C1, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPair<VBC, C2, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPair<VBC, Cn, CoulombForce> >());
+
+    // NonbondedVerletSystemForce LennardJonesForce
+    f.reg(new VerletSystem<CCM, OneAtomPair<VBC, C1, LennardJonesForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPair<VBC, C2, LennardJonesForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPair<VBC, Cn, LennardJonesForce> >());
+
+    // NonbondedVerletSystemForce LennardJonesForce CoulombForce
+    f.reg(new VerletSystem<CCM, OneAtomPairTwo<VBC, C2, LennardJonesForce,
+          C1, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPairTwo<VBC, C2, LennardJonesForce,
+          C2, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPairTwo<VBC, C2, LennardJonesForce,
+          Cn, CoulombForce> >());
+    f.reg(new VerletSystem<CCM, OneAtomPairTwo<VBC, Cn, LennardJonesForce,
+          Cn, CoulombForce> >());
+  }
+}
@@ -0,0 +1,18 @@
+#ifndef NONBONDEDVERLETFORCE_MODULE_H
+#define NONBONDEDVERLETFORCE_MODULE_H
+
+#include <protomol/base/Module.h>
+
+#include <string>
+
+namespace ProtoMol {
+  class ProtoMolApp;
+
+  class NonbondedVerletForceModule : public Module {
+  public:
+    const std::string getName() const {return "NonbondedVerletForce";}
+    void registerForces(ProtoMolApp *app);
+  };
+}
+
+#endif // NONBONDEDVERLETFORCE_MODULE_H
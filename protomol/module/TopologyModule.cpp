@@ -5,6 +5,8 @@
 #include <protomol/topology/CubicCellManager.h>
 #include <protomol/topology/VacuumBoundaryConditions.h>
 #include <protomol/topology/PeriodicBoundaryConditions.h>
+#include <protomol/topology/CellListEnumeratorStandard.h>
+#include <protomol/topology/CellListEnumeratorPeriodicBoundaries.h>
 
 #include <protomol/ProtoMolApp.h>
 #include <protomol/module/MainModule.h>
@@ -18,6 +18,7 @@
 #include <protomol/module/IntegratorOpenMMModule.h>
 
 #include <protomol/module/NonbondedCutoffForceModule.h>
+#include <protomol/module/NonbondedVerletForceModule.h>
 #include <protomol/module/NonbondedFullElectrostaticForceModule.h>
 #include <protomol/module/NonbondedFullForceModule.h>
 #include <protomol/module/NonbondedSimpleFullForceModule.h>
@@ -46,6 +47,7 @@ void moduleInitFunction(ModuleManager *manager) {
   // Forces
   manager->add(new BondedForcesModule());
   manager->add(new NonbondedCutoffForceModule());
+  manager->add(new NonbondedVerletForceModule());
   manager->add(new NonbondedFullForceModule());
   manager->add(new NonbondedSimpleFullForceModule());
   manager->add(new NonbondedFullElectrostaticForceModule());
@@ -0,0 +1,372 @@
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <protomol/parallel/DomainDecomposition.h>
+#include <protomol/parallel/Parallel.h>
+#include <protomol/ProtoMolApp.h>
+#include <protomol/topology/GenericTopology.h>
+#include <protomol/integrator/Integrator.h>
+#include <protomol/integrator/leapfrog/LeapfrogIntegrator.h>
+#include <protomol/integrator/leapfrog/PLeapfrogIntegrator.h>
+#include <protomol/module/ModifierModule.h>
+#include <protomol/type/Vector3DBlock.h>
+#include <protomol/base/PMConstants.h>
+#include <protomol/base/TimerStatistic.h>
+#include <protomol/base/Report.h>
+
+#include <set>
+#include <algorithm>
+
+using namespace std;
+using namespace ProtoMol::Report;
+using namespace ProtoMol;
+
+#ifdef USE_REAL_IS_FLOAT
+#define MY_MPI_REAL MPI_FLOAT
+#endif
+
+#ifdef USE_REAL_IS_DOUBLE
+#define MY_MPI_REAL MPI_DOUBLE
+#endif
+
+//____ static
+#ifdef HAVE_MPI
+// Tags distinct from the ones of Parallel
+const int COUNT_TAG = 3;
+const int DATA_TAG = 4;
+
+// Reals per atom of the messages
+const int MIGRATE_SIZE = 8; // index, layer, position, velocity
+const int HALO_SIZE = 4;    // index, position
+const int GATHER_SIZE = 10; // index, position, velocity, force
+
+//____ ptr
+static Real *ptr(vector<Real> &v) {return v.empty() ? NULL : &v[0];}
+
+//____ neighborExchange
+// Sends send[k] to neighbors[k] and receives recv[k] from it, the
+// neighborhood is symmetric.
+static void neighborExchange(const vector<int> &neighbors,
+                             vector<vector<Real> > &send,
+                             vector<vector<Real> > &recv) {
+  const int n = neighbors.size();
+  recv.resize(n);
+  if (n == 0)
+    return;
+
+  vector<int> sendCounts(n), recvCounts(n);
+  vector<MPI_Request> requests(2 * n);
+  for (int k = 0; k < n; k++) {
+    sendCounts[k] = send[k].size();
+    MPI_Irecv(&recvCounts[k], 1, MPI_INT, neighbors[k], COUNT_TAG,
+              MPI_COMM_WORLD, &requests[k]);
+    MPI_Isend(&sendCounts[k], 1, MPI_INT, neighbors[k], COUNT_TAG,
+              MPI_COMM_WORLD, &requests[n + k]);
+  }
+  MPI_Waitall(2 * n, &requests[0], MPI_STATUSES_IGNORE);
+
+  for (int k = 0; k < n; k++) {
+    recv[k].resize(recvCounts[k]);
+    MPI_Irecv(ptr(recv[k]), recvCounts[k], MY_MPI_REAL, neighbors[k],
+              DATA_TAG, MPI_COMM_WORLD, &requests[k]);
+    MPI_Isend(ptr(send[k]), sendCounts[k], MY_MPI_REAL, neighbors[k],
+              DATA_TAG, MPI_COMM_WORLD, &requests[n + k]);
+  }
+  MPI_Waitall(2 * n, &requests[0], MPI_STATUSES_IGNORE);
+}
+#endif
+
+//____ DomainDecomposition
+
+bool DomainDecomposition::myInitialized = false;
+int DomainDecomposition::myLayers = 0;
+int DomainDecomposition::myHaloLayers = 0;
+vector<int> DomainDecomposition::myOwner;
+vector<int> DomainDecomposition::myNeighbors;
+vector<int> DomainDecomposition::myOwned;
+vector<int> DomainDecomposition::myHalo;
+vector<vector<int> > DomainDecomposition::mySent;
+vector<vector<int> > DomainDecomposition::myReceived;
+
+void DomainDecomposition::setup(const ProtoMolApp *app,
+                                const vector<int> &atoms, vector<int> &layers,
+                                Real halo) {
+  if (!myInitialized)
+    checkSupported(app);
+
+  const GenericTopology *topo = app->topology;
+  const int num = Parallel::getNum();
+  const int id = Parallel::getId();
+  const int numLayers = topo->getCellLayers(app->positions, atoms, layers);
+
+  if (numLayers < num)
+    report << error << "Domain decomposition of " << numLayers
+           << " cell layers on " << num << " nodes, decrease the cell size "
+           << "or the number of nodes." << endr;
+
+  Vector3D min, max;
+  topo->getBoundaryConditionsBox(min, max);
+  const Real width = (max.c[0] - min.c[0]) / numLayers;
+  // Same reach as the periodic cell list enumerator
+  const int haloLayers =
+    std::min(numLayers, (int)(halo / width + 1.0 + Constant::EPSILON));
+
+  if (numLayers == myLayers && haloLayers == myHaloLayers)
+    return;
+
+  myLayers = numLayers;
+  myHaloLayers = haloLayers;
+  myOwner.resize(numLayers);
+  for (int p = 0; p < num; p++)
+    for (int l = (numLayers * p) / num; l < (numLayers * (p + 1)) / num; l++)
+      myOwner[l] = p;
+
+  set<int> neighbors;
+  for (int l = (numLayers * id) / num; l < (numLayers * (id + 1)) / num; l++)
+    for (int d = -haloLayers; d <= haloLayers; d++)
+      neighbors.insert(owner(l + d));
+  neighbors.erase(id);
+  myNeighbors.assign(neighbors.begin(), neighbors.end());
+}
+
+void DomainDecomposition::checkSupported(const ProtoMolApp *app) {
+  if (!app->topology->isPeriodic())
+    report << error << "Domain decomposition requires periodic boundary "
+           << "conditions, not supported with vacuum." << endr;
+
+  if ((int)app->config[InputRemoveLinearMomentum::keyword] >= 0 ||
+      (int)app->config[InputRemoveAngularMomentum::keyword] >= 0)
+    report << error << "Domain decomposition does not support the removal "
+           << "of the linear or angular momentum, set "
+           << InputRemoveLinearMomentum::keyword << " and "
+           << InputRemoveAngularMomentum::keyword << " to -1." << endr;
+
+  if ((bool)app->config[InputShake::keyword] ||
+      (bool)app->config[InputRattle::keyword])
+    report << error << "Domain decomposition does not support constraints ("
+           << InputShake::keyword << ", " << InputRattle::keyword << ")."
+           << endr;
+
+  // Thermostats and Langevin integrators couple all atoms or need the
+  // same random numbers on all nodes
+  for (const Integrator *i = app->integrator->top(); i != 0; i = i->next())
+    if (i->getIdNoAlias() != LeapfrogIntegrator::keyword &&
+        i->getIdNoAlias() != PLeapfrogIntegrator::keyword)
+      report << error << "Domain decomposition does not support the "
+             << "integrator " << i->getIdNoAlias() << ", only "
+             << LeapfrogIntegrator::keyword << " and "
+             << PLeapfrogIntegrator::keyword << "." << endr;
+}
+
+int DomainDecomposition::owner(int layer) {
+  return myOwner[(layer % myLayers + myLayers) % myLayers];
+}
+
+#ifdef HAVE_MPI
+void DomainDecomposition::exchange(ProtoMolApp *app, Real halo) {
+  TimerStatistic::timer[TimerStatistic::COMMUNICATION].start();
+  GenericTopology *topo = app->topology;
+  Vector3DBlock *positions = &app->positions;
+  Vector3DBlock *velocities = &app->velocities;
+  const int id = Parallel::getId();
+  const int numAtoms = positions->size();
+  vector<char> &state = topo->domainAtoms;
+  vector<int> layers;
+
+  if (!myInitialized || static_cast<int>(state.size()) != numAtoms) {
+    // First call, all atoms are known to all nodes
+    vector<int> all(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+      all[i] = i;
+    setup(app, all, layers, halo);
+
+    state.assign(numAtoms, GenericTopology::DOMAIN_ABSENT);
+    myOwned.clear();
+    myHalo.clear();
+    for (int i = 0; i < numAtoms; i++)
+      if (owner(layers[i]) == id)
+        myOwned.push_back(i);
+    myInitialized = true;
+
+    report << hint << "Domain decomposition: " << myLayers << " layers, "
+           << myHaloLayers << " halo layers, " << myOwned.size()
+           << " atoms on the master." << endr;
+  }
+
+  // Forget the halo of the last evaluation
+  for (unsigned int i = 0; i < myHalo.size(); i++)
+    state[myHalo[i]] = GenericTopology::DOMAIN_ABSENT;
+  myHalo.clear();
+
+  setup(app, myOwned, layers, halo);
+
+  const int n = myNeighbors.size();
+  vector<int> index(Parallel::getNum(), -1);
+  for (int k = 0; k < n; k++)
+    index[myNeighbors[k]] = k;
+
+  // Migration of the atoms which left the slab
+  vector<vector<Real> > send(n), recv;
+  vector<int> owned;
+  vector<int> ownedLayers;
+  for (unsigned int i = 0; i < myOwned.size(); i++) {
+    const int atom = myOwned[i];
+    const int p = owner(layers[i]);
+    if (p == id) {
+      owned.push_back(atom);
+      ownedLayers.push_back(layers[i]);
+      continue;
+    }
+    if (index[p] < 0)
+      report << error << "Atom " << atom << " moved beyond the halo of the "
+             << "domain decomposition." << endr;
+
+    vector<Real> &b = send[index[p]];
+    b.push_back(atom);
+    b.push_back(layers[i]);
+    for (int c = 0; c < 3; c++)
+      b.push_back((*positions)[atom][c]);
+    for (int c = 0; c < 3; c++)
+      b.push_back((*velocities)[atom][c]);
+    state[atom] = GenericTopology::DOMAIN_ABSENT;
+  }
+
+  neighborExchange(myNeighbors, send, recv);
+
+  for (int k = 0; k < n; k++)
+    for (unsigned int i = 0; i < recv[k].size(); i += MIGRATE_SIZE) {
+      const Real *b = &recv[k][i];
+      const int atom = static_cast<int>(b[0]);
+      owned.push_back(atom);
+      ownedLayers.push_back(static_cast<int>(b[1]));
+      (*positions)[atom] = Vector3D(b[2], b[3], b[4]);
+      (*velocities)[atom] = Vector3D(b[5], b[6], b[7]);
+    }
+  myOwned.swap(owned);
+  for (unsigned int i = 0; i < myOwned.size(); i++)
+    state[myOwned[i]] = GenericTopology::DOMAIN_OWNED;
+
+  // Halo, owned atoms within the halo layers of the slab boundaries
+  mySent.assign(n, vector<int>());
+  for (int k = 0; k < n; k++)
+    send[k].clear();
+  vector<int> stamp(n, -1);
+  for (unsigned int i = 0; i < myOwned.size(); i++) {
+    const int atom = myOwned[i];
+    for (int d = -myHaloLayers; d <= myHaloLayers; d++) {
+      const int p = owner(ownedLayers[i] + d);
+      if (p == id || stamp[index[p]] == static_cast<int>(i))
+        continue;
+      const int k = index[p];
+      stamp[k] = i;
+      mySent[k].push_back(atom);
+      send[k].push_back(atom);
+      for (int c = 0; c < 3; c++)
+        send[k].push_back((*positions)[atom][c]);
+    }
+  }
+
+  neighborExchange(myNeighbors, send, recv);
+
+  myReceived.assign(n, vector<int>());
+  for (int k = 0; k < n; k++)
+    for (unsigned int i = 0; i < recv[k].size(); i += HALO_SIZE) {
+      const Real *b = &recv[k][i];
+      const int atom = static_cast<int>(b[0]);
+      (*positions)[atom] = Vector3D(b[1], b[2], b[3]);
+      state[atom] = GenericTopology::DOMAIN_HALO;
+      myReceived[k].push_back(atom);
+      myHalo.push_back(atom);
+    }
+
+  // Positions of migrated and halo atoms were written in place
+  topo->uncachePositionsSoA();
+
+  TimerStatistic::timer[TimerStatistic::COMMUNICATION].stop();
+}
+
+#else
+void DomainDecomposition::exchange(ProtoMolApp *, Real) {}
+
+#endif
+
+#ifdef HAVE_MPI
+void DomainDecomposition::reduce(Vector3DBlock *forces) {
+  const int n = myNeighbors.size();
+  vector<vector<Real> > send(n), recv;
+
+  // Forces on halo atoms back to their owners
+  for (int k = 0; k < n; k++)
+    for (unsigned int i = 0; i < myReceived[k].size(); i++) {
+      Vector3DB &f = (*forces)[myReceived[k][i]];
+      for (int c = 0; c < 3; c++)
+        send[k].push_back(f[c]);
+      f = Vector3D(0.0, 0.0, 0.0);
+    }
+
+  neighborExchange(myNeighbors, send, recv);
+
+  for (int k = 0; k < n; k++)
+    for (unsigned int i = 0; i < mySent[k].size(); i++) {
+      const Real *b = &recv[k][3 * i];
+      (*forces)[mySent[k][i]] += Vector3D(b[0], b[1], b[2]);
+    }
+}
+
+#else
+void DomainDecomposition::reduce(Vector3DBlock *) {}
+
+#endif
+
+#ifdef HAVE_MPI
+void DomainDecomposition::gather(Vector3DBlock *positions,
+                                 Vector3DBlock *velocities,
+                                 Vector3DBlock *forces) {
+  if (!myInitialized)
+    return;
+  TimerStatistic::timer[TimerStatistic::COMMUNICATION].start();
+
+  const int num = Parallel::getNum();
+  vector<Real> mine;
+  mine.reserve(GATHER_SIZE * myOwned.size());
+  for (unsigned int i = 0; i < myOwned.size(); i++) {
+    const int atom = myOwned[i];
+    mine.push_back(atom);
+    for (int c = 0; c < 3; c++)
+      mine.push_back((*positions)[atom][c]);
+    for (int c = 0; c < 3; c++)
+      mine.push_back((*velocities)[atom][c]);
+    for (int c = 0; c < 3; c++)
+      mine.push_back((*forces)[atom][c]);
+  }
+
+  int count = mine.size();
+  vector<int> counts(num), displs(num);
+  MPI_Allgather(&count, 1, MPI_INT, &counts[0], 1, MPI_INT, MPI_COMM_WORLD);
+  int total = 0;
+  for (int p = 0; p < num; p++) {
+    displs[p] = total;
+    total += counts[p];
+  }
+
+  vector<Real> all(total);
+  MPI_Allgatherv(ptr(mine), count, MY_MPI_REAL, ptr(all), &counts[0],
+                 &displs[0], MY_MPI_REAL, MPI_COMM_WORLD);
+
+  for (int i = 0; i < total; i += GATHER_SIZE) {
+    const Real *b = &all[i];
+    const int atom = static_cast<int>(b[0]);
+    (*positions)[atom] = Vector3D(b[1], b[2], b[3]);
+    (*velocities)[atom] = Vector3D(b[4], b[5], b[6]);
+    (*forces)[atom] = Vector3D(b[7], b[8], b[9]);
+  }
+
+  TimerStatistic::timer[TimerStatistic::COMMUNICATION].stop();
+}
+
+#else
+void DomainDecomposition::gather(Vector3DBlock *, Vector3DBlock *,
+                                 Vector3DBlock *) {}
+
+#endif
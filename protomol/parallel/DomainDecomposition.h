@@ -0,0 +1,98 @@
+/*  -*- c++ -*-  */
+#ifndef DOMAINDECOMPOSITION_H
+#define DOMAINDECOMPOSITION_H
+
+#include <vector>
+
+#include <protomol/type/Real.h>
+
+namespace ProtoMol {
+  class Vector3DBlock;
+  class ProtoMolApp;
+
+  //____ DomainDecomposition
+
+  /**
+   * Spatial domain decomposition of periodic systems, parallel mode
+   * "domain". The cell lists are cut along x into slabs of whole cell
+   * layers, one per node. A node owns the atoms of its slab, evaluates the
+   * cell pairs and bonded terms starting at its atoms and integrates them.
+   *
+   * Before each force evaluation atoms which left the slab migrate to their
+   * new owner and the positions of the atoms within the halo (the range of
+   * the forces) are sent to the neighbor nodes. After the evaluation the
+   * forces on halo atoms are sent back and added by their owners, such that
+   * the communication scales with the slab surface instead of the number
+   * of atoms; only the energies are summed over all nodes. The positions,
+   * velocities and forces of all atoms are gathered for outputs only.
+   *
+   * Entries of atoms owned by other nodes are out of date on each node.
+   * Integrators, modifiers and forces with reductions over all atoms
+   * (thermostats, constraints, removal of the momentum, full
+   * electrostatics, implicit solvent) are not supported; the integrator
+   * must be Leapfrog or PLeapfrog and the boundary conditions periodic.
+   */
+  class DomainDecomposition {
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    DomainDecomposition();
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class DomainDecomposition
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    /**
+     * Migrates the atoms which left the slab of this node and sends the
+     * positions of the atoms within halo of the slab boundaries to the
+     * neighbors. The first call distributes the atoms, which then must be
+     * known to all nodes.
+     */
+    static void exchange(ProtoMolApp *app, Real halo);
+
+    /// Adds the forces on halo atoms to their owners
+    static void reduce(Vector3DBlock *forces);
+
+    /// Collects the positions, velocities and forces of all atoms on all
+    /// nodes
+    static void gather(Vector3DBlock *positions, Vector3DBlock *velocities,
+                       Vector3DBlock *forces);
+
+    static bool initialized()               {return myInitialized;}
+
+    /// Number of atoms owned by this node
+    static unsigned int getNumOwned()       {return myOwned.size();}
+
+    /// Number of halo atoms of this node
+    static unsigned int getNumHalo()        {return myHalo.size();}
+
+  private:
+    /**
+     * Cell layers of the given atoms, the owners of the layers and the
+     * neighbors within the halo. The first call rejects the simulations
+     * which the decomposition does not support.
+     */
+    static void setup(const ProtoMolApp *app, const std::vector<int> &atoms,
+                      std::vector<int> &layers, Real halo);
+    static void checkSupported(const ProtoMolApp *app);
+    static int owner(int layer);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    static bool myInitialized;
+    static int myLayers;                 ///< Cell layers along x
+    static int myHaloLayers;             ///< Layers to send to the neighbors
+    static std::vector<int> myOwner;     ///< Node of each layer
+    static std::vector<int> myNeighbors; ///< Nodes within the halo
+    static std::vector<int> myOwned;     ///< Atoms owned by this node
+    static std::vector<int> myHalo;      ///< Halo atoms of this node
+    /// Owned atoms sent to each neighbor, in the order of the messages
+    static std::vector<std::vector<int> > mySent;
+    /// Halo atoms received from each neighbor
+    static std::vector<std::vector<int> > myReceived;
+  };
+}
+#endif /* DOMAINDECOMPOSITION_H */
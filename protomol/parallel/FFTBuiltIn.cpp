@@ -0,0 +1,317 @@
+#include <protomol/parallel/FFTBuiltIn.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
+
+#include <map>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace ProtoMol;
+
+//____ FFTBuiltIn
+
+FFTBuiltIn::FFTBuiltIn() :
+  myNX(0), myNY(0), myNZ(0), myNZComplex(0), myArray(NULL), myReal(NULL),
+  myThreads(0), myLength(0) {
+  myPlan[0] = myPlan[1] = myPlan[2] = NULL;
+}
+
+void FFTBuiltIn::initialize(int x, int y, int z, zomplex *a) {
+  myArray = a;
+  myReal = NULL;
+  prepare(x, y, z, z);
+}
+
+void FFTBuiltIn::initialize(int x, int y, int z, double *r, zomplex *a) {
+  myArray = a;
+  myReal = r;
+  prepare(x, y, z, (z % 2 == 0 ? z / 2 : z));
+}
+
+void FFTBuiltIn::prepare(int x, int y, int z, int zPlan) {
+  myNX = x;
+  myNY = y;
+  myNZ = z;
+  myNZComplex = (myReal != NULL ? z / 2 + 1 : z);
+  myPlan[0] = plan(x);
+  myPlan[1] = plan(y);
+  myPlan[2] = plan(zPlan);
+
+  myTwiddle.clear();
+  if (myReal != NULL && z % 2 == 0)
+    for (int k = 0; k < z / 2; k++) {
+      zomplex w;
+      w.re = cos(-2.0 * M_PI * k / z);
+      w.im = sin(-2.0 * M_PI * k / z);
+      myTwiddle.push_back(w);
+    }
+
+  myLength = max(myNX, max(myNY, myNZ));
+  myThreads = 0;
+}
+
+const FFTBuiltIn::Plan *FFTBuiltIn::plan(int n) {
+  // Twiddle factors are shared by all transforms of the same length, also
+  // across re-initializations after the box changed
+  static map<int, Plan> plans;
+
+  map<int, Plan>::iterator i = plans.find(n);
+  if (i != plans.end())
+    return &i->second;
+
+  Plan &p = plans[n];
+  p.n = n;
+  int m = n;
+  while (m % 4 == 0) {p.factors.push_back(4); m /= 4;}
+  while (m % 2 == 0) {p.factors.push_back(2); m /= 2;}
+  for (int f = 3; m > 1; f += 2)
+    while (m % f == 0) {p.factors.push_back(f); m /= f;}
+  p.roots.resize(n);
+  for (int k = 0; k < n; k++) {
+    double a = -2.0 * M_PI * k / n;
+    p.roots[k].re = cos(a);
+    p.roots[k].im = sin(a);
+  }
+
+  return &p;
+}
+
+void FFTBuiltIn::transform1D(const Plan &p, int sign, zomplex *data,
+                             zomplex *work) {
+  const int n = p.n;
+  const zomplex *w = &p.roots[0];
+  const double s = (sign < 0 ? 1.0 : -1.0); // Conjugates the roots
+  zomplex *src = data;
+  zomplex *dst = work;
+  int len = n;    // Length of the sub transforms of this pass
+  int stride = 1; // Number of interleaved sub transforms
+
+  for (unsigned int f = 0; f < p.factors.size(); f++) {
+    const int r = p.factors[f];
+    const int m = len / r;
+    const int step = n / len; // w[step*k] = exp(-2*PI*i*k/len)
+    for (int q = 0; q < m; q++) {
+      for (int t = 0; t < stride; t++) {
+        zomplex a[5];
+        zomplex b[5];
+        const zomplex *in = src + t + stride * q;
+        if (r == 2) {
+          a[0] = in[0]; a[1] = in[stride * m];
+          b[0].re = a[0].re + a[1].re; b[0].im = a[0].im + a[1].im;
+          b[1].re = a[0].re - a[1].re; b[1].im = a[0].im - a[1].im;
+        } else if (r == 4) {
+          for (int k = 0; k < 4; k++) a[k] = in[stride * m * k];
+          double t0r = a[0].re + a[2].re, t0i = a[0].im + a[2].im;
+          double t1r = a[0].re - a[2].re, t1i = a[0].im - a[2].im;
+          double t2r = a[1].re + a[3].re, t2i = a[1].im + a[3].im;
+          // -i*s*(a1 - a3)
+          double t3r = s * (a[1].im - a[3].im);
+          double t3i = -s * (a[1].re - a[3].re);
+          b[0].re = t0r + t2r; b[0].im = t0i + t2i;
+          b[1].re = t1r + t3r; b[1].im = t1i + t3i;
+          b[2].re = t0r - t2r; b[2].im = t0i - t2i;
+          b[3].re = t1r - t3r; b[3].im = t1i - t3i;
+        } else if (r == 3 || r == 5) {
+          for (int k = 0; k < r; k++) a[k] = in[stride * m * k];
+          for (int j = 0; j < r; j++) {
+            double re = 0.0, im = 0.0;
+            for (int k = 0; k < r; k++) {
+              const zomplex &c = w[((j * k) % r) * (n / r)];
+              re += a[k].re * c.re - s * a[k].im * c.im;
+              im += a[k].im * c.re + s * a[k].re * c.im;
+            }
+            b[j].re = re;
+            b[j].im = im;
+          }
+        }
+        zomplex *out = dst + t + stride * r * q;
+        if (r <= 5) {
+          out[0] = b[0];
+          for (int j = 1; j < r; j++) {
+            const zomplex &c = w[step * j * q];
+            out[stride * j].re = b[j].re * c.re - s * b[j].im * c.im;
+            out[stride * j].im = b[j].im * c.re + s * b[j].re * c.im;
+          }
+        } else {
+          // Generic prime factor, O(r^2)
+          for (int j = 0; j < r; j++) {
+            double re = 0.0, im = 0.0;
+            for (int k = 0; k < r; k++) {
+              const zomplex &x = in[stride * m * k];
+              const zomplex &c = w[((j * k) % r) * (n / r)];
+              re += x.re * c.re - s * x.im * c.im;
+              im += x.im * c.re + s * x.re * c.im;
+            }
+            const zomplex &c = w[(step * j * q) % n];
+            out[stride * j].re = re * c.re - s * im * c.im;
+            out[stride * j].im = im * c.re + s * re * c.im;
+          }
+        }
+      }
+    }
+    swap(src, dst);
+    len = m;
+    stride *= r;
+  }
+  if (src != data)
+    for (int k = 0; k < n; k++)
+      data[k] = src[k];
+}
+
+void FFTBuiltIn::transformLines(const Plan &p, int sign, int count,
+                                int inner, int outerStride, int stride) {
+  const int n = p.n;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(myThreads)
+#endif
+  for (int l = 0; l < count; l++) {
+    zomplex *line = &myBuffer[2 * myLength * ThreadForceBuffers::getThreadId()];
+    zomplex *work = line + myLength;
+    zomplex *base = myArray + (l / inner) * outerStride + l % inner;
+    if (stride == 1)
+      transform1D(p, sign, base, work);
+    else {
+      for (int k = 0; k < n; k++)
+        line[k] = base[k * stride];
+      transform1D(p, sign, line, work);
+      for (int k = 0; k < n; k++)
+        base[k * stride] = line[k];
+    }
+  }
+}
+
+void FFTBuiltIn::realToComplex() {
+  const int count = myNX * myNY;
+  const int nz = myNZ;
+  const int half = nz / 2;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(myThreads)
+#endif
+  for (int l = 0; l < count; l++) {
+    zomplex *line = &myBuffer[2 * myLength * ThreadForceBuffers::getThreadId()];
+    zomplex *work = line + myLength;
+    const double *in = myReal + l * nz;
+    zomplex *out = myArray + l * myNZComplex;
+
+    if (nz % 2 != 0) {
+      for (int k = 0; k < nz; k++) {
+        line[k].re = in[k];
+        line[k].im = 0.0;
+      }
+      transform1D(*myPlan[2], -1, line, work);
+      for (int k = 0; k < myNZComplex; k++)
+        out[k] = line[k];
+      continue;
+    }
+
+    // Even and odd samples as one complex sequence of half the length,
+    // X(k) = E(k) + exp(-2*PI*i*k/n) O(k)
+    for (int k = 0; k < half; k++) {
+      line[k].re = in[2 * k];
+      line[k].im = in[2 * k + 1];
+    }
+    transform1D(*myPlan[2], -1, line, work);
+    for (int k = 0; k <= half; k++) {
+      const zomplex &a = line[k % half];
+      const zomplex &b = line[(half - k) % half];
+      double er = 0.5 * (a.re + b.re), ei = 0.5 * (a.im - b.im);
+      double odr = 0.5 * (a.im + b.im), odi = -0.5 * (a.re - b.re);
+      const zomplex &w = myTwiddle[k % half];
+      double wr = (k == half ? -1.0 : w.re), wi = (k == half ? 0.0 : w.im);
+      out[k].re = er + wr * odr - wi * odi;
+      out[k].im = ei + wr * odi + wi * odr;
+    }
+  }
+}
+
+void FFTBuiltIn::complexToReal() {
+  const int count = myNX * myNY;
+  const int nz = myNZ;
+  const int half = nz / 2;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(myThreads)
+#endif
+  for (int l = 0; l < count; l++) {
+    zomplex *line = &myBuffer[2 * myLength * ThreadForceBuffers::getThreadId()];
+    zomplex *work = line + myLength;
+    double *out = myReal + l * nz;
+    const zomplex *in = myArray + l * myNZComplex;
+
+    if (nz % 2 != 0) {
+      // Hermitian completion
+      for (int k = 0; k < myNZComplex; k++)
+        line[k] = in[k];
+      for (int k = 1; k < myNZComplex; k++) {
+        line[nz - k].re = in[k].re;
+        line[nz - k].im = -in[k].im;
+      }
+      transform1D(*myPlan[2], 1, line, work);
+      for (int k = 0; k < nz; k++)
+        out[k] = line[k].re;
+      continue;
+    }
+
+    // Inverse of the split in realToComplex(), scaled by 2 such that the
+    // result is unnormalized with respect to the full length
+    for (int k = 0; k < half; k++) {
+      const zomplex &a = in[k];
+      const zomplex &b = in[half - k];
+      double er = a.re + b.re, ei = a.im - b.im;
+      double dr = a.re - b.re, di = a.im + b.im;
+      const zomplex &w = myTwiddle[k];
+      double odr = dr * w.re + di * w.im, odi = di * w.re - dr * w.im;
+      line[k].re = er - odi;
+      line[k].im = ei + odr;
+    }
+    transform1D(*myPlan[2], 1, line, work);
+    for (int k = 0; k < half; k++) {
+      out[2 * k] = line[k].re;
+      out[2 * k + 1] = line[k].im;
+    }
+  }
+}
+
+void FFTBuiltIn::forward() {
+  if (myArray == NULL)
+    return;
+
+  const int threads = ThreadForceBuffers::getNumThreads();
+  if (threads != myThreads) {
+    myThreads = threads;
+    myBuffer.resize(2 * myLength * myThreads);
+  }
+
+  const int nzc = myNZComplex;
+  if (myReal != NULL)
+    realToComplex();
+  else if (myNZ > 1)
+    transformLines(*myPlan[2], -1, myNX * myNY, 1, myNZ, 1);
+  if (myNY > 1)
+    transformLines(*myPlan[1], -1, myNX * nzc, nzc, myNY * nzc, nzc);
+  if (myNX > 1)
+    transformLines(*myPlan[0], -1, myNY * nzc, myNY * nzc, 0, myNY * nzc);
+}
+
+void FFTBuiltIn::backward() {
+  if (myArray == NULL)
+    return;
+
+  const int threads = ThreadForceBuffers::getNumThreads();
+  if (threads != myThreads) {
+    myThreads = threads;
+    myBuffer.resize(2 * myLength * myThreads);
+  }
+
+  const int nzc = myNZComplex;
+  if (myNX > 1)
+    transformLines(*myPlan[0], 1, myNY * nzc, myNY * nzc, 0, myNY * nzc);
+  if (myNY > 1)
+    transformLines(*myPlan[1], 1, myNX * nzc, nzc, myNY * nzc, nzc);
+  if (myReal != NULL)
+    complexToReal();
+  else if (myNZ > 1)
+    transformLines(*myPlan[2], 1, myNX * myNY, 1, myNZ, 1);
+}
@@ -0,0 +1,85 @@
+/*  -*- c++ -*-  */
+#ifndef FFTBUILTIN_H
+#define FFTBUILTIN_H
+
+#include <vector>
+
+#include <protomol/parallel/FFTComplex.h>
+
+namespace ProtoMol {
+  //____ FFTBuiltIn
+
+  /**
+   * Built-in mixed radix 3D FFT, used when no FFT library is configured and
+   * for real-to-complex transforms of libraries without them.
+   *
+   * The 3D transform is done as 1D transforms along z, y and x, strided
+   * lines are copied into a contiguous buffer first. The 1D transform is a
+   * Stockham autosort FFT over the factors of the length, with special
+   * butterflies for 2, 3, 4 and 5 and a generic one for any other prime
+   * factor. The lines of each direction are distributed over the OpenMP
+   * threads.
+   *
+   * The real-to-complex transform uses the layout of FFTW, the real array
+   * is x*y*z, the complex one x*y*(z/2+1) holding the non-negative z
+   * frequencies. Even z lengths are transformed as complex sequences of
+   * half the length. Both directions are unnormalized.
+   */
+  class FFTBuiltIn {
+    struct Plan {
+      int n;
+      std::vector<int> factors;
+      std::vector<zomplex> roots;  // exp(-2*PI*i*k/n), k = 0..n-1
+    };
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    FFTBuiltIn();
+  private:
+    FFTBuiltIn(const FFTBuiltIn &);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class FFTBuiltIn
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    /// In place complex transform of a (x*y*z)
+    void initialize(int x, int y, int z, zomplex *a);
+    /// Real r (x*y*z) to complex a (x*y*(z/2+1)) and back
+    void initialize(int x, int y, int z, double *r, zomplex *a);
+
+    void forward();
+    void backward();
+
+  private:
+    /// Plan of length n, kept for the lifetime of the program
+    static const Plan *plan(int n);
+    static void transform1D(const Plan &p, int sign, zomplex *data,
+                            zomplex *work);
+
+    void prepare(int x, int y, int z, int zPlan);
+    /// count lines, line l starts at (l/inner)*outerStride + l%inner
+    void transformLines(const Plan &p, int sign, int count, int inner,
+                        int outerStride, int stride);
+    void realToComplex();
+    void complexToReal();
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    int myNX;
+    int myNY;
+    int myNZ;
+    int myNZComplex;         // Complex length along z
+    zomplex *myArray;
+    double *myReal;          // NULL for complex transforms
+    const Plan *myPlan[3];
+    std::vector<zomplex> myTwiddle; // exp(-2*PI*i*k/z) for the real split
+    int myThreads;
+    int myLength;            // Buffer length per thread
+    std::vector<zomplex> myBuffer;
+  };
+}
+#endif /* FFTBUILTIN_H */
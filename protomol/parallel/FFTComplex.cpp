@@ -18,21 +18,6 @@
 #         ifdef HAVE_FFT_FFTW2_MPI
 #           include <fftw.h>
 #           include <fftw_mpi.h>
-#         else /* ZFFT */
-#           include <protomol/parallel/FFTComplex.h>     // Defines zomplex
-extern "C" {
-  extern zomplex *zfftm1di(int m, zomplex *save);
-  extern int zfftm1d(int sign, int m, int n, zomplex *array, 
-                     int incI, int incJ, zomplex *save);
-  
-  extern zomplex *zfft2di( int n1, int n2, zomplex *save);
-  extern int zfft2d(int sign, int n1, int n2, zomplex *array, 
-                    int ld, zomplex *save);
-  
-  extern zomplex *zfft3di(int n1, int n2, int n3, zomplex *save);
-  extern int zfft3d(int sign, int n1, int n2, int n3, zomplex *array, 
-                    int ld1, int ld2, zomplex *save);
-}
 #         endif
 #       endif
 #     endif
@@ -43,6 +28,8 @@ extern "C" {
 // Other includes
 //
 #include <protomol/parallel/FFTComplex.h>
+#include <protomol/parallel/FFTBuiltIn.h>
+#include <protomol/parallel/ThreadForceBuffers.h>
 #include <protomol/base/Timer.h>
 #include <protomol/base/MathUtilities.h>
 #include <protomol/base/Report.h>
@@ -53,10 +40,10 @@ namespace ProtoMol {
   //
   // Define the right implementation of FFTInternal
   //
-#if defined(HAVE_FFT_SGI) || !defined(HAVE_FFT)
+#if defined(HAVE_FFT_SGI)
   //________________________________________________________________ FFTInternal
   //
-  // complib.sgimath and ZFFT
+  // complib.sgimath
   //
   class FFTInternal {
 
@@ -95,12 +82,35 @@ namespace ProtoMol {
     myFFTCoeff = zfft3di(myNZ,myNY,myNX,NULL);    
   }
 
+#elif !defined(HAVE_FFT)
+  //________________________________________________________________ FFTInternal
+  //
+  // Built-in
+  //
+  class FFTInternal : public FFTBuiltIn {};
+
 #else
 #  ifdef HAVE_FFT_FFTW3
   //________________________________________________________________ FFTInternal
   //
   // FFTW3
   //
+  // Plans are kept as long as the dimensions do not change, a new array
+  // of the same alignment is transformed by the new-array execute
+  // functions instead of planning again. Plans created with
+  // HAVE_FFT_FFTW3_THREADS use the OpenMP threads.
+  //
+  static void fftw3PlanThreads(){
+#ifdef HAVE_FFT_FFTW3_THREADS
+    static bool initialized = false;
+    if(!initialized){
+      fftw_init_threads();
+      initialized = true;
+    }
+    fftw_plan_with_nthreads(ThreadForceBuffers::getNumThreads());
+#endif
+  }
+
   class FFTInternal {
 
   public:
@@ -110,8 +120,8 @@ namespace ProtoMol {
     ~FFTInternal();
 
     void initialize(int x, int y, int z,zomplex* a);
-    void forward(){ fftw_execute(myPlanForward);}
-    void backward(){fftw_execute(myPlanBackward);}
+    void forward(){ fftw_execute_dft(myPlanForward,myArray,myArray);}
+    void backward(){fftw_execute_dft(myPlanBackward,myArray,myArray);}
 
   private:
     FFTInternal(const FFTInternal&);
@@ -133,8 +143,11 @@ namespace ProtoMol {
   }
 
   void FFTInternal::initialize(int x, int y, int z,zomplex* a){
-    if(x == myNX && y == myNY && z == myNZ && (fftw_complex*)(a) == myArray)
+    if(x == myNX && y == myNY && z == myNZ && myArray != NULL &&
+       fftw_alignment_of((double*)a) == fftw_alignment_of((double*)myArray)){
+      myArray = (fftw_complex*)(a);
       return;
+    }
     Timer t;
     t.start();
     myNX = x;
@@ -145,6 +158,7 @@ namespace ProtoMol {
       fftw_destroy_plan(myPlanForward);
     if(myPlanBackward != NULL)
       fftw_destroy_plan(myPlanBackward);
+    fftw3PlanThreads();
     myPlanForward  = fftw_plan_dft_3d(myNX,myNY,myNZ,myArray,myArray,
                                       FFTW_FORWARD,  FFTW_MEASURE);
     myPlanBackward = fftw_plan_dft_3d(myNX,myNY,myNZ,myArray,myArray,
@@ -153,6 +167,70 @@ namespace ProtoMol {
     report << hint <<"FFTW3 Initialization: "<<t.getTime()<<"."<<endr;
   }
 
+  //____________________________________________________________ FFTInternalReal
+  //
+  // FFTW3 real-to-complex
+  //
+  class FFTInternalReal {
+
+  public:
+    FFTInternalReal():
+      myNX(0),myNY(0),myNZ(0),myReal(NULL),myArray(NULL),myPlanForward(NULL),
+      myPlanBackward(NULL){}
+    ~FFTInternalReal();
+
+    void initialize(int x, int y, int z,double* r,zomplex* a);
+    void forward(){ fftw_execute_dft_r2c(myPlanForward,myReal,myArray);}
+    void backward(){fftw_execute_dft_c2r(myPlanBackward,myArray,myReal);}
+
+  private:
+    FFTInternalReal(const FFTInternalReal&);
+
+  private:
+    int myNX;
+    int myNY;
+    int myNZ;
+    double* myReal;
+    fftw_complex* myArray;
+    fftw_plan myPlanForward;
+    fftw_plan myPlanBackward;
+  };
+
+  FFTInternalReal::~FFTInternalReal(){
+    if(myPlanForward != NULL)
+      fftw_destroy_plan(myPlanForward);
+    if(myPlanBackward != NULL)
+      fftw_destroy_plan(myPlanBackward);     
+  }
+
+  void FFTInternalReal::initialize(int x, int y, int z,double* r,zomplex* a){
+    if(x == myNX && y == myNY && z == myNZ && myArray != NULL &&
+       fftw_alignment_of(r) == fftw_alignment_of(myReal) &&
+       fftw_alignment_of((double*)a) == fftw_alignment_of((double*)myArray)){
+      myReal = r;
+      myArray = (fftw_complex*)(a);
+      return;
+    }
+    Timer t;
+    t.start();
+    myNX = x;
+    myNY = y;
+    myNZ = z;
+    myReal = r;
+    myArray = (fftw_complex*)(a);
+    if(myPlanForward != NULL)
+      fftw_destroy_plan(myPlanForward);
+    if(myPlanBackward != NULL)
+      fftw_destroy_plan(myPlanBackward);
+    fftw3PlanThreads();
+    myPlanForward  = fftw_plan_dft_r2c_3d(myNX,myNY,myNZ,myReal,myArray,
+                                          FFTW_MEASURE);
+    myPlanBackward = fftw_plan_dft_c2r_3d(myNX,myNY,myNZ,myArray,myReal,
+                                          FFTW_MEASURE);
+    t.stop();
+    report << hint <<"FFTW3 real Initialization: "<<t.getTime()<<"."<<endr;
+  }
+
 #  else
 #     ifdef HAVE_FFT_ESSL
   //________________________________________________________________ FFTInternal
@@ -577,26 +655,51 @@ namespace ProtoMol {
 #  endif
 #endif
 
+#if !defined(HAVE_FFT_FFTW3)
+  //____________________________________________________________ FFTInternalReal
+  //
+  // Built-in real-to-complex, also for libraries without one
+  //
+  class FFTInternalReal : public FFTBuiltIn {};
+#endif
+
 
   //_______________________________________________________________ FFTComplex
-  FFTComplex::FFTComplex():myFFTInternal(NULL){
-    myFFTInternal = new FFTInternal();
+  FFTComplex::FFTComplex():
+    myFFTInternal(NULL),myFFTInternalReal(NULL),myRealToComplex(false){
   }
 
   FFTComplex::~FFTComplex(){
     delete myFFTInternal;
+    delete myFFTInternalReal;
   }
 
   void FFTComplex::initialize(int x, int y, int z,zomplex* a){
+    if(myFFTInternal == NULL)
+      myFFTInternal = new FFTInternal();
     myFFTInternal->initialize(x,y,z,a);
+    myRealToComplex = false;
+  }
+
+  void FFTComplex::initialize(int x, int y, int z,double* r,zomplex* a){
+    if(myFFTInternalReal == NULL)
+      myFFTInternalReal = new FFTInternalReal();
+    myFFTInternalReal->initialize(x,y,z,r,a);
+    myRealToComplex = true;
   }
 
   void FFTComplex::backward(){
-    myFFTInternal->backward();
+    if(myRealToComplex)
+      myFFTInternalReal->backward();
+    else if(myFFTInternal != NULL)
+      myFFTInternal->backward();
   }
 
   void FFTComplex::forward(){
-    myFFTInternal->forward();
+    if(myRealToComplex)
+      myFFTInternalReal->forward();
+    else if(myFFTInternal != NULL)
+      myFFTInternal->forward();
   }
 
 #if defined(HAVE_FFT_FFTW2_MPI)
@@ -16,16 +16,22 @@
 namespace ProtoMol {
 
   class FFTInternal;
+  class FFTInternalReal;
 
   //_________________________________________________________________ FFTComplex
   /**
    * Wrapper class for complex 3D FFT. Library specific calls and  
    * initialization are implemented in FFTInternal.@n
    *
+   * Real-to-complex transforms are implemented in FFTInternalReal, by FFTW3
+   * when available and by the built-in FFT otherwise. Both directions are
+   * unnormalized, a backward real transform may overwrite the complex
+   * array.@n
+   *
    * 1D and 2D: Overload method initialize()@n
    *
-   * Run-time selection: Make FFTInternal abstract and the implementation
-   * in local classes.
+   * The backends are selected at compile time, by the HAVE_FFT_* defines
+   * of the build. The FFTW3 backend (BUILD_FFTW3) is untested.
    */
   class FFTComplex {
 
@@ -43,6 +49,8 @@ namespace ProtoMol {
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   public:
     void initialize(int x, int y, int z, zomplex* a);
+    /// Real r (x*y*z) to complex a (x*y*(z/2+1)), the layout of FFTW3
+    void initialize(int x, int y, int z, double* r, zomplex* a);
     void backward();
     void forward();
 
@@ -58,6 +66,8 @@ namespace ProtoMol {
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   private:
     FFTInternal* myFFTInternal;
+    FFTInternalReal* myFFTInternalReal;
+    bool myRealToComplex;
   };
 }
 #endif /* FFTCOMPLEX_H */
@@ -8,6 +8,7 @@
 #include <algorithm>
 
 #include <protomol/parallel/Parallel.h>
+#include <protomol/parallel/DomainDecomposition.h>
 #include <protomol/type/ScalarStructure.h>
 #include <protomol/type/Vector3DBlock.h>
 #include <protomol/base/MathUtilities.h>
@@ -473,6 +474,8 @@ Parallel::WorkState Parallel::getWorkState() {
     return SEQUENTIAL;
   else if (myMode == ParallelType::STATIC)
     return STATIC;
+  else if (myMode == ParallelType::DOMAIN)
+    return SEQUENTIAL; // Work is split by the atoms owned by each node
   else if (iAmMaster() && myMode == ParallelType::DYNAMIC)
     return MASTER;
   else
@@ -712,7 +715,10 @@ void Parallel::reduce(ScalarStructure *energies, Vector3DBlock *coords) {
     return;
   TimerStatistic::timer[TimerStatistic::COMMUNICATION].start();
 
-  allReduce<false, true>(coords);
+  if (isDomain())
+    DomainDecomposition::reduce(coords);
+  else
+    allReduce<false, true>(coords);
   allReduce<false, false>(energies);
 
   TimerStatistic::timer[TimerStatistic::COMMUNICATION].stop();
@@ -71,7 +71,12 @@ namespace ProtoMol {
 
     static void setMode(ParallelType mode);
 
-    static bool isDynamic()            {return myMode != ParallelType::STATIC;}
+    static bool isDynamic()            {
+      return myMode == ParallelType::DYNAMIC ||
+        myMode == ParallelType::MASTERSLAVE;
+    }
+
+    static bool isDomain()             {return myMode == ParallelType::DOMAIN;}
 
     static int getPipeSize()           {return myPipeSize;}
 
@@ -22,6 +22,8 @@ namespace ProtoMol {
       DYNAMIC,         ///< Dynamic load balancing, similar to master-slave but
                        ///< with working master
       MASTERSLAVE,     ///< Master-slave
+      DOMAIN,          ///< Spatial domain decomposition, see
+                       ///< DomainDecomposition
       LAST             // Only internal purpose
     };
     static const std::string str[];
@@ -0,0 +1,72 @@
+#include <protomol/parallel/ThreadForceBuffers.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace ProtoMol;
+
+//____ ThreadForceBuffers
+
+int ThreadForceBuffers::getNumThreads() {
+#ifdef _OPENMP
+  return omp_in_parallel() ? 1 : omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+int ThreadForceBuffers::getThreadId() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+void ThreadForceBuffers::initialize(int threads, unsigned int atoms,
+                                    const ScalarStructure *energies) {
+  myForces.resize(threads);
+  myEnergies.resize(threads);
+
+  for (int t = 0; t < threads; t++) {
+    // Vector3DBlock::resize() only handles growing an empty block well
+    if (myForces[t].size() != atoms) {
+      Vector3DBlock tmp(atoms, Vector3D(0.0, 0.0, 0.0));
+      myForces[t].swap(tmp);
+    }
+
+    myEnergies[t].clear();
+    myEnergies[t].virial(energies->virial());
+    myEnergies[t].molecularVirial(energies->molecularVirial());
+  }
+
+  // One buffer per thread, such that each is cleared (first touched) by the
+  // thread using it
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) num_threads(threads)
+#endif
+  for (int t = 0; t < threads; t++)
+    myForces[t].zero();
+}
+
+void ThreadForceBuffers::reduce(Vector3DBlock *forces,
+                                ScalarStructure *energies) {
+  const int threads = size();
+  const int count = 3 * static_cast<int>(forces->size());
+  Real *f = forces->c;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
+  for (int i = 0; i < count; i++) {
+    Real sum = 0.0;
+    for (int t = 0; t < threads; t++)
+      sum += myForces[t].c[i];
+    f[i] += sum;
+  }
+
+  for (int t = 0; t < threads; t++)
+    energies->intoAdd(myEnergies[t]);
+}
@@ -0,0 +1,55 @@
+/*  -*- c++ -*-  */
+#ifndef THREADFORCEBUFFERS_H
+#define THREADFORCEBUFFERS_H
+
+#include <vector>
+
+#include <protomol/type/Vector3DBlock.h>
+#include <protomol/type/ScalarStructure.h>
+
+namespace ProtoMol {
+  //____ ThreadForceBuffers
+
+  /**
+   * Private force and energy accumulators of the threads of a shared memory
+   * (OpenMP) force evaluation. Each thread adds only into its own buffers,
+   * reduce() then sums them into the real forces and energies, each thread
+   * of the reduction owning a disjoint range of atoms, such that neither
+   * the evaluation nor the reduction needs any locks or atomics.
+   *
+   * Without OpenMP getNumThreads() is always 1 and the threaded paths of
+   * the forces are never taken.
+   */
+  class ThreadForceBuffers {
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class ThreadForceBuffers
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    /// Number of threads of a parallel region started now
+    static int getNumThreads();
+    /// Index of the calling thread inside a parallel region, 0 outside
+    static int getThreadId();
+
+    /**
+     * Prepares zeroed buffers of atoms forces for each of threads
+     * threads. The energy buffers take over the virial flags of energies.
+     */
+    void initialize(int threads, unsigned int atoms,
+                    const ScalarStructure *energies);
+
+    int size() const {return static_cast<int>(myForces.size());}
+    Vector3DBlock *forces(int thread) {return &myForces[thread];}
+    ScalarStructure *energies(int thread) {return &myEnergies[thread];}
+
+    /// Adds the buffers of all threads into forces and energies
+    void reduce(Vector3DBlock *forces, ScalarStructure *energies);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    std::vector<Vector3DBlock> myForces;
+    std::vector<ScalarStructure> myEnergies;
+  };
+}
+#endif /* THREADFORCEBUFFERS_H */
@@ -38,6 +38,11 @@ namespace ProtoMol {
 
     Real cutoff() const {return myCutoff;}
 
+    /// Coefficients of operator(), for vectorized copies of the switch
+    Real c15Cutoff_1() const {return my15Cutoff_1;}
+    Real c05Cutoff_3() const {return my05Cutoff_3;}
+    Real c15Cutoff_3() const {return my15Cutoff_3;}
+
     void operator()(Real &value, Real &derivOverD, Real distSquared) const {
       if (distSquared > myCutoff2) {
         value = 0.0;
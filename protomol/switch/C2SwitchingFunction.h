@@ -39,6 +39,15 @@ namespace ProtoMol {
 
     Real cutoff() const {return myCutoff;}
 
+    Real switchon() const {return mySwitchon;}
+
+    Real switchonSquared() const {return mySwitchon2;}
+
+    /// Coefficients of operator(), for vectorized copies of the switch
+    Real switch1() const {return mySwitch1;}
+    Real switch2() const {return mySwitch2;}
+    Real switch3() const {return mySwitch3;}
+
     void operator()(Real &value, Real &deriv, Real distSquared) const {
       deriv = 0.0;
       if (distSquared > myCutoff2)
@@ -131,6 +131,9 @@ namespace ProtoMol {
 			//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 		public:
 			void MaximumVolume( const float value );
+			float MaximumVolume() const {
+				return mMaxVolume;
+			}
 			void initialize( const Vector3D &max, Vector3D cellSize );
 			void updateCache();
 			void uncache() {
@@ -34,57 +34,16 @@ namespace ProtoMol {
   //add variables to store GBSA paramaters for each atom
   struct GBSAAtomParameters {
 
-    GBSAAtomParameters() {
-      bornRadiusDerivatives = NULL;
-      Lvalues = NULL;
-      Uvalues = NULL;
-      distij = NULL;
-      btDerv1 = NULL;
-      psiDerv1 = NULL;
-
-      fij = NULL;
-    }
-
-    ~GBSAAtomParameters() {
-
-      if (bornRadiusDerivatives != NULL) delete [] bornRadiusDerivatives;
-
-      if (Lvalues != NULL) delete [] Lvalues;
-      if (Uvalues != NULL) delete [] Uvalues;
-      if (distij != NULL) delete [] distij;
-      if (btDerv1 != NULL) delete [] btDerv1;
-      if (psiDerv1 != NULL) delete [] psiDerv1;
-
-      if (fij != NULL) delete [] fij;
-
-    }
-
-    void SetSpaceForBornRadiusDerivatives(int sz) {
-      if (bornRadiusDerivatives == NULL) {
-         bornRadiusDerivatives = new Real[sz];
-      }
-
-      btDerv1 = new Real[sz];
-      psiDerv1 = new Real[sz];
-
-      fij = new Real[sz];
-    }
-
-    void SetSpaceLvalues(int sz) {
-       Lvalues = new Real[sz];
-    }
-    void SetSpaceUvalues(int sz) {
-       Uvalues = new Real[sz];
-    }
-
-    void SetSpaceDistij(int sz) {
-       distij = new Real[sz];
-    }
-
     //Pre force initialization
     void preForce() {
       burialTerm = 0.0;
       doneCalculateBornRadius = false;
+      preForceKeepRadius();
+    }
+
+    //Pre force initialization keeping the burial term, Born radius and
+    //PsiValue of the last evaluation, for cached Born radii
+    void preForceKeepRadius() {
       //doSelfForceTerm = false;
       ACEPotential = 0.0;
       ACEPotentialCount = 0;
@@ -103,20 +62,9 @@ namespace ProtoMol {
 
     Real PsiValue;
 
-    //Need to define an array which will store the derivatives of born radius of atom
-    //i w.r.t. all j
-    Real *bornRadiusDerivatives;
-
-    Real *Lvalues;
-    Real *Uvalues;
-
-    Real *distij;
-
-    Real *btDerv1;
-
-    Real *psiDerv1;
-
-    Real *fij;
+    //The pair terms (L_ij, U_ij, r_ij, f_ij and the derivatives of the Born
+    //radii) are recomputed by the forces that need them, so the parameters
+    //of an atom do not grow with the number of atoms.
 
     //Defining a flag which will be false if Born Radius value has not been calculated
     //from the burialTerm/PsiValue. It will be set to true first time Born Radius is
@@ -131,7 +79,6 @@ namespace ProtoMol {
     // force needs to be computed.
     bool havePartialGBForceTerms;
     Real partialGBForceTerms;
-    std::vector<Real> partialTerm, expTerm, filTerm;
     
     //the same for the Hessian calculations
     bool havePartialGBHessianTerms;
@@ -854,26 +854,6 @@ void ProtoMol::buildTopology(GenericTopology *topo, const PSF &psf,
        tempatom->myGBSA_T->scalingFactor = 0.8;
     }
 
-    //allocate the array to store derivatives of born radius w.r.t. r_{ij}'s
-    if (tempatom->myGBSA_T->bornRadiusDerivatives == NULL) {
-        tempatom->myGBSA_T->SetSpaceForBornRadiusDerivatives(atomsSize);
-    }
-
-    if (tempatom->myGBSA_T->Lvalues == NULL) {
-        tempatom->myGBSA_T->SetSpaceLvalues(atomsSize);
-    }
-    if (tempatom->myGBSA_T->Uvalues == NULL) {
-        tempatom->myGBSA_T->SetSpaceUvalues(atomsSize);
-    }
-
-    if (tempatom->myGBSA_T->distij == NULL) {
-       tempatom->myGBSA_T->SetSpaceDistij(atomsSize);
-    }
-    
-    tempatom->myGBSA_T->expTerm.resize( atomsSize );
-    tempatom->myGBSA_T->filTerm.resize( atomsSize );
-    tempatom->myGBSA_T->partialTerm.resize( atomsSize );
-
     // Van der Waal Radii can differ for two atoms of the same type. As part
     // of an incremental fix, we've created a new field in Atom for use with GB.
     // We are not removing the field in AtomType until SCPISM has been fixed to
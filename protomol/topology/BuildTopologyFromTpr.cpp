@@ -916,23 +916,6 @@ void ProtoMol::buildTopologyFromTpr(GenericTopology *topo, Vector3DBlock &pos,
       case 'S': tempatom->myGBSA_T->scalingFactor = 0.96; break;
       default:  tempatom->myGBSA_T->scalingFactor = 0.80; break;
       }
-
-      // allocate the array to store derivatives of born radius w.r.t. r_{ij}'s
-      if (!tempatom->myGBSA_T->bornRadiusDerivatives)
-        tempatom->myGBSA_T->SetSpaceForBornRadiusDerivatives(atomsSize);
-
-      if (!tempatom->myGBSA_T->Lvalues)
-        tempatom->myGBSA_T->SetSpaceLvalues(atomsSize);
-
-      if (!tempatom->myGBSA_T->Uvalues)
-        tempatom->myGBSA_T->SetSpaceUvalues(atomsSize);
-
-      if (!tempatom->myGBSA_T->distij)
-        tempatom->myGBSA_T->SetSpaceDistij(atomsSize);
-
-      tempatom->myGBSA_T->expTerm.resize( atomsSize );
-      tempatom->myGBSA_T->filTerm.resize( atomsSize );
-      tempatom->myGBSA_T->partialTerm.resize( atomsSize );
     }
   }
 
@@ -1,9 +1,11 @@
 #include <protomol/topology/GenericTopology.h>
 
 #include <protomol/base/Exception.h>
+#include <protomol/base/Report.h>
 
 using namespace std;
 using namespace ProtoMol;
+using namespace ProtoMol::Report;
 
 //____ GenericTopology
 
@@ -14,7 +16,7 @@ GenericTopology::GenericTopology() :
   exclude(ExclusionType::ONE4MODIFIED), coulombScalingFactor(1.0), time(0.0),
   min(Vector3D(Constant::MAXREAL, Constant::MAXREAL, Constant::MAXREAL)),
   max(Vector3D(-Constant::MINREAL, -Constant::MINREAL, -Constant ::MINREAL)),
-  implicitSolvent(NONE), doSCPISM(0), forceFieldFlag(CHARMM), 
+  positionsSoASource(NULL), positionsSoAVersion(0), positionsVersion(0), implicitSolvent(NONE), doSCPISM(0), forceFieldFlag(CHARMM), 
   minimalMolecularDistances(false), doGBSAOpenMM(0), obcType(0),
   dielecOffset(0), alphaObc(0), betaObc(0), gammaObc(0) {}
 
@@ -22,7 +24,7 @@ GenericTopology::GenericTopology(Real c, const ExclusionType &e) :
   exclude(e), coulombScalingFactor(c), time(0.0),
   min(Vector3D(Constant::MAXREAL, Constant::MAXREAL, Constant::MAXREAL)),
   max(Vector3D(-Constant::MINREAL, -Constant::MINREAL, -Constant::MINREAL)),
-  implicitSolvent(NONE), doSCPISM(0), forceFieldFlag(CHARMM), 
+  positionsSoASource(NULL), positionsSoAVersion(0), positionsVersion(0), implicitSolvent(NONE), doSCPISM(0), forceFieldFlag(CHARMM), 
   minimalMolecularDistances(false), doGBSAOpenMM(0), obcType(0),
   dielecOffset(0), alphaObc(0), betaObc(0), gammaObc(0) {}
 
@@ -32,3 +34,8 @@ GenericTopology *GenericTopology::make(const vector<Value> &values) const {
   return adjustAlias(doMake(values));
 }
 
+void GenericTopology::missingDomainAtom(int atom) const {
+  report << error << "Bonded term of atom " << atom << " reaches beyond the "
+         << "halo of the domain decomposition, increase the cell size."
+         << endr;
+}
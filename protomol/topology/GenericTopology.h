@@ -10,6 +10,7 @@
 #include <protomol/topology/ExclusionTable.h>
 #include <protomol/topology/ExclusionType.h>
 #include <protomol/type/Vector3DBlock.h>
+#include <protomol/type/Vector3DBlockSoA.h>
 #include <protomol/base/Makeable.h>
 #include <protomol/topology/Molecule.h>
 #include <protomol/base/Zap.h>
@@ -20,6 +21,17 @@
 #include <protomol/topology/BankLennardJonesParameterTable.h>
 
 namespace ProtoMol {
+  //________________________________________ CachedPairList
+
+  /**
+   * Base of the pair lists owned by a topology and shared by the forces of
+   * all force groups and MTS levels (see GenericTopology::pairLists).
+   */
+  class CachedPairList {
+  public:
+    virtual ~CachedPairList() {}
+  };
+
   //________________________________________ GenericTopology
 
   /**
@@ -77,6 +89,8 @@ namespace ProtoMol {
         for (unsigned int i = 0; i < atomTypes.size(); i++)
           zap(atomTypes[i].mySCPISM_T);
       }
+      for (unsigned int i = 0; i < pairLists.size(); i++)
+        delete pairLists[i];
     };
 
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -103,6 +117,8 @@ namespace ProtoMol {
     /// returns the bounding box of the boundary conditions
     virtual void getBoundaryConditionsBox(Vector3D &min,
                                           Vector3D &max) const = 0;
+    /// if the boundary conditions are periodic
+    virtual bool isPeriodic() const = 0;
 
     /// Perform a minimal-image subtraction.
     virtual Vector3D minimalDifference(const Vector3D &c1,
@@ -127,10 +143,88 @@ namespace ProtoMol {
 
     virtual std::string print(const Vector3DBlock *positions = NULL) const = 0;
 
+    /**
+     * converts the positions into the structure-of-arrays copy, unless the
+     * copy is of the same positions and of the current positionsVersion.
+     * Writes the (mutable) copy, so it is to be called outside of parallel
+     * regions; ForceGroup does before the forces of each evaluation.
+     */
+    void updatePositionsSoA(const Vector3DBlock *positions) const {
+      if (positionsSoASource != positions ||
+          positionsSoAVersion != positionsVersion ||
+          positionsSoA.size() != positions->size()) {
+        positionsSoA.intoAssign(*positions);
+        positionsSoASource = positions;
+        positionsSoAVersion = positionsVersion;
+      }
+    }
+
+    /// returns the structure-of-arrays copy of the positions, see
+    /// updatePositionsSoA(), with the same restriction
+    const Vector3DBlockSoA &getPositionsSoA(const Vector3DBlock *positions)
+    const {
+      updatePositionsSoA(positions);
+      return positionsSoA;
+    }
+
+    /**
+     * to be called by code writing positions in place: increments
+     * positionsVersion, such that the structure-of-arrays copy and the
+     * pair list checks see the change. uncacheCellList() includes it, so
+     * positions written before a ForceGroup evaluation are seen anyway.
+     */
+    void uncachePositionsSoA() const {++positionsVersion;}
+
+    /**
+     * cell layers along x of the given atoms as used by the cell lists and
+     * the number of layers, for the spatial domain decomposition of
+     * periodic systems (see DomainDecomposition)
+     */
+    virtual int getCellLayers(const Vector3DBlock &positions,
+                              const std::vector<int> &atomList,
+                              std::vector<int> &layers) const = 0;
+
+    /**
+     * all pairs (i < j) of atoms within cutoff, sorted, enumerated by the
+     * cell lists in O(N) for the users outside of the templated forces
+     * (e.g. Hessian). Exclusions are not checked.
+     */
+    virtual void getCutoffPairs(const Vector3DBlock &positions, Real cutoff,
+                                std::vector<PairInt> &pairs) const = 0;
+
+    /// if the atoms are distributed by a spatial domain decomposition
+    bool isDecomposed() const {return !domainAtoms.empty();}
+
+    /// atom is owned by this node, always true without decomposition
+    bool isOwnedAtom(int atom) const {
+      return domainAtoms.empty() || domainAtoms[atom] == DOMAIN_OWNED;
+    }
+
+    /// atom is owned by this node or a halo copy
+    bool isDomainAtom(int atom) const {
+      return domainAtoms.empty() || domainAtoms[atom] != DOMAIN_ABSENT;
+    }
+
+    /**
+     * if a bonded term is evaluated by this node, i.e., its first atom is
+     * owned; the other atoms of the term must be present as halo atoms
+     */
+    bool isOwnedTerm(int a1, int a2, int a3 = -1, int a4 = -1) const {
+      if (domainAtoms.empty()) return true;
+      if (domainAtoms[a1] != DOMAIN_OWNED) return false;
+      if (!isDomainAtom(a2) || (a3 >= 0 && !isDomainAtom(a3)) ||
+          (a4 >= 0 && !isDomainAtom(a4)))
+        missingDomainAtom(a1);
+      return true;
+    }
+
     GenericTopology *make(const std::vector<Value> &values) const;
 
     static const std::string &getKeyword() {return keyword;}
 
+  private:
+    void missingDomainAtom(int atom) const;
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // From class Makable
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -169,6 +263,29 @@ namespace ProtoMol {
     mutable Vector3D min;
     mutable Vector3D max;
 
+    /// structure-of-arrays copy of the positions, see updatePositionsSoA()
+    mutable Vector3DBlockSoA positionsSoA;
+    /// positions positionsSoA was converted from and their version
+    mutable const Vector3DBlock *positionsSoASource;
+    mutable unsigned int positionsSoAVersion;
+    /// incremented by uncachePositionsSoA(), i.e., whenever positions are
+    /// written and before each force evaluation, positions of the same
+    /// version are unchanged
+    mutable unsigned int positionsVersion;
+
+    /// pair lists shared by the forces, owned by the topology
+    mutable std::vector<CachedPairList *> pairLists;
+
+    /// state of an atom on this node with spatial domain decomposition
+    enum DomainAtom {
+      DOMAIN_ABSENT = 0,  ///< atom is owned by an other node
+      DOMAIN_HALO,        ///< copy of an atom of a neighbor node
+      DOMAIN_OWNED        ///< atom is evaluated and integrated by this node
+    };
+    /// DomainAtom of each atom, empty if the atoms are not decomposed. Only
+    /// atoms present on this node are put into the cell lists.
+    std::vector<char> domainAtoms;
+
     static const std::string scope;
     static const std::string keyword;
 
@@ -109,6 +109,42 @@ namespace ProtoMol {
       return diff;
     }
 
+    /**
+     * Minimal differences of c1 to the n positions (x[j[k]], y[j[k]],
+     * z[j[k]]) and their squared distances, in structure-of-arrays layout.
+     * Orthorhombic boxes take a branch-free path over k, the general
+     * (triclinic) case the one of minimalDifference().
+     */
+    void minimalDifferences(const Vector3D &c1, const Real *x, const Real *y,
+                            const Real *z, const int *j, unsigned int n,
+                            Real *dx, Real *dy, Real *dz,
+                            Real *distSquared) const {
+      if (myOrthogonal) {
+        const Real hx = myE1.c[0], hy = myE2.c[1], hz = myE3.c[2];
+        const Real rx = myE1r.c[0], ry = myE2r.c[1], rz = myE3r.c[2];
+        for (unsigned int k = 0; k < n; k++) {
+          Real ddx = x[j[k]] - c1.c[0];
+          Real ddy = y[j[k]] - c1.c[1];
+          Real ddz = z[j[k]] - c1.c[2];
+          ddx -= hx * nearestImage(rx * ddx);
+          ddy -= hy * nearestImage(ry * ddy);
+          ddz -= hz * nearestImage(rz * ddz);
+          dx[k] = ddx;
+          dy[k] = ddy;
+          dz[k] = ddz;
+          distSquared[k] = ddx * ddx + ddy * ddy + ddz * ddz;
+        }
+      } else
+        for (unsigned int k = 0; k < n; k++) {
+          Vector3D diff(minimalDifference(c1, Vector3D(x[j[k]], y[j[k]],
+                                                       z[j[k]]),
+                                          distSquared[k]));
+          dx[k] = diff.c[0];
+          dy[k] = diff.c[1];
+          dz[k] = diff.c[2];
+        }
+    }
+
     /// Find the position in the basis/original cell/image.
     Vector3D minimalPosition(const Vector3D &c) const {
       Vector3D diff(c);
@@ -220,6 +256,18 @@ namespace ProtoMol {
     /// Returns possible default values for the parameters based on the
     /// positions
     std::vector<Parameter> getDefaults(const Vector3DBlock &positions) const;
+
+  private:
+    /**
+     * s rounded to the nearest integer, as in the general case of
+     * minimalDifference(). Its wrap threshold needs no test here: below
+     * myD, i.e., (h/2)^2 of the shortest side, every |s| <= 1/2 and rounds
+     * to 0, such that both give the same image (up to the sign of exact
+     * half box ties beyond the first wrap). rint works on the Real value
+     * and does not overflow like a cast to int.
+     */
+    static Real nearestImage(Real s) {return rint(s);}
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // My data members
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
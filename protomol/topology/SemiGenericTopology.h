@@ -99,6 +99,8 @@ namespace ProtoMol {
       maxbb = boundaryConditions.getMax();
     }
 
+    virtual bool isPeriodic() const {return boundaryConditions.PERIODIC;}
+
     /**
      * checks whether the plain distances between all atoms on each molecule are
      * the same as with applying the boundary conditions. If true, there is no 
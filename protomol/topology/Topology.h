@@ -7,6 +7,9 @@
 #include <protomol/base/StringUtilities.h>
 #include <protomol/base/PMConstants.h>
 #include <protomol/base/Exception.h>
+#include <protomol/base/Report.h>
+
+#include <algorithm>
 
 namespace ProtoMol {
 	/**
@@ -23,26 +26,39 @@ namespace ProtoMol {
 			// Constructors, destructors, assignment
 			//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 		public:
-			Topology() : SemiGenericTopology<TBoundaryConditions>() {}
+			Topology() : SemiGenericTopology<TBoundaryConditions>(),
+				movableCellLists( false ) {}
 			Topology( Real csf, const ExclusionType &e, const TBoundaryConditions &b,
 					  const TCellManager &c, const float maxCellVolume ) : SemiGenericTopology<TBoundaryConditions>(
-							  csf, e, b ), cellManager( c ) {
+							  csf, e, b ), cellManager( c ), movableCellLists( false ) {
 				cellLists.MaximumVolume( maxCellVolume );
 			}
 
 			virtual ~Topology() {};
-			/// marks the the cell list as not valid any more.
+			/// marks the the cell list and the structure-of-arrays positions as
+			/// not valid any more.
 			virtual void uncacheCellList() {
 				cellLists.uncache();
+				this->uncachePositionsSoA();
 			}
 
 			//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 			// New methods of class Topology
 			//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 		public:
-			/// invokes an update of the cell list, if necessary
+			/**
+			 * invokes an update of the cell list, if necessary. With periodic
+			 * boundary conditions and an unchanged box only the atoms which
+			 * crossed a cell boundary since the last update are moved, see
+			 * moveCellLists().
+			 */
 			void updateCellLists( const Vector3DBlock *positions ) const {
 				if( !cellLists.valid ) {
+					if( canMoveCellLists( positions ) ) {
+						moveCellLists( positions );
+						return;
+					}
+
 					if( this->boundaryConditions.PERIODIC ) {
 						this->min = this->boundaryConditions.getMin();
 						this->max = this->boundaryConditions.getMax();
@@ -64,10 +80,20 @@ namespace ProtoMol {
 					CubicCellManager::CellListStructure::iterator myCellList;
 					CubicCellManager::CellListStructure::iterator end = cellLists.end();
 
+					atomCells.resize( this->atoms.size() );
+					cellListPrevious.resize( this->atoms.size() );
+
 					for( int i = ( int )this->atoms.size() - 1; i >= 0; i-- ) {
+						// Atoms of other nodes with domain decomposition
+						if( !this->isDomainAtom( i ) ) {
+							continue;
+						}
+
 						myCell =
 							cellManager.findCell( delta +
 												  this->boundaryConditions.minimalPosition( ( *positions )[i] ) );
+						atomCells[i] = myCell;
+						cellListPrevious[i] = -1;
 
 						myCellList = cellLists.find( myCell );
 						if( myCellList == end ) {
@@ -76,15 +102,156 @@ namespace ProtoMol {
 							this->atoms[i].cellListNext = -1;
 							cellLists[myCell] = i;
 						} else {
+							cellListPrevious[myCellList->second] = i;
 							this->atoms[i].cellListNext = myCellList->second;
 							myCellList->second = i;
 						}
 					}
 
 					cellManager.updateCache( cellLists );
+					movableCellLists = this->boundaryConditions.PERIODIC &&
+						!this->isDecomposed();
 				}
 			}
 
+		private:
+			/// if the cell lists of the last update can be updated by moving
+			/// atoms, i.e., the cells and the atoms are the same
+			bool canMoveCellLists( const Vector3DBlock *positions ) const {
+				return movableCellLists && !this->isDecomposed() &&
+					atomCells.size() == this->atoms.size() &&
+					positions->size() == this->atoms.size() &&
+					this->min == this->boundaryConditions.getMin() &&
+					this->max == this->boundaryConditions.getMax();
+			}
+
+			/**
+			 * incremental update of the cell lists, only atoms which changed
+			 * their cell are unlinked and inserted into their new cell. Each
+			 * list is kept sorted by atom index as built by updateCellLists(),
+			 * such that the pairs are enumerated in the same order.
+			 */
+			void moveCellLists( const Vector3DBlock *positions ) const {
+				const Vector3D delta( this->boundaryConditions.origin() - this->min );
+				bool occupancy = false;
+
+				for( int i = 0; i < ( int )this->atoms.size(); i++ ) {
+					CubicCellManager::Cell myCell =
+						cellManager.findCell( delta +
+											  this->boundaryConditions.minimalPosition( ( *positions )[i] ) );
+					if( myCell == atomCells[i] ) {
+						continue;
+					}
+
+					// Unlink from the old cell
+					int previous = cellListPrevious[i];
+					int next = this->atoms[i].cellListNext;
+					if( previous >= 0 ) {
+						this->atoms[previous].cellListNext = next;
+					} else {
+						cellLists[atomCells[i]] = next;
+						occupancy = occupancy || next < 0;
+					}
+					if( next >= 0 ) {
+						cellListPrevious[next] = previous;
+					}
+
+					// Insert into the new cell behind the atoms of lower index
+					int &head = cellLists[myCell];
+					if( head < 0 || head > i ) {
+						occupancy = occupancy || head < 0;
+						this->atoms[i].cellListNext = head;
+						cellListPrevious[i] = -1;
+						if( head >= 0 ) {
+							cellListPrevious[head] = i;
+						}
+						head = i;
+					} else {
+						int j = head;
+						while( this->atoms[j].cellListNext >= 0 &&
+							   this->atoms[j].cellListNext < i ) {
+							j = this->atoms[j].cellListNext;
+						}
+						next = this->atoms[j].cellListNext;
+						this->atoms[i].cellListNext = next;
+						cellListPrevious[i] = j;
+						this->atoms[j].cellListNext = i;
+						if( next >= 0 ) {
+							cellListPrevious[next] = i;
+						}
+					}
+					atomCells[i] = myCell;
+				}
+
+				// The range of occupied cells only changes with a cell getting
+				// empty or occupied
+				if( occupancy ) {
+					cellManager.updateCache( cellLists );
+				} else {
+					cellLists.valid = true;
+				}
+			}
+
+		public:
+
+			virtual int getCellLayers( const Vector3DBlock &positions,
+									   const std::vector<int> &atomList,
+									   std::vector<int> &layers ) const {
+				if( !this->boundaryConditions.PERIODIC ) {
+					Report::report << Report::error << "Domain decomposition requires "
+								   << "periodic boundary conditions." << Report::endr;
+				}
+
+				if( !cellLists.valid ) {
+					this->min = this->boundaryConditions.getMin();
+					this->max = this->boundaryConditions.getMax();
+					cellManager.initialize( cellLists, this->min, this->max, true );
+					movableCellLists = false;
+				}
+
+				// Same mapping as updateCellLists()
+				const Vector3D delta( this->boundaryConditions.origin() - this->min );
+				const int n = cellLists.getDimX();
+
+				layers.resize( atomList.size() );
+				for( unsigned int i = 0; i < atomList.size(); i++ ) {
+					int x = cellManager.findCell( delta +
+												  this->boundaryConditions.minimalPosition( positions[atomList[i]] ) ).x;
+					layers[i] = ( x % n + n ) % n;
+				}
+
+				return n;
+			}
+
+			virtual void getCutoffPairs( const Vector3DBlock &positions, Real cutoff,
+										 std::vector<PairInt> &pairs ) const {
+				updateCellLists( &positions );
+				Enumerator enumerator;
+				enumerator.initialize( this, cutoff );
+
+				const Real cutoffSquared = cutoff * cutoff;
+				pairs.clear();
+				CellPair thisPair;
+				for( ; !enumerator.done(); enumerator.next() ) {
+					enumerator.get( thisPair );
+					bool notSameCell = enumerator.notSameCell();
+
+					for( int i = thisPair.first; i != -1; i = this->atoms[i].cellListNext ) {
+						for( int j = ( notSameCell ? thisPair.second : this->atoms[i].cellListNext );
+							 j != -1; j = this->atoms[j].cellListNext ) {
+							Real distSquared;
+							this->boundaryConditions.minimalDifference( positions[i], positions[j],
+																		distSquared );
+							if( distSquared <= cutoffSquared ) {
+								pairs.push_back( i < j ? PairInt( i, j ) : PairInt( j, i ) );
+							}
+						}
+					}
+				}
+
+				std::sort( pairs.begin(), pairs.end() );
+			}
+
 			//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 			// From Makeable
 			//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -240,6 +407,13 @@ namespace ProtoMol {
 		public:
 			CellManager cellManager;
 			mutable typename CellManager::CellListStructure cellLists;
+
+		private:
+			/// cell of each atom and the backward links of the cell lists, for
+			/// the incremental update (moveCellLists())
+			mutable std::vector<typename CellManager::Cell> atomCells;
+			mutable std::vector<int> cellListPrevious;
+			mutable bool movableCellLists;
 	};
 }
 #endif /* TOPOLOGY_H */
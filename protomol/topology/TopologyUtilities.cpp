@@ -8,6 +8,7 @@
 #include <protomol/base/PMConstants.h>
 #include <protomol/base/StringUtilities.h>
 #include <protomol/type/ScalarStructure.h>
+#include <protomol/type/SimpleTypes.h>
 
 #include <vector>
 #include <algorithm>
@@ -1220,4 +1221,136 @@ namespace ProtoMol {
 
     return;
   }
+
+//____hilbertIndex
+  unsigned int hilbertIndex(unsigned int x, unsigned int y, unsigned int z,
+                            unsigned int bits) {
+    // J. Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707
+    // (2004): transform the coordinates in place, then interleave the bits
+    unsigned int X[3] = {x, y, z};
+    const unsigned int M = 1u << (bits - 1);
+
+    // Inverse undo
+    for (unsigned int Q = M; Q > 1; Q >>= 1) {
+      unsigned int P = Q - 1;
+      for (unsigned int i = 0; i < 3; i++)
+        if (X[i] & Q)
+          X[0] ^= P;
+        else {
+          unsigned int t = (X[0] ^ X[i]) & P;
+          X[0] ^= t;
+          X[i] ^= t;
+        }
+    }
+
+    // Gray encode
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    unsigned int t = 0;
+    for (unsigned int Q = M; Q > 1; Q >>= 1)
+      if (X[2] & Q)
+        t ^= Q - 1;
+    for (unsigned int i = 0; i < 3; i++)
+      X[i] ^= t;
+
+    unsigned int index = 0;
+    for (int b = bits - 1; b >= 0; b--)
+      for (unsigned int i = 0; i < 3; i++)
+        index = (index << 1) | ((X[i] >> b) & 1);
+    return index;
+  }
+
+//____spatialOrder
+  void spatialOrder(const GenericTopology *topo,
+                    const Vector3DBlock *positions,
+                    vector<int> &order) {
+    const unsigned int bits = 10;
+    const unsigned int cells = 1u << bits;
+    const unsigned int count = positions->size();
+
+    // Bounding box of the minimal image positions
+    vector<Vector3D> minimal(count);
+    Vector3D min(Constant::MAXREAL, Constant::MAXREAL, Constant::MAXREAL);
+    Vector3D max(-Constant::MAXREAL, -Constant::MAXREAL, -Constant::MAXREAL);
+    for (unsigned int i = 0; i < count; i++) {
+      minimal[i] = topo->minimalPosition((*positions)[i]);
+      for (unsigned int k = 0; k < 3; k++) {
+        if (minimal[i].c[k] < min.c[k]) min.c[k] = minimal[i].c[k];
+        if (minimal[i].c[k] > max.c[k]) max.c[k] = minimal[i].c[k];
+      }
+    }
+    Vector3D scale(max - min);
+    for (unsigned int k = 0; k < 3; k++)
+      scale.c[k] = (scale.c[k] > 0.0 ? (cells - 1) / scale.c[k] : 0.0);
+
+    vector<PairUInt> keys(count);
+    for (unsigned int i = 0; i < count; i++) {
+      Vector3D p(minimal[i] - min);
+      unsigned int c[3];
+      for (unsigned int k = 0; k < 3; k++) {
+        Real v = p.c[k] * scale.c[k];
+        c[k] = (v <= 0.0 ? 0 :
+                (v >= cells - 1 ? cells - 1 : static_cast<unsigned int>(v)));
+      }
+      keys[i] = PairUInt(hilbertIndex(c[0], c[1], c[2], bits), i);
+    }
+    sort(keys.begin(), keys.end());
+
+    order.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+      order[i] = keys[i].second;
+  }
+
+  //____bondedSpan
+  static Real pathLength(const GenericTopology *topo,
+                         const Vector3DBlock *positions,
+                         int a1, int a2, int a3 = -1, int a4 = -1) {
+    Real length = topo->minimalDifference((*positions)[a1],
+                                          (*positions)[a2]).norm();
+    if (a3 >= 0)
+      length += topo->minimalDifference((*positions)[a2],
+                                        (*positions)[a3]).norm();
+    if (a4 >= 0)
+      length += topo->minimalDifference((*positions)[a3],
+                                        (*positions)[a4]).norm();
+    return length;
+  }
+
+  Real bondedSpan(const GenericTopology *topo, const Vector3DBlock *positions,
+                  const vector<Bond> &terms) {
+    Real span = 0.0;
+    for (unsigned int i = 0; i < terms.size(); i++)
+      span = max(span, pathLength(topo, positions, terms[i].atom1,
+                                  terms[i].atom2));
+    return span;
+  }
+
+  Real bondedSpan(const GenericTopology *topo, const Vector3DBlock *positions,
+                  const vector<Angle> &terms) {
+    Real span = 0.0;
+    for (unsigned int i = 0; i < terms.size(); i++)
+      span = max(span, pathLength(topo, positions, terms[i].atom1,
+                                  terms[i].atom2, terms[i].atom3));
+    return span;
+  }
+
+  Real bondedSpan(const GenericTopology *topo, const Vector3DBlock *positions,
+                  const vector<Torsion> &terms) {
+    Real span = 0.0;
+    for (unsigned int i = 0; i < terms.size(); i++)
+      span = max(span, pathLength(topo, positions, terms[i].atom1,
+                                  terms[i].atom2, terms[i].atom3,
+                                  terms[i].atom4));
+    return span;
+  }
+
+  Real bondedSpan(const GenericTopology *topo, const Vector3DBlock *positions,
+                  const vector<RBTorsion> &terms) {
+    Real span = 0.0;
+    for (unsigned int i = 0; i < terms.size(); i++)
+      span = max(span, pathLength(topo, positions, terms[i].atom1,
+                                  terms[i].atom2, terms[i].atom3,
+                                  terms[i].atom4));
+    return span;
+  }
 }
@@ -10,6 +10,8 @@
 #include <protomol/type/Stack.h>
 #include <protomol/topology/AngleInfo.h>
 #include <protomol/topology/Bond.h>
+#include <protomol/topology/Angle.h>
+#include <protomol/topology/RBTorsion.h>
 
 #include <string>
 #include <vector>
@@ -251,6 +253,39 @@ namespace ProtoMol {
   Real computePhiDihedralEnergy(const GenericTopology *topo,
                                 int index,
                                 Real phi);
+
+  //________________________________________hilbertIndex
+  /// Position of the cell (x, y, z) along the 3D Hilbert curve through a
+  /// grid of 2^bits cells per side, bits <= 10
+  unsigned int hilbertIndex(unsigned int x, unsigned int y, unsigned int z,
+                            unsigned int bits);
+
+  //________________________________________spatialOrder
+  /**
+   * Orders the atoms along a Hilbert curve through the bounding box of
+   * their minimal image positions, such that atoms next to each other in
+   * order are close in space. order[k] is the index of the k-th atom; the
+   * atoms themselves are not moved.
+   */
+  void spatialOrder(const GenericTopology *topo,
+                    const Vector3DBlock *positions,
+                    std::vector<int> &order);
+
+  //________________________________________bondedSpan
+  /**
+   * Largest length of the path through the atoms of the terms, atom 1 to
+   * atom 2 to atom 3 and so on. It bounds the distance of the first atom of
+   * a term to its other atoms independent of the conformation, for the halo
+   * of the spatial domain decomposition (see DomainDecomposition).
+   */
+  Real bondedSpan(const GenericTopology *topo, const Vector3DBlock *positions,
+                  const std::vector<Bond> &terms);
+  Real bondedSpan(const GenericTopology *topo, const Vector3DBlock *positions,
+                  const std::vector<Angle> &terms);
+  Real bondedSpan(const GenericTopology *topo, const Vector3DBlock *positions,
+                  const std::vector<Torsion> &terms);
+  Real bondedSpan(const GenericTopology *topo, const Vector3DBlock *positions,
+                  const std::vector<RBTorsion> &terms);
 }
 
 #endif // TOPOLOGYUTILITIES_H
@@ -36,6 +36,23 @@ namespace ProtoMol {
       distSquared = diff.normSquared();
       return diff;
     }
+    /// Minimal differences of c1 to the n positions (x[j[k]], y[j[k]],
+    /// z[j[k]]) and their squared distances, in structure-of-arrays layout
+    void minimalDifferences(const Vector3D &c1, const Real *x, const Real *y,
+                            const Real *z, const int *j, unsigned int n,
+                            Real *dx, Real *dy, Real *dz,
+                            Real *distSquared) const {
+      for (unsigned int k = 0; k < n; k++) {
+        const Real ddx = x[j[k]] - c1.c[0];
+        const Real ddy = y[j[k]] - c1.c[1];
+        const Real ddz = z[j[k]] - c1.c[2];
+        dx[k] = ddx;
+        dy[k] = ddy;
+        dz[k] = ddz;
+        distSquared[k] = ddx * ddx + ddy * ddy + ddz * ddz;
+      }
+    }
+
     /// Find the position in the basis/original cell/image.
     Vector3D minimalPosition(const Vector3D &c) const {return c;}
     /// Find the lattice vector difference between two positions
@@ -0,0 +1,259 @@
+/* -*- c++ -*- */
+#ifndef VERLETLIST_H
+#define VERLETLIST_H
+
+#include <protomol/topology/Topology.h>
+#include <protomol/topology/TopologyUtilities.h>
+#include <protomol/type/Vector3DBlock.h>
+#include <protomol/type/Vector3DBlockSoA.h>
+#include <protomol/type/SimpleTypes.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace ProtoMol {
+  //____ VerletList
+
+  /**
+   * Persistent Verlet neighbor list with a skin buffer. The candidate pairs
+   * within cutoff + skin are collected once from the cell lists and stored
+   * per atom (compressed row storage). The list is only rebuilt when an
+   * atom has moved more than half the skin since the last build, or the
+   * cutoff, box or number of atoms changed.
+   *
+   * The rows are kept in Hilbert curve order of the atoms (see
+   * spatialOrder()), row k belongs to atom(k) and its neighbors are sorted
+   * by index. Traversing the rows in order touches the positions and forces
+   * of spatially close atoms one after the other, the atom numbering itself
+   * is left unchanged.
+   *
+   * The exclusions are compiled into the list: fully excluded pairs are
+   * dropped and the modified (scaled 1-4) pairs are kept in rows of their
+   * own (beginModified()/endModified()), such that the force kernels never
+   * look up the exclusion table.
+   *
+   * Lists obtained by shared() are owned by the topology and shared by all
+   * forces of the same cutoff and skin, also across force groups and MTS
+   * levels, such that only one list is built and checked per positions.
+   */
+  template<class TBoundaryConditions, class TCellManager>
+  class VerletList : public CachedPairList {
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Typedef
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    typedef Topology<TBoundaryConditions, TCellManager> RealTopologyType;
+    typedef typename RealTopologyType::Enumerator EnumeratorType;
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    VerletList() : myNeighbors(1, -1), myModified(1, -1), myCutoff(-1.0),
+      mySkin(0.0), myValid(false), myBuilds(0), myPositions(NULL),
+      myVersion(0) {}
+
+    VerletList(Real cutoff, Real skin) : myNeighbors(1, -1),
+      myModified(1, -1), myCutoff(cutoff), mySkin(skin), myValid(false),
+      myBuilds(0), myPositions(NULL), myVersion(0) {}
+
+    /// The list of topo for cutoff and skin, created on first use
+    static VerletList &shared(const RealTopologyType *topo, Real cutoff,
+                              Real skin) {
+      for (unsigned int i = 0; i < topo->pairLists.size(); ++i) {
+        VerletList *list = dynamic_cast<VerletList *>(topo->pairLists[i]);
+        if (list != NULL && list->myCutoff == cutoff && list->mySkin == skin)
+          return *list;
+      }
+      VerletList *list = new VerletList(cutoff, skin);
+      topo->pairLists.push_back(list);
+      return *list;
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class VerletList
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    /// Rebuilds the list if necessary, returns true if it was rebuilt.
+    /// The check is skipped if the positions are of the same version as
+    /// at the last update (see GenericTopology::positionsVersion).
+    bool update(const RealTopologyType *topo, const Vector3DBlock *positions,
+                Real cutoff, Real skin) {
+      if (myValid && positions == myPositions &&
+          topo->positionsVersion == myVersion && cutoff == myCutoff &&
+          skin == mySkin)
+        return false;
+
+      bool rebuild = needsRebuild(topo, positions, cutoff, skin);
+      if (rebuild)
+        build(topo, positions, cutoff, skin);
+      myPositions = positions;
+      myVersion = topo->positionsVersion;
+      return rebuild;
+    }
+
+    /// Marks the list as out of date, the next update() rebuilds it
+    void uncache() {myValid = false;}
+
+    /// Number of atoms covered by the list
+    unsigned int size() const {
+      return myStart.empty() ? 0 : myStart.size() - 1;
+    }
+    /// Total number of stored pairs, without the modified ones
+    unsigned int numberOfPairs() const {return myNeighbors.size() - 1;}
+    /// Total number of stored modified pairs
+    unsigned int numberOfModifiedPairs() const {return myModified.size() - 1;}
+    /// Number of (re)builds since construction
+    unsigned int numberOfBuilds() const {return myBuilds;}
+
+    /// Atom of row k
+    int atom(unsigned int k) const {return myOrder[k];}
+    /// First neighbor of row k
+    const int *begin(unsigned int k) const {
+      return &myNeighbors[0] + myStart[k];
+    }
+    /// One past the last neighbor of row k
+    const int *end(unsigned int k) const {
+      return &myNeighbors[0] + myStart[k + 1];
+    }
+    /// First modified neighbor of row k
+    const int *beginModified(unsigned int k) const {
+      return &myModified[0] + myModifiedStart[k];
+    }
+    /// One past the last modified neighbor of row k
+    const int *endModified(unsigned int k) const {
+      return &myModified[0] + myModifiedStart[k + 1];
+    }
+
+  private:
+    bool needsRebuild(const RealTopologyType *topo,
+                      const Vector3DBlock *positions,
+                      Real cutoff, Real skin) const {
+      if (!myValid || cutoff != myCutoff || skin != mySkin ||
+          positions->size() != myReference.size())
+        return true;
+
+      if (topo->boundaryConditions.PERIODIC &&
+          (topo->boundaryConditions.getMin() != myBoxMin ||
+           topo->boundaryConditions.getMax() != myBoxMax))
+        return true;
+
+      // Positions are not wrapped, so the plain difference is the
+      // displacement since the last build. The maximum over all atoms is
+      // taken in one branch-free pass over the component arrays.
+      const Vector3DBlockSoA &current = topo->getPositionsSoA(positions);
+      const Real *x = current.x(), *y = current.y(), *z = current.z();
+      const Real *x0 = myReference.x(), *y0 = myReference.y(),
+        *z0 = myReference.z();
+      const unsigned int count = current.paddedSize();
+      Real maxSquared = 0.0;
+      for (unsigned int i = 0; i < count; ++i) {
+        Real dx = x[i] - x0[i], dy = y[i] - y0[i], dz = z[i] - z0[i];
+        Real d2 = dx * dx + dy * dy + dz * dz;
+        maxSquared = (d2 > maxSquared ? d2 : maxSquared);
+      }
+
+      return maxSquared > 0.25 * skin * skin;
+    }
+
+    void build(const RealTopologyType *topo, const Vector3DBlock *positions,
+               Real cutoff, Real skin) {
+      const unsigned int count = positions->size();
+      const Real listCutoff = cutoff + skin;
+      const Real listCutoffSquared = listCutoff * listCutoff;
+
+      topo->updateCellLists(positions);
+      myEnumerator.initialize(topo, listCutoff);
+
+      // Collect all pairs within cutoff + skin, with the exclusions of
+      // the force kernels: only atoms of the same molecule are checked
+      myPairs.clear();
+      myModifiedPairs.clear();
+      CellPair thisPair;
+      for (; !myEnumerator.done(); myEnumerator.next()) {
+        myEnumerator.get(thisPair);
+        bool notSameCell = myEnumerator.notSameCell();
+
+        for (int i = thisPair.first; i != -1; i = topo->atoms[i].cellListNext)
+          for (int j = (notSameCell ? thisPair.second :
+                        topo->atoms[i].cellListNext);
+               j != -1; j = topo->atoms[j].cellListNext) {
+            Real distSquared;
+            topo->boundaryConditions.minimalDifference((*positions)[i],
+                                                       (*positions)[j],
+                                                       distSquared);
+            if (distSquared > listCutoffSquared)
+              continue;
+            ExclusionClass excl =
+              (topo->atoms[i].molecule == topo->atoms[j].molecule ?
+               topo->exclusions.check(i, j) : EXCLUSION_NONE);
+            if (excl == EXCLUSION_NONE)
+              myPairs.push_back(PairInt(i, j));
+            else if (excl == EXCLUSION_MODIFIED)
+              myModifiedPairs.push_back(PairInt(i, j));
+          }
+      }
+
+      // Row of each atom along the space-filling curve
+      spatialOrder(topo, positions, myOrder);
+      myRank.resize(count);
+      for (unsigned int k = 0; k < count; ++k)
+        myRank[myOrder[k]] = k;
+
+      compressRows(myPairs, myStart, myNeighbors);
+      compressRows(myModifiedPairs, myModifiedStart, myModified);
+
+      myReference.intoAssign(topo->getPositionsSoA(positions));
+      myBoxMin = topo->boundaryConditions.getMin();
+      myBoxMax = topo->boundaryConditions.getMax();
+      myCutoff = cutoff;
+      mySkin = skin;
+      myValid = true;
+      ++myBuilds;
+    }
+
+    /// Counting sort of pairs into compressed rows by the row of the
+    /// first atom, the neighbors of each row sorted by index
+    void compressRows(const std::vector<PairInt> &pairs,
+                      std::vector<unsigned int> &start,
+                      std::vector<int> &neighbors) const {
+      const unsigned int count = myRank.size();
+      start.assign(count + 1, 0);
+      for (unsigned int k = 0; k < pairs.size(); ++k)
+        ++start[myRank[pairs[k].first] + 1];
+      for (unsigned int i = 0; i < count; ++i)
+        start[i + 1] += start[i];
+
+      // One trailing sentinel keeps the row pointers valid for empty lists
+      neighbors.assign(pairs.size() + 1, -1);
+      std::vector<unsigned int> next(start.begin(), start.end() - 1);
+      for (unsigned int k = 0; k < pairs.size(); ++k)
+        neighbors[next[myRank[pairs[k].first]]++] = pairs[k].second;
+      for (unsigned int k = 0; k < count; ++k)
+        std::sort(neighbors.begin() + start[k], neighbors.begin() + start[k + 1]);
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    std::vector<int> myOrder;       // Atom of each row
+    std::vector<unsigned int> myRank; // Row of each atom
+    std::vector<unsigned int> myStart;
+    std::vector<int> myNeighbors;   // Pairs plus one trailing sentinel
+    std::vector<unsigned int> myModifiedStart;
+    std::vector<int> myModified;    // Modified pairs plus one sentinel
+    std::vector<PairInt> myPairs;   // Scratch space for the build
+    std::vector<PairInt> myModifiedPairs;
+    Vector3DBlockSoA myReference;   // Positions at the last build
+    Vector3D myBoxMin, myBoxMax;
+    Real myCutoff;
+    Real mySkin;
+    bool myValid;
+    unsigned int myBuilds;
+    const Vector3DBlock *myPositions; // Positions of the last update()
+    unsigned int myVersion;
+    EnumeratorType myEnumerator;
+  };
+}
+#endif /* VERLETLIST_H */
@@ -40,6 +40,15 @@ namespace ProtoMol {
   typedef float Real;
 #endif
 
+  /// Real number type of the pair kernels. With USE_MIXED_PRECISION the
+  /// kernels compute in float, while positions, forces and energies are
+  /// Real and accumulated as such.
+#if defined (USE_MIXED_PRECISION)
+  typedef float KernelReal;
+#else
+  typedef Real KernelReal;
+#endif
+
   inline Real RealAbs(Real x) {return x < 0 ? -x : x;}
 }
 #endif /*REAL_H*/
@@ -63,6 +63,8 @@ namespace ProtoMol {
       LASTREDUCE,           ///< Last value to be reduced in parallel
                             ///< environment, only internal purpose
       SHADOW = LASTREDUCE,
+      BORNRADIUS_ERROR,     ///< Estimated relative error of cached GB
+                            ///< Born radii
       LAST             // Only internal purpose
     };
     // Index of relevant scalares
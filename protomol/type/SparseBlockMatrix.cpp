@@ -0,0 +1,159 @@
+#include <protomol/type/SparseBlockMatrix.h>
+#include <protomol/type/Matrix3By3.h>
+
+#include <algorithm>
+
+using namespace std;
+using namespace ProtoMol;
+
+//____ SparseBlockMatrix
+
+SparseBlockMatrix::SparseBlockMatrix() : myBlockRows(0) {
+  myRowStart.push_back(0);
+}
+
+SparseBlockMatrix::SparseBlockMatrix(unsigned int blockRows) {
+  initialize(blockRows);
+}
+
+void SparseBlockMatrix::initialize(unsigned int blockRows) {
+  myBlockRows = blockRows;
+  myRowStart.resize(blockRows + 1);
+  myColumn.resize(blockRows);
+  for (unsigned int i = 0; i < blockRows; i++) {
+    myRowStart[i] = i;
+    myColumn[i] = i;
+  }
+  myRowStart[blockRows] = blockRows;
+  myValue.assign(9 * blockRows, 0.0);
+  myPending.clear();
+}
+
+void SparseBlockMatrix::clear() {
+  compress();
+  fill(myValue.begin(), myValue.end(), 0.0);
+}
+
+void SparseBlockMatrix::add(unsigned int i, unsigned int j,
+                            const Matrix3By3 &m, double factor) {
+  double *b = lookup(i, j);
+  if (b == 0)
+    b = queue(i, j).value;
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 3; c++)
+      b[3 * r + c] += factor * m(r, c);
+}
+
+void SparseBlockMatrix::add(unsigned int row, unsigned int column,
+                            double value) {
+  double *b = lookup(row / 3, column / 3);
+  if (b == 0)
+    b = queue(row / 3, column / 3).value;
+  b[3 * (row % 3) + column % 3] += value;
+}
+
+double *SparseBlockMatrix::lookup(unsigned int i, unsigned int j) {
+  vector<unsigned int>::iterator first = myColumn.begin() + myRowStart[i];
+  vector<unsigned int>::iterator last = myColumn.begin() + myRowStart[i + 1];
+  vector<unsigned int>::iterator k = lower_bound(first, last, j);
+  if (k == last || *k != j)
+    return 0;
+  return &myValue[9 * (k - myColumn.begin())];
+}
+
+SparseBlockMatrix::Pending &SparseBlockMatrix::queue(unsigned int i,
+                                                     unsigned int j) {
+  // Bound the queue by the size of the rows, duplicates are merged
+  if (myPending.size() > max(myColumn.size(), (size_t)1024))
+    compress();
+
+  Pending p;
+  p.row = i;
+  p.column = j;
+  fill(p.value, p.value + 9, 0.0);
+  myPending.push_back(p);
+  return myPending.back();
+}
+
+void SparseBlockMatrix::compress() {
+  if (myPending.empty())
+    return;
+
+  sort(myPending.begin(), myPending.end());
+
+  vector<unsigned int> rowStart(myBlockRows + 1);
+  vector<unsigned int> column;
+  vector<double> value;
+  column.reserve(myColumn.size() + myPending.size());
+  value.reserve(myValue.size() + 9 * myPending.size());
+
+  unsigned int p = 0;
+  for (unsigned int i = 0; i < myBlockRows; i++) {
+    rowStart[i] = column.size();
+    unsigned int k = myRowStart[i];
+    while (k < myRowStart[i + 1] ||
+           (p < myPending.size() && myPending[p].row == i)) {
+      const bool fromRow = k < myRowStart[i + 1] &&
+        (p == myPending.size() || myPending[p].row != i ||
+         myColumn[k] <= myPending[p].column);
+      const unsigned int j = fromRow ? myColumn[k] : myPending[p].column;
+      const double *b = fromRow ? &myValue[9 * k] : myPending[p].value;
+      if (fromRow)
+        k++;
+      else
+        p++;
+
+      if (column.size() > rowStart[i] && column.back() == j) {
+        double *d = &value[value.size() - 9];
+        for (int l = 0; l < 9; l++)
+          d[l] += b[l];
+      } else {
+        column.push_back(j);
+        value.insert(value.end(), b, b + 9);
+      }
+    }
+  }
+  rowStart[myBlockRows] = column.size();
+
+  myRowStart.swap(rowStart);
+  myColumn.swap(column);
+  myValue.swap(value);
+  vector<Pending>().swap(myPending);
+}
+
+void SparseBlockMatrix::multiply(const double *x, double *y) const {
+  for (unsigned int i = 0; i < myBlockRows; i++) {
+    double y0 = 0.0, y1 = 0.0, y2 = 0.0;
+    for (unsigned int k = myRowStart[i]; k < myRowStart[i + 1]; k++) {
+      const double *b = &myValue[9 * k];
+      const double *xj = x + 3 * myColumn[k];
+      y0 += b[0] * xj[0] + b[1] * xj[1] + b[2] * xj[2];
+      y1 += b[3] * xj[0] + b[4] * xj[1] + b[5] * xj[2];
+      y2 += b[6] * xj[0] + b[7] * xj[1] + b[8] * xj[2];
+    }
+    y[3 * i] = y0;
+    y[3 * i + 1] = y1;
+    y[3 * i + 2] = y2;
+  }
+}
+
+void SparseBlockMatrix::scale(double s) {
+  compress();
+  for (unsigned int k = 0; k < myValue.size(); k++)
+    myValue[k] *= s;
+}
+
+const double *SparseBlockMatrix::find(unsigned int i, unsigned int j) const {
+  return const_cast<SparseBlockMatrix *>(this)->lookup(i, j);
+}
+
+double SparseBlockMatrix::operator()(unsigned int row,
+                                     unsigned int column) const {
+  const double *b = find(row / 3, column / 3);
+  return b == 0 ? 0.0 : b[3 * (row % 3) + column % 3];
+}
+
+unsigned int SparseBlockMatrix::memory() const {
+  return myValue.size() * sizeof(double) +
+    (myColumn.size() + myRowStart.size()) * sizeof(unsigned int);
+}
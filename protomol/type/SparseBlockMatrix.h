@@ -0,0 +1,105 @@
+/*  -*- c++ -*-  */
+#ifndef SPARSEBLOCKMATRIX_H
+#define SPARSEBLOCKMATRIX_H
+
+#include <vector>
+
+namespace ProtoMol {
+  class Matrix3By3;
+
+  //____ SparseBlockMatrix
+
+  /**
+   * Square matrix of 3x3 blocks in block compressed sparse row (BSR)
+   * storage, block (i, j) couples atom i with atom j. Only the blocks of
+   * interacting atom pairs are stored, hence bonded and cutoff Hessians of N
+   * atoms need O(N) instead of 9N^2 doubles.
+   *
+   * Assembly adds to existing blocks in place, new blocks are queued and
+   * merged into the rows by compress(), which must be called before
+   * products or look ups. The pattern is kept by clear(), such that
+   * repeated assemblies of the same system do not allocate. The diagonal
+   * blocks are always present.
+   */
+  class SparseBlockMatrix {
+    /// Queued block, not yet in the rows
+    struct Pending {
+      unsigned int row, column;
+      double value[9];
+
+      bool operator<(const Pending &p) const {
+        return row < p.row || (row == p.row && column < p.column);
+      }
+    };
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    SparseBlockMatrix();
+    explicit SparseBlockMatrix(unsigned int blockRows);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class SparseBlockMatrix
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    /// blockRows x blockRows blocks holding the diagonal only
+    void initialize(unsigned int blockRows);
+
+    /// Zeros all blocks, the pattern is kept
+    void clear();
+
+    /// Adds factor * m to block (i, j)
+    void add(unsigned int i, unsigned int j, const Matrix3By3 &m,
+             double factor = 1.0);
+
+    /// Adds value to the element (row, column), counted in doubles
+    void add(unsigned int row, unsigned int column, double value);
+
+    /// Merges the queued blocks into the rows
+    void compress();
+
+    /// y = A x, x and y of size() doubles
+    void multiply(const double *x, double *y) const;
+
+    /// A *= s
+    void scale(double s);
+
+    /// Block (i, j) as 9 doubles in row major order, 0 if not stored
+    const double *find(unsigned int i, unsigned int j) const;
+
+    /// Element (row, column), counted in doubles
+    double operator()(unsigned int row, unsigned int column) const;
+
+    /// Number of rows (and columns) in doubles
+    unsigned int size() const {return 3 * myBlockRows;}
+    unsigned int blockRows() const {return myBlockRows;}
+
+    /// Number of stored blocks
+    unsigned int blocks() const {return myColumn.size();}
+
+    /// Memory of the stored blocks and their indices in bytes
+    unsigned int memory() const;
+
+    /// First block of block row i, the blocks of row i are
+    /// [rowStart(i), rowStart(i + 1))
+    unsigned int rowStart(unsigned int i) const {return myRowStart[i];}
+    unsigned int column(unsigned int k) const {return myColumn[k];}
+    const double *block(unsigned int k) const {return &myValue[9 * k];}
+
+  private:
+    double *lookup(unsigned int i, unsigned int j);
+    Pending &queue(unsigned int i, unsigned int j);
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    unsigned int myBlockRows;
+    std::vector<unsigned int> myRowStart; ///< blockRows + 1 offsets
+    std::vector<unsigned int> myColumn;   ///< Block column of each block
+    std::vector<double> myValue;          ///< 9 doubles per block
+    std::vector<Pending> myPending;
+  };
+}
+#endif /* SPARSEBLOCKMATRIX_H */
@@ -0,0 +1,193 @@
+/*  -*- c++ -*-  */
+#ifndef VECTOR3DBLOCKSOA_H
+#define VECTOR3DBLOCKSOA_H
+
+#include <cstddef>
+#include <protomol/type/Vector3DBlock.h>
+
+namespace ProtoMol {
+  //__________________________________________________________ Vector3DBlockSoA
+  /**
+   * Structure-of-arrays counterpart of Vector3DBlock, holding the x, y and
+   * z components in three separate arrays. Each array starts on an
+   * ALIGNMENT byte boundary and is padded with zeros to a multiple of WIDTH
+   * elements, such that kernels can use aligned full-width vector loads and
+   * stores over the whole padded range.
+   *
+   * Conversion from and to Vector3DBlock is explicit (intoAssign(),
+   * assignTo(), addTo()), it is meant to be done once per force evaluation
+   * and not per pair.
+   */
+  class Vector3DBlockSoA {
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Types & enum's
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    /// Alignment of each component array in bytes (AVX-512)
+    enum {ALIGNMENT = 64};
+    /// Padding of each component array in elements
+    enum {WIDTH = ALIGNMENT / sizeof(Real)};
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Constructors, destructors, assignment
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    Vector3DBlockSoA() : myData(0), mySize(0), myPaddedSize(0) {
+      myC[0] = myC[1] = myC[2] = 0;
+    }
+
+    explicit Vector3DBlockSoA(unsigned int n) :
+      myData(0), mySize(0), myPaddedSize(0) {
+      myC[0] = myC[1] = myC[2] = 0;
+      resize(n);
+    }
+
+    explicit Vector3DBlockSoA(const Vector3DBlock &rhs) :
+      myData(0), mySize(0), myPaddedSize(0) {
+      myC[0] = myC[1] = myC[2] = 0;
+      intoAssign(rhs);
+    }
+
+    Vector3DBlockSoA(const Vector3DBlockSoA &rhs) :
+      myData(0), mySize(0), myPaddedSize(0) {
+      myC[0] = myC[1] = myC[2] = 0;
+      intoAssign(rhs);
+    }
+
+    Vector3DBlockSoA &operator=(const Vector3DBlockSoA &rhs) {
+      return intoAssign(rhs);
+    }
+
+    ~Vector3DBlockSoA() {delete [] myData;}
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // New methods of class Vector3DBlockSoA
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  public:
+    unsigned int size() const {return mySize;}
+    bool empty() const {return mySize == 0;}
+    /// Length of each component array including the padding
+    unsigned int paddedSize() const {return myPaddedSize;}
+
+    Real *x() {return myC[0];}
+    Real *y() {return myC[1];}
+    Real *z() {return myC[2];}
+    const Real *x() const {return myC[0];}
+    const Real *y() const {return myC[1];}
+    const Real *z() const {return myC[2];}
+
+    Vector3D operator[](unsigned int n) const {
+      return Vector3D(myC[0][n], myC[1][n], myC[2][n]);
+    }
+
+    void set(unsigned int n, const Vector3D &v) {
+      myC[0][n] = v.c[0];
+      myC[1][n] = v.c[1];
+      myC[2][n] = v.c[2];
+    }
+
+    /// Resizes to n elements, the old content is lost and set to zero
+    void resize(unsigned int n) {
+      unsigned int padded = ((n + WIDTH - 1) / WIDTH) * WIDTH;
+      if (padded != myPaddedSize) {
+        delete [] myData;
+        myData = 0;
+        myC[0] = myC[1] = myC[2] = 0;
+        if (padded > 0) {
+          // Over-allocate by one alignment unit and align by hand
+          myData = new Real[3 * padded + WIDTH];
+          std::size_t offset =
+            reinterpret_cast<std::size_t>(myData) % ALIGNMENT;
+          Real *base = myData;
+          if (offset != 0)
+            base += (ALIGNMENT - offset) / sizeof(Real);
+          myC[0] = base;
+          myC[1] = base + padded;
+          myC[2] = base + 2 * padded;
+        }
+        myPaddedSize = padded;
+      }
+      mySize = n;
+      zero();
+    }
+
+    /// Clear (set to zero) each element including the padding.
+    void zero() {
+      const unsigned int count = 3 * myPaddedSize;
+      Real *c = myC[0];
+      for (unsigned int i = 0; i < count; ++i)
+        c[i] = 0.0;
+    }
+
+    Vector3DBlockSoA &intoAssign(const Vector3DBlockSoA &x) {
+      if (this == &x) return *this;
+      if (size() != x.size()) resize(x.size());
+      const unsigned int count = 3 * myPaddedSize;
+      const Real *src = x.myC[0];
+      Real *c = myC[0];
+      for (unsigned int i = 0; i < count; ++i)
+        c[i] = src[i];
+      return *this;
+    }
+
+    /// Copies a Vector3DBlock into the component arrays.
+    Vector3DBlockSoA &intoAssign(const Vector3DBlock &x) {
+      if (size() != x.size()) resize(x.size());
+      const Real *c = x.c;
+      for (unsigned int i = 0; i < mySize; ++i) {
+        myC[0][i] = c[3 * i];
+        myC[1][i] = c[3 * i + 1];
+        myC[2][i] = c[3 * i + 2];
+      }
+      return *this;
+    }
+
+    /// Copies the component arrays into a Vector3DBlock of the same size.
+    void assignTo(Vector3DBlock &x) const {
+      Real *c = x.c;
+      for (unsigned int i = 0; i < mySize; ++i) {
+        c[3 * i] = myC[0][i];
+        c[3 * i + 1] = myC[1][i];
+        c[3 * i + 2] = myC[2][i];
+      }
+    }
+
+    /// Adds the component arrays into a Vector3DBlock of the same size.
+    void addTo(Vector3DBlock &x) const {
+      Real *c = x.c;
+      for (unsigned int i = 0; i < mySize; ++i) {
+        c[3 * i] += myC[0][i];
+        c[3 * i + 1] += myC[1][i];
+        c[3 * i + 2] += myC[2][i];
+      }
+    }
+
+    void swap(Vector3DBlockSoA &x) {
+      Real *tmp = myData;
+      myData = x.myData;
+      x.myData = tmp;
+      for (unsigned int k = 0; k < 3; ++k) {
+        tmp = myC[k];
+        myC[k] = x.myC[k];
+        x.myC[k] = tmp;
+      }
+      unsigned int n = mySize;
+      mySize = x.mySize;
+      x.mySize = n;
+      n = myPaddedSize;
+      myPaddedSize = x.myPaddedSize;
+      x.myPaddedSize = n;
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // My data members
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  private:
+    Real *myData;     // Allocation, myC[0] is the aligned start within it
+    Real *myC[3];
+    unsigned int mySize;
+    unsigned int myPaddedSize;
+  };
+}
+
+#endif /* VECTOR3DBLOCKSOA_H */
@@ -0,0 +1,83 @@
+#!/usr/bin/python
+
+import os
+import sys
+import argparse
+import logging
+
+def read_column(flname, column):
+    """
+....Reads the time and the given column of an allenergies file. The column
+....is looked up in the .header file next to it, if any, else E_total is
+....taken to be the fourth column. Values may be written as hex floats.
+...."""
+
+    index = 3
+    header = flname + '.header'
+    if os.path.exists(header):
+        names = open(header).readline().split()
+        if column not in names:
+            raise Exception(column + ' is not a column of ' + flname)
+        index = names.index(column)
+
+    times = []
+    values = []
+    for ln in open(flname):
+        elements = ln.split()
+        if len(elements) <= index:
+            continue
+        times.append(to_float(elements[0]))
+        values.append(to_float(elements[index]))
+    return (times, values)
+
+
+def to_float(s):
+    if s.lower().find('0x') != -1:
+        return float.fromhex(s)
+    return float(s)
+
+
+def drift(times, values):
+    """
+....Least squares slope of values over times, per ps (times are in fs),
+....and the largest deviation from the first value.
+...."""
+
+    n = len(times)
+    if n < 2:
+        raise Exception('At least two energies are needed for a drift')
+    mt = sum(times) / n
+    mv = sum(values) / n
+    stt = sum([(t - mt) * (t - mt) for t in times])
+    stv = sum([(t - mt) * (v - mv) for (t, v) in zip(times, values)])
+    slope = stv / stt * 1000.0
+    deviation = max([abs(v - values[0]) for v in values])
+    return (slope, deviation)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Energy drift comparison of two runs, e.g., of the mixed precision against the double precision build')
+    parser.add_argument('original', help='Energy file of the reference run')
+    parser.add_argument('new', help='Energy file of the run to validate')
+    parser.add_argument('tolerance', type=float, help='Largest allowed difference of the drifts in kcal/mol/ps')
+    parser.add_argument('--column', default='E_total', help='Energy column to compare')
+    parser.add_argument('--verbose', '-v', action='store_true', default=False, help='Verbose output')
+
+    args = parser.parse_args()
+
+    level = logging.INFO
+    if args.verbose:
+        level = logging.DEBUG
+    logging.basicConfig(level=level, format='%(message)s')
+
+    (times, values) = read_column(args.original, args.column)
+    (slopeOriginal, deviationOriginal) = drift(times, values)
+    (times, values) = read_column(args.new, args.column)
+    (slopeNew, deviationNew) = drift(times, values)
+
+    logging.info('%s drift: %g kcal/mol/ps, largest deviation %g kcal/mol' % (args.original, slopeOriginal, deviationOriginal))
+    logging.info('%s drift: %g kcal/mol/ps, largest deviation %g kcal/mol' % (args.new, slopeNew, deviationNew))
+
+    if abs(slopeNew - slopeOriginal) > args.tolerance:
+        logging.warning('Drifts differ by %g kcal/mol/ps' % abs(slopeNew - slopeOriginal))
+        sys.exit(1)
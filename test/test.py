@@ -42,7 +42,7 @@ def parse_params(flname):
     return params
 
 
-def run_test(protomol_path, conf_file, pwd, parallel):
+def run_test(protomol_path, conf_file, pwd, parallel, mpi):
     tests = 0
     testspassed = 0
     testsfailed = 0
@@ -51,6 +51,12 @@ def run_test(protomol_path, conf_file, pwd, parallel):
     conf_param_overrides = parse_params(conf_file)
     epsilon = conf_param_overrides.get('epsilon', DEFAULT_EPSILON)
     scaling_factor = conf_param_overrides.get('scaling_factor', DEFAULT_SCALINGFACTOR)
+    # Tests of parallel modes run on their number of processes with MPI
+    processes = conf_param_overrides.get('processes', 1)
+    if parallel:
+        processes = 2
+    elif not mpi:
+        processes = 1
 
     base = os.path.splitext(os.path.basename(conf_file))[0]
     if not parallel:
@@ -59,10 +65,10 @@ def run_test(protomol_path, conf_file, pwd, parallel):
         logging.info('Executing Parallel Test: ' + base)
 
     cmd = []
-    if parallel:
+    if processes > 1:
         cmd.append('mpirun')
         cmd.append('-np')
-        cmd.append('2')
+        cmd.append(str(processes))
     cmd.append(protomol_path)
     cmd.append(conf_file)
 
@@ -136,6 +142,12 @@ def find_conf_files(pwd, args):
     return files
 
 
+def has_mpi(protomol_path):
+    p = subprocess.Popen(protomol_path, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    (stdout, stderr) = p.communicate()
+    return "No MPI compilation" not in stderr
+
+
 def find_protomol(pwd):
     if os.path.exists(os.path.join(pwd, 'ProtoMol')):
         return os.path.join(pwd, 'ProtoMol')
@@ -168,12 +180,10 @@ if __name__ == '__main__':
     logging.debug('Files: ' + str(files))
 
     protomol_path = find_protomol(pwd)
-    if args.parallel:
-        p = subprocess.Popen(protomol_path, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
-        (stdout, stderr) = p.communicate()
-        if "No MPI compilation" in stderr:
-            logging.critical("Parallel tests unavailable. Please recompile ProtoMol with MPI support.")
-            sys.exit(1)
+    mpi = has_mpi(protomol_path)
+    if args.parallel and not mpi:
+        logging.critical("Parallel tests unavailable. Please recompile ProtoMol with MPI support.")
+        sys.exit(1)
 
     tests = 0
     testspassed = 0
@@ -182,13 +192,13 @@ if __name__ == '__main__':
 
     for conf_file in files:
         if args.serial:
-            results = run_test(protomol_path, conf_file, pwd, False)
+            results = run_test(protomol_path, conf_file, pwd, False, mpi)
             tests += results[0]
             testspassed += results[1]
             testsfailed += results[2]
             failedtests.extend(results[3])
         if args.parallel:
-            results = run_test(protomol_path, conf_file, pwd, True)
+            results = run_test(protomol_path, conf_file, pwd, True, mpi)
             tests += results[0]
             testspassed += results[1]
             testsfailed += results[2]